@@ -5,9 +5,31 @@
 #include "collectionmodel.h"
 #include "importexportmanager.h"
 #include "secretserviceclient.h"
+#include "tracing.h"
 #include <KConfigGroup>
 #include <KSharedConfig>
 #include <QQuickWindow>
+#include <memory>
+
+// Only called with tracing enabled: the names have to be literals
+static void traceModel(QAbstractItemModel *model, const char *resetName, const char *insertName, const char *removeName)
+{
+    auto resetStart = std::make_shared<qint64>(-1);
+    QObject::connect(model, &QAbstractItemModel::modelAboutToBeReset, model, [resetStart]() {
+        *resetStart = Tracing::now();
+    });
+    QObject::connect(model, &QAbstractItemModel::modelReset, model, [resetStart, resetName]() {
+        if (*resetStart >= 0) {
+            Tracing::complete(resetName, "model", *resetStart);
+        }
+    });
+    QObject::connect(model, &QAbstractItemModel::rowsInserted, model, [insertName]() {
+        Tracing::instant(insertName, "model");
+    });
+    QObject::connect(model, &QAbstractItemModel::rowsRemoved, model, [removeName]() {
+        Tracing::instant(removeName, "model");
+    });
+}
 
 App::App(QObject *parent)
     : QObject(parent)
@@ -16,12 +38,24 @@ App::App(QObject *parent)
     m_collectionsModel = new CollectionsModel(m_secretServiceClient, this);
     m_collectionModel = new CollectionModel(m_secretServiceClient, this);
     m_secretItemProxy = new SecretItemProxy(m_secretServiceClient, this);
+    m_searchModel = new SearchModel(m_secretServiceClient, this);
 
-    m_secretItemForContextMenu = new SecretItemProxy(m_secretServiceClient, this);
-    m_importExportManager = new ImportExportManager(this);
+    // The last collection the user had open, the model falls back to the first one
+    KConfigGroup windowGroup(KSharedConfig::openStateConfig(), QStringLiteral("MainWindow"));
+    m_collectionModel->setCollectionPath(windowGroup.readEntry(QStringLiteral("CurrentCollectionPath"), QString()));
     m_collectionsModel->setCollectionPath(m_collectionModel->collectionPath());
 
     connect(m_collectionModel, &CollectionModel::collectionPathChanged, m_collectionsModel, &CollectionsModel::setCollectionPath);
+    connect(m_collectionModel, &CollectionModel::collectionPathChanged, this, [](const QString &collectionPath) {
+        KConfigGroup windowGroup(KSharedConfig::openStateConfig(), QStringLiteral("MainWindow"));
+        windowGroup.writeEntry(QStringLiteral("CurrentCollectionPath"), collectionPath);
+    });
+
+    if (Tracing::isEnabled()) {
+        traceModel(m_collectionModel, "CollectionModel reset", "CollectionModel rows inserted", "CollectionModel rows removed");
+        traceModel(m_collectionsModel, "CollectionsModel reset", "CollectionsModel rows inserted", "CollectionsModel rows removed");
+        traceModel(m_searchModel, "SearchModel reset", "SearchModel rows inserted", "SearchModel rows removed");
+    }
 }
 
 App::~App()
@@ -38,6 +72,11 @@ StateTracker *App::stateTracker() const
     return StateTracker::instance();
 }
 
+ClipboardManager *App::clipboardManager() const
+{
+    return ClipboardManager::instance();
+}
+
 CollectionsModel *App::collectionsModel() const
 {
     return m_collectionsModel;
@@ -53,16 +92,62 @@ SecretItemProxy *App::secretItem() const
     return m_secretItemProxy;
 }
 
-SecretItemProxy *App::secretItemForContextMenu() const
+SearchModel *App::searchModel() const
 {
+    return m_searchModel;
+}
+
+SecretItemProxy *App::secretItemForContextMenu()
+{
+    if (!m_secretItemForContextMenu) {
+        Tracing::Scope scope("Create secretItemForContextMenu", "qml");
+        m_secretItemForContextMenu = new SecretItemProxy(m_secretServiceClient, this);
+        Q_EMIT lazyObjectCreated();
+    }
     return m_secretItemForContextMenu;
 }
 
-ImportExportManager *App::importExportManager() const
+bool App::isSecretItemForContextMenuCreated() const
+{
+    return m_secretItemForContextMenu != nullptr;
+}
+
+ImportExportManager *App::importExportManager()
 {
+    if (!m_importExportManager) {
+        Tracing::Scope scope("Create importExportManager", "qml");
+        m_importExportManager = new ImportExportManager(m_secretServiceClient, this);
+
+        // Parsing of imported files waits for the writes to catch up
+        connect(m_collectionModel, &CollectionModel::importProgress, m_importExportManager, [this](int done, int total) {
+            m_importExportManager->setImportBacklog(total - done);
+        });
+        connect(m_importExportManager, &ImportExportManager::importCancelled, m_collectionModel, &CollectionModel::cancelImport);
+        // The chunks of a file are a single import, which ends with the file
+        connect(m_importExportManager, &ImportExportManager::importSucceeded, m_collectionModel, &CollectionModel::endImport);
+        connect(m_importExportManager, &ImportExportManager::errorOccurred, m_collectionModel, &CollectionModel::endImport);
+        Q_EMIT lazyObjectCreated();
+    }
     return m_importExportManager;
 }
 
+bool App::isImportExportManagerCreated() const
+{
+    return m_importExportManager != nullptr;
+}
+
+LatencyStats *App::latencyStats() const
+{
+    return LatencyStats::instance();
+}
+
+void App::tracePageLoaded(const QString &pageName) const
+{
+    if (Tracing::isEnabled()) {
+        Tracing::instant(Tracing::intern(pageName + QStringLiteral(" loaded")), "qml");
+    }
+}
+
 QString App::sidebarState() const
 {
     KConfigGroup windowGroup(KSharedConfig::openStateConfig(), QStringLiteral("MainWindow"));
@@ -5,10 +5,13 @@
 
 #include <QObject>
 
+#include "clipboardmanager.h"
 #include "collectionmodel.h"
 #include "collectionsmodel.h"
 #include "importexportmanager.h"
+#include "latencystats.h"
 #include "secretitemproxy.h"
+#include "searchmodel.h"
 #include "secretserviceclient.h"
 #include "statetracker.h"
 
@@ -22,11 +25,18 @@ class App : public QObject
 
     Q_PROPERTY(SecretServiceClient *secretService READ secretService CONSTANT)
     Q_PROPERTY(StateTracker *stateTracker READ stateTracker CONSTANT)
+    Q_PROPERTY(ClipboardManager *clipboardManager READ clipboardManager CONSTANT)
     Q_PROPERTY(CollectionsModel *collectionsModel READ collectionsModel CONSTANT)
     Q_PROPERTY(CollectionModel *collectionModel READ collectionModel CONSTANT)
     Q_PROPERTY(SecretItemProxy *secretItem READ secretItem CONSTANT)
+    // Over all the collections, empty until it has a query
+    Q_PROPERTY(SearchModel *searchModel READ searchModel CONSTANT)
+    // Created on first use, which bindings can avoid by checking the Created properties first
     Q_PROPERTY(SecretItemProxy *secretItemForContextMenu READ secretItemForContextMenu CONSTANT)
+    Q_PROPERTY(bool secretItemForContextMenuCreated READ isSecretItemForContextMenuCreated NOTIFY lazyObjectCreated)
     Q_PROPERTY(ImportExportManager *importExportManager READ importExportManager CONSTANT)
+    Q_PROPERTY(bool importExportManagerCreated READ isImportExportManagerCreated NOTIFY lazyObjectCreated)
+    Q_PROPERTY(LatencyStats *latencyStats READ latencyStats CONSTANT)
     Q_PROPERTY(QString sidebarState READ sidebarState WRITE setSidebarState NOTIFY sidebarStateChanged)
 
 public:
@@ -35,23 +45,35 @@ public:
 
     SecretServiceClient *secretService() const;
     StateTracker *stateTracker() const;
+    ClipboardManager *clipboardManager() const;
     CollectionsModel *collectionsModel() const;
     CollectionModel *collectionModel() const;
     SecretItemProxy *secretItem() const;
-    SecretItemProxy *secretItemForContextMenu() const;
+    SearchModel *searchModel() const;
+    // Not const, they are created on first use
+    SecretItemProxy *secretItemForContextMenu();
+    bool isSecretItemForContextMenuCreated() const;
+
+    ImportExportManager *importExportManager();
+    bool isImportExportManagerCreated() const;
+    LatencyStats *latencyStats() const;
+    // For Tracing, called by the pages when created
+    Q_INVOKABLE void tracePageLoaded(const QString &pageName) const;
 
-    ImportExportManager *importExportManager() const;
     QString sidebarState() const;
     void setSidebarState(const QString &state);
 
 Q_SIGNALS:
     void sidebarStateChanged();
+    void lazyObjectCreated();
 
 private:
     SecretServiceClient *m_secretServiceClient = nullptr;
     CollectionsModel *m_collectionsModel = nullptr;
     CollectionModel *m_collectionModel = nullptr;
     SecretItemProxy *m_secretItemProxy = nullptr;
+    SearchModel *m_searchModel = nullptr;
+    // Not needed for the first frame
     SecretItemProxy *m_secretItemForContextMenu = nullptr;
     ImportExportManager *m_importExportManager = nullptr;
 };
@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "backupjournal.h"
+#include "binarybackup.h"
+
+#include <QDataStream>
+#include <QIODevice>
+#include <QtEndian>
+
+#include <algorithm>
+
+static constexpr char s_magic[] = "KSJOURNL";
+static constexpr qint64 s_magicSize = 8;
+static constexpr quint16 s_version = 1;
+static constexpr qint64 s_headerSize = s_magicSize + 2 * sizeof(quint16);
+static constexpr qint64 s_recordHeaderSize = sizeof(quint8) + sizeof(quint32);
+// Refuse records bigger than this, rather than allocating whatever a corrupted size says
+static constexpr quint32 s_maxRecordSize = 64 * 1024 * 1024;
+
+enum RecordType : quint8 {
+    SessionRecord = 1,
+    ItemRecord,
+    TombstoneRecord,
+    CommitRecord,
+};
+
+using BinaryBackup::setupStream;
+
+bool BackupJournal::isJournal(QIODevice *device)
+{
+    return device->peek(s_magicSize) == QByteArray(s_magic, s_magicSize);
+}
+
+BackupJournalWriter::BackupJournalWriter(QIODevice *device)
+    : m_device(device)
+{
+    if (m_device->pos() > 0) {
+        return;
+    }
+
+    QByteArray header(s_magic, s_magicSize);
+    header.resize(s_headerSize);
+    qToBigEndian<quint16>(s_version, header.data() + s_magicSize);
+    qToBigEndian<quint16>(0, header.data() + s_magicSize + sizeof(quint16));
+    m_error = m_device->write(header) != header.size();
+}
+
+void BackupJournalWriter::writeRecord(quint8 type, const QByteArray &payload)
+{
+    if (m_error) {
+        return;
+    }
+
+    char recordHeader[s_recordHeaderSize];
+    recordHeader[0] = char(type);
+    qToBigEndian<quint32>(payload.size(), recordHeader + 1);
+
+    m_error = m_device->write(recordHeader, s_recordHeaderSize) != s_recordHeaderSize || m_device->write(payload) != payload.size();
+}
+
+void BackupJournalWriter::beginSession(quint64 backupPoint, const QString &walletName)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    setupStream(stream);
+    stream << backupPoint << walletName;
+    writeRecord(SessionRecord, payload);
+}
+
+void BackupJournalWriter::writeItem(const QVariantMap &item)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    setupStream(stream);
+    stream << item.value(QStringLiteral("dbusPath")).toString() << item.value(QStringLiteral("modified")).toULongLong();
+    BinaryBackup::writeItemFields(stream, item);
+
+    writeRecord(ItemRecord, payload);
+    payload.fill(0);
+}
+
+void BackupJournalWriter::writeRawItem(const QByteArray &payload)
+{
+    writeRecord(ItemRecord, payload);
+}
+
+void BackupJournalWriter::writeTombstone(const QString &dbusPath)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    setupStream(stream);
+    stream << dbusPath;
+    writeRecord(TombstoneRecord, payload);
+}
+
+void BackupJournalWriter::commit(quint64 backupPoint)
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    setupStream(stream);
+    stream << backupPoint;
+    writeRecord(CommitRecord, payload);
+}
+
+bool BackupJournalWriter::hasError() const
+{
+    return m_error;
+}
+
+BackupJournalReader::BackupJournalReader(QIODevice *device)
+    : m_device(device)
+{
+    if (!replay()) {
+        m_live.clear();
+        m_order.clear();
+    }
+}
+
+void BackupJournalReader::setError(const QString &message)
+{
+    m_error = message;
+    m_atEnd = true;
+}
+
+bool BackupJournalReader::replay()
+{
+    const QByteArray header = m_device->read(s_headerSize);
+    if (header.size() != s_headerSize || !header.startsWith(QByteArray(s_magic, s_magicSize))) {
+        setError(QStringLiteral("Not a valid KeepSecret backup journal."));
+        return false;
+    }
+    if (qFromBigEndian<quint16>(header.constData() + s_magicSize) > s_version) {
+        setError(QStringLiteral("This journal was written by a newer version of KeepSecret."));
+        return false;
+    }
+    m_committedSize = s_headerSize;
+
+    // Changes of the session being read, applied only once it's committed
+    bool inSession = false;
+    QString sessionWallet;
+    QHash<QString, qint64> sessionItems;
+    QStringList sessionTombstones;
+
+    while (true) {
+        const qint64 offset = m_device->pos();
+        const QByteArray recordHeader = m_device->read(s_recordHeaderSize);
+        if (recordHeader.size() != s_recordHeaderSize) {
+            // End of file, or the tail of an interrupted session
+            break;
+        }
+
+        const quint8 type = quint8(recordHeader[0]);
+        const quint32 size = qFromBigEndian<quint32>(recordHeader.constData() + 1);
+        if (size > s_maxRecordSize) {
+            break;
+        }
+        QByteArray payload = m_device->read(size);
+        if (payload.size() != qsizetype(size)) {
+            break;
+        }
+
+        QDataStream stream(payload);
+        setupStream(stream);
+
+        if (type == SessionRecord) {
+            quint64 backupPoint = 0;
+            stream >> backupPoint >> sessionWallet;
+            inSession = true;
+            sessionItems.clear();
+            sessionTombstones.clear();
+        } else if (type == ItemRecord && inSession) {
+            QString dbusPath;
+            stream >> dbusPath;
+            sessionItems[dbusPath] = offset;
+            sessionTombstones.removeAll(dbusPath);
+        } else if (type == TombstoneRecord && inSession) {
+            QString dbusPath;
+            stream >> dbusPath;
+            sessionItems.remove(dbusPath);
+            sessionTombstones << dbusPath;
+        } else if (type == CommitRecord && inSession) {
+            quint64 backupPoint = 0;
+            stream >> backupPoint;
+            if (stream.status() != QDataStream::Ok) {
+                break;
+            }
+            for (const QString &dbusPath : std::as_const(sessionTombstones)) {
+                m_live.remove(dbusPath);
+            }
+            m_live.insert(sessionItems);
+            m_lastBackupPoint = backupPoint;
+            m_walletName = sessionWallet;
+            m_committedSize = m_device->pos();
+            inSession = false;
+        }
+        payload.fill(0);
+
+        if (stream.status() != QDataStream::Ok) {
+            break;
+        }
+    }
+
+    // Restore in the order the items were written
+    m_order = m_live.keys();
+    std::sort(m_order.begin(), m_order.end(), [this](const QString &a, const QString &b) {
+        return m_live.value(a) < m_live.value(b);
+    });
+
+    return true;
+}
+
+QByteArray BackupJournalReader::readRecordAt(qint64 offset, quint8 expectedType)
+{
+    if (!m_device->seek(offset)) {
+        setError(QStringLiteral("Cannot read the backup journal."));
+        return QByteArray();
+    }
+
+    const QByteArray recordHeader = m_device->read(s_recordHeaderSize);
+    const quint32 size = recordHeader.size() == s_recordHeaderSize ? qFromBigEndian<quint32>(recordHeader.constData() + 1) : 0;
+    QByteArray payload = m_device->read(size);
+
+    if (recordHeader.size() != s_recordHeaderSize || quint8(recordHeader[0]) != expectedType || payload.size() != qsizetype(size)) {
+        setError(QStringLiteral("The backup journal is corrupted."));
+        payload.fill(0);
+        return QByteArray();
+    }
+    return payload;
+}
+
+QByteArray BackupJournalReader::rawItemRecord(const QString &dbusPath)
+{
+    const auto it = m_live.constFind(dbusPath);
+    if (it == m_live.constEnd()) {
+        return QByteArray();
+    }
+    return readRecordAt(*it, ItemRecord);
+}
+
+QVariantList BackupJournalReader::readItems(int maxItems)
+{
+    QVariantList items;
+
+    while (items.count() < maxItems && !m_atEnd) {
+        if (m_next >= m_order.count()) {
+            m_atEnd = true;
+            break;
+        }
+
+        const QString dbusPath = m_order[m_next++];
+        QByteArray payload = readRecordAt(m_live.value(dbusPath), ItemRecord);
+        if (payload.isEmpty()) {
+            break;
+        }
+
+        QDataStream stream(payload);
+        setupStream(stream);
+        QString path;
+        quint64 modified = 0;
+        stream >> path >> modified;
+
+        QVariantMap item;
+        const bool ok = BinaryBackup::readItemFields(stream, &item);
+        payload.fill(0);
+        if (!ok) {
+            setError(QStringLiteral("The backup journal is corrupted."));
+            break;
+        }
+        item[QStringLiteral("wallet")] = m_walletName;
+        items.append(item);
+    }
+
+    if (hasError()) {
+        items.clear();
+    }
+    return items;
+}
+
+bool BackupJournalReader::atEnd() const
+{
+    return m_atEnd;
+}
+
+QString BackupJournalReader::errorString() const
+{
+    return m_error;
+}
+
+quint64 BackupJournalReader::lastBackupPoint() const
+{
+    return m_lastBackupPoint;
+}
+
+QString BackupJournalReader::walletName() const
+{
+    return m_walletName;
+}
+
+QStringList BackupJournalReader::livePaths() const
+{
+    return m_order;
+}
+
+qint64 BackupJournalReader::committedSize() const
+{
+    return m_committedSize;
+}
@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "itemreader.h"
+
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+class QIODevice;
+
+/**
+ * Append-only journal of incremental backups. Integers are big endian,
+ * everything else is serialized like in BinaryBackupWriter.
+ *
+ * header:  "KSJOURNL" quint16 version, quint16 flags
+ * records: quint8 type, quint32 payload size, payload
+ *          - Session: backup point, wallet name
+ *          - Item: dbus path, modification time, then the item fields
+ *          - Tombstone: dbus path of a deleted item
+ *          - Commit: backup point
+ *
+ * Every backup appends a session with the items modified since the previous
+ * backup point and the tombstones of the deleted ones. A session counts only
+ * once its commit record is written: an interrupted backup leaves no trace.
+ * Compaction rewrites the journal with a single session holding the latest
+ * version of every item still alive.
+ */
+namespace BackupJournal
+{
+// True if the device starts with the journal magic, doesn't consume any data
+bool isJournal(QIODevice *device);
+}
+
+class BackupJournalWriter
+{
+public:
+    // Writes the header first if the device is at its beginning,
+    // otherwise appends after the last committed session
+    explicit BackupJournalWriter(QIODevice *device);
+
+    void beginSession(quint64 backupPoint, const QString &walletName);
+    // The item needs the dbusPath and modified keys of CollectionModel::exportItemsModifiedSince()
+    void writeItem(const QVariantMap &item);
+    // An item record as returned by BackupJournalReader::rawItemRecord()
+    void writeRawItem(const QByteArray &payload);
+    void writeTombstone(const QString &dbusPath);
+    void commit(quint64 backupPoint);
+
+    bool hasError() const;
+
+private:
+    void writeRecord(quint8 type, const QByteArray &payload);
+
+    QIODevice *m_device;
+    bool m_error = false;
+};
+
+/**
+ * Replays the committed sessions of a journal, then returns the latest
+ * version of every item still alive. Only the offsets are kept in memory:
+ * items are decoded when read.
+ */
+class BackupJournalReader : public ItemReader
+{
+public:
+    // The device must be seekable
+    explicit BackupJournalReader(QIODevice *device);
+
+    QVariantList readItems(int maxItems) override;
+    bool atEnd() const override;
+    QString errorString() const override;
+
+    // Zero for an empty journal
+    quint64 lastBackupPoint() const;
+    QString walletName() const;
+    QStringList livePaths() const;
+    // Where the last commit ends: anything after it is an interrupted session
+    qint64 committedSize() const;
+    QByteArray rawItemRecord(const QString &dbusPath);
+
+private:
+    bool replay();
+    QByteArray readRecordAt(qint64 offset, quint8 expectedType);
+    void setError(const QString &message);
+
+    QIODevice *m_device;
+    // Latest item record of every live dbus path
+    QHash<QString, qint64> m_live;
+    QStringList m_order;
+    quint64 m_lastBackupPoint = 0;
+    QString m_walletName;
+    qint64 m_committedSize = 0;
+    int m_next = 0;
+    QString m_error;
+    bool m_atEnd = false;
+};
@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "benchenvironment.h"
+
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QFile>
+
+static const QString s_secretsBusName = QStringLiteral("org.freedesktop.secrets");
+
+BenchEnvironment::BenchEnvironment()
+    : m_directory(QDir::tempPath() + QStringLiteral("/keepsecret-bench-XXXXXX"))
+{
+}
+
+BenchEnvironment::~BenchEnvironment()
+{
+    stop();
+}
+
+bool BenchEnvironment::start(const QString &providerCommand, std::chrono::milliseconds timeout)
+{
+    if (!m_directory.isValid()) {
+        m_errorString = QStringLiteral("Cannot create a temporary directory: %1").arg(m_directory.errorString());
+        return false;
+    }
+
+    return startBus() && startProvider(providerCommand, timeout);
+}
+
+bool BenchEnvironment::startFake(const FakeSecretService::Options &options)
+{
+    if (!m_directory.isValid()) {
+        m_errorString = QStringLiteral("Cannot create a temporary directory: %1").arg(m_directory.errorString());
+        return false;
+    }
+    if (!startBus()) {
+        return false;
+    }
+
+    m_fakeProvider = std::make_unique<FakeSecretService>(options);
+    if (!m_fakeProvider->start()) {
+        m_errorString = m_fakeProvider->errorString();
+        return false;
+    }
+    return true;
+}
+
+bool BenchEnvironment::startBus()
+{
+    m_bus.setProcessChannelMode(QProcess::SeparateChannels);
+    m_bus.start(QStringLiteral("dbus-daemon"), {QStringLiteral("--session"), QStringLiteral("--nofork"), QStringLiteral("--print-address")});
+    if (!m_bus.waitForStarted()) {
+        m_errorString = QStringLiteral("Cannot start dbus-daemon: %1").arg(m_bus.errorString());
+        return false;
+    }
+
+    // The address is the first line printed
+    while (!m_bus.canReadLine()) {
+        if (!m_bus.waitForReadyRead()) {
+            m_errorString = QStringLiteral("dbus-daemon did not print its address");
+            return false;
+        }
+    }
+    const QByteArray address = m_bus.readLine().trimmed();
+
+    // Both QtDBus and GDBus read it when they first connect to the session bus
+    qputenv("DBUS_SESSION_BUS_ADDRESS", address);
+    return true;
+}
+
+bool BenchEnvironment::startProvider(const QString &providerCommand, std::chrono::milliseconds timeout)
+{
+    QStringList arguments = QProcess::splitCommand(providerCommand);
+    if (arguments.isEmpty()) {
+        m_errorString = QStringLiteral("No provider command");
+        return false;
+    }
+    const QString program = arguments.takeFirst();
+
+    const QString home = m_directory.filePath(QStringLiteral("home"));
+    const QString runtime = m_directory.filePath(QStringLiteral("runtime"));
+    QDir().mkpath(home);
+    QDir().mkpath(runtime);
+    QFile::setPermissions(runtime, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert(QStringLiteral("HOME"), home);
+    environment.insert(QStringLiteral("XDG_DATA_HOME"), home + QStringLiteral("/.local/share"));
+    environment.insert(QStringLiteral("XDG_CONFIG_HOME"), home + QStringLiteral("/.config"));
+    environment.insert(QStringLiteral("XDG_RUNTIME_DIR"), runtime);
+    m_provider.setProcessEnvironment(environment);
+    m_provider.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+    m_provider.start(program, arguments);
+    if (!m_provider.waitForStarted()) {
+        m_errorString = QStringLiteral("Cannot start %1: %2").arg(program, m_provider.errorString());
+        return false;
+    }
+    // The password of the new login keyring
+    m_provider.write("keepsecret-bench");
+    m_provider.closeWriteChannel();
+
+    QDBusConnectionInterface *bus = QDBusConnection::sessionBus().interface();
+    QDeadlineTimer deadline(timeout);
+    while (!bus->isServiceRegistered(s_secretsBusName)) {
+        if (deadline.hasExpired()) {
+            m_errorString = QStringLiteral("%1 did not register %2").arg(program, s_secretsBusName);
+            return false;
+        }
+        // Also the pause between the checks
+        if (m_provider.waitForFinished(20)) {
+            m_errorString = QStringLiteral("%1 exited with code %2").arg(program).arg(m_provider.exitCode());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void BenchEnvironment::stop()
+{
+    if (m_fakeProvider) {
+        m_fakeProvider->stop();
+    }
+
+    for (QProcess *process : {&m_provider, &m_bus}) {
+        if (process->state() == QProcess::NotRunning) {
+            continue;
+        }
+        process->terminate();
+        if (!process->waitForFinished(3000)) {
+            process->kill();
+            process->waitForFinished();
+        }
+    }
+}
+
+FakeSecretService *BenchEnvironment::fakeProvider() const
+{
+    return m_fakeProvider.get();
+}
+
+QString BenchEnvironment::errorString() const
+{
+    return m_errorString;
+}
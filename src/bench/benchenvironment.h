@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "fakesecretservice.h"
+
+#include <QProcess>
+#include <QString>
+#include <QTemporaryDir>
+#include <chrono>
+#include <memory>
+
+/**
+ * A private D-Bus session with a Secret Service provider on it, so that the
+ * benchmark never touches the secrets of the user.
+ * start() has to be called before anything connects to the session bus: it
+ * points DBUS_SESSION_BUS_ADDRESS of this process to the private bus.
+ * An external provider gets its own home and runtime directories, removed
+ * at the end; startFake() runs a FakeSecretService in this process instead.
+ */
+class BenchEnvironment
+{
+public:
+    BenchEnvironment();
+    ~BenchEnvironment();
+    Q_DISABLE_COPY_MOVE(BenchEnvironment)
+
+    // The command is split like a shell would do. If it reads a password
+    // on standard input, like gnome-keyring-daemon --unlock, it gets one
+    bool start(const QString &providerCommand, std::chrono::milliseconds timeout);
+    bool startFake(const FakeSecretService::Options &options);
+    void stop();
+
+    // Only after startFake()
+    FakeSecretService *fakeProvider() const;
+
+    QString errorString() const;
+
+private:
+    bool startBus();
+    bool startProvider(const QString &providerCommand, std::chrono::milliseconds timeout);
+
+    QTemporaryDir m_directory;
+    QProcess m_bus;
+    QProcess m_provider;
+    std::unique_ptr<FakeSecretService> m_fakeProvider;
+    QString m_errorString;
+};
@@ -0,0 +1,531 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "benchmark.h"
+#include "collectionmodel.h"
+#include "importexportmanager.h"
+#include "latencystats.h"
+#include "secretitemproxy.h"
+#include "secretserviceclient.h"
+#include "statetracker.h"
+#include "version-keepsecret.h"
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusPendingCall>
+#include <QDeadlineTimer>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QTimer>
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+// How often the event loop is expected to run while waiting
+static constexpr std::chrono::milliseconds s_probeInterval(5);
+
+// Resident memory of the process, -1 where it isn't known
+static qint64 residentBytes()
+{
+#ifdef Q_OS_LINUX
+    QFile file(QStringLiteral("/proc/self/statm"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    const QList<QByteArray> fields = file.readAll().split(' ');
+    if (fields.size() < 2) {
+        return -1;
+    }
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+static bool isCollectionReady()
+{
+    StateTracker *stateTracker = StateTracker::instance();
+    return (stateTracker->status() & StateTracker::CollectionReady) && !(stateTracker->operations() & StateTracker::CollectionLoading);
+}
+
+Benchmark::Benchmark(const Options &options)
+    : m_options(options)
+    , m_directory(QDir::tempPath() + QStringLiteral("/keepsecret-bench-files-XXXXXX"))
+{
+    m_errorConnection = QObject::connect(StateTracker::instance(), &StateTracker::errorChanged, StateTracker::instance(), [this](StateTracker::Error error, const QString &message) {
+        if (error != StateTracker::NoError) {
+            m_stateError = message;
+        }
+    });
+}
+
+Benchmark::~Benchmark()
+{
+    QObject::disconnect(m_errorConnection);
+}
+
+bool Benchmark::run()
+{
+    if (!connectToService()) {
+        return false;
+    }
+
+    for (int size : std::as_const(m_options.collectionSizes)) {
+        if (!runCollectionSize(size)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QString Benchmark::errorString() const
+{
+    return m_errorString;
+}
+
+bool Benchmark::connectToService()
+{
+    beginProbe();
+    m_secretServiceClient = std::make_unique<SecretServiceClient>();
+
+    // The default collection is read right after connecting
+    const bool connected = waitUntil(QStringLiteral("connect"), []() {
+        StateTracker *stateTracker = StateTracker::instance();
+        return stateTracker->isServiceConnected() && !(stateTracker->operations() & StateTracker::CollectionReadingDefault);
+    });
+    if (!connected) {
+        return false;
+    }
+    addSample(QStringLiteral("connect"), 0, m_probe.timer.durationElapsed());
+
+    QString collectionPath = m_secretServiceClient->defaultCollection();
+    if (collectionPath.isEmpty()) {
+        const QList<SecretServiceClient::CollectionEntry> collections = m_secretServiceClient->listCollections();
+        if (!collections.isEmpty()) {
+            collectionPath = collections.first().dbusPath;
+        }
+    }
+    if (collectionPath.isEmpty()) {
+        m_errorString = QStringLiteral("The provider has no collection to use");
+        return false;
+    }
+
+    m_collectionModel = std::make_unique<CollectionModel>(m_secretServiceClient.get());
+    m_secretItemProxy = std::make_unique<SecretItemProxy>(m_secretServiceClient.get());
+    m_importExportManager = std::make_unique<ImportExportManager>(m_secretServiceClient.get());
+
+    // Wired like in App
+    QObject::connect(m_collectionModel.get(), &CollectionModel::importProgress, m_importExportManager.get(), [this](int done, int total) {
+        m_importExportManager->setImportBacklog(total - done);
+    });
+    QObject::connect(m_importExportManager.get(), &ImportExportManager::itemsImported, m_collectionModel.get(), &CollectionModel::importChunk);
+    QObject::connect(m_importExportManager.get(), &ImportExportManager::importSucceeded, m_collectionModel.get(), &CollectionModel::endImport);
+    QObject::connect(m_importExportManager.get(), &ImportExportManager::errorOccurred, m_collectionModel.get(), &CollectionModel::endImport);
+    QObject::connect(m_importExportManager.get(), &ImportExportManager::errorOccurred, m_importExportManager.get(), [this](const QString &message) {
+        m_stateError = message;
+    });
+
+    // What a view of the model would have to redo
+    QObject::connect(m_collectionModel.get(), &QAbstractItemModel::modelReset, m_collectionModel.get(), [this]() {
+        ++m_probe.resets;
+    });
+    QObject::connect(m_collectionModel.get(), &QAbstractItemModel::rowsInserted, m_collectionModel.get(), [this](const QModelIndex &, int first, int last) {
+        m_probe.rowsChanged += last - first + 1;
+    });
+    QObject::connect(m_collectionModel.get(), &QAbstractItemModel::rowsRemoved, m_collectionModel.get(), [this](const QModelIndex &, int first, int last) {
+        m_probe.rowsChanged += last - first + 1;
+    });
+    QObject::connect(m_collectionModel.get(),
+                     &QAbstractItemModel::dataChanged,
+                     m_collectionModel.get(),
+                     [this](const QModelIndex &topLeft, const QModelIndex &bottomRight) {
+                         m_probe.rowsChanged += bottomRight.row() - topLeft.row() + 1;
+                     });
+
+    m_collectionModel->setCollectionPath(collectionPath);
+    if (!waitUntil(QStringLiteral("connect"), isCollectionReady)) {
+        return false;
+    }
+    // Everything in it gets deleted
+    if (m_collectionModel->rowCount() > 0) {
+        m_errorString = QStringLiteral("The collection %1 is not empty").arg(collectionPath);
+        return false;
+    }
+    return true;
+}
+
+bool Benchmark::runCollectionSize(int size)
+{
+    const QString filePath = m_directory.filePath(QStringLiteral("export-%1.xml").arg(size));
+
+    return bulkCreate(size) && loadCollection(size) && loadItems(size) && exportCollection(size, filePath) && externalDelete(size) && bulkDelete(size)
+        && importFile(size, filePath) && bulkDelete(size, false);
+}
+
+bool Benchmark::bulkCreate(int size)
+{
+    const QVariantList items = generateItems(size);
+    bool finished = false;
+    int failed = 0;
+    const auto connection =
+        QObject::connect(m_collectionModel.get(), &CollectionModel::importFinished, m_collectionModel.get(), [&finished, &failed](int imported, int importFailed) {
+            Q_UNUSED(imported)
+            finished = true;
+            failed = importFailed;
+        });
+
+    beginProbe();
+    m_collectionModel->importItems(items);
+    // Until the new items are in the model
+    const bool done = waitUntil(QStringLiteral("bulk_create"), [&finished]() {
+        return finished && isCollectionReady();
+    });
+    const auto duration = m_probe.timer.durationElapsed();
+    QObject::disconnect(connection);
+
+    if (!done) {
+        return false;
+    }
+    if (failed > 0 || m_collectionModel->rowCount() != size) {
+        m_errorString = QStringLiteral("bulk_create: %1 of %2 items created").arg(m_collectionModel->rowCount()).arg(size);
+        return false;
+    }
+    addSample(QStringLiteral("bulk_create"), size, duration);
+    return true;
+}
+
+bool Benchmark::loadCollection(int size)
+{
+    for (int i = 0; i < m_options.repeat; ++i) {
+        beginProbe();
+        m_collectionModel->refreshWallet();
+        if (!waitUntil(QStringLiteral("collection_load"), isCollectionReady)) {
+            return false;
+        }
+        addSample(QStringLiteral("collection_load"), size, m_probe.timer.durationElapsed());
+
+        if (m_collectionModel->rowCount() != size) {
+            m_errorString = QStringLiteral("collection_load: %1 items instead of %2").arg(m_collectionModel->rowCount()).arg(size);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Benchmark::loadItems(int size)
+{
+    bool loaded = false;
+    const auto connection = QObject::connect(m_secretItemProxy.get(), &SecretItemProxy::itemLoaded, m_secretItemProxy.get(), [&loaded]() {
+        loaded = true;
+    });
+
+    bool success = true;
+    for (int i = 0; i < m_options.repeat && success; ++i) {
+        // Spread over the collection
+        const QString dbusPath = m_collectionModel->dbusPathAt(qint64(i) * size / m_options.repeat);
+        loaded = false;
+
+        beginProbe();
+        m_secretItemProxy->loadItem(m_collectionModel->collectionPath(), dbusPath);
+        success = waitUntil(QStringLiteral("item_load"), [&loaded]() {
+            return loaded;
+        });
+        if (success) {
+            addSample(QStringLiteral("item_load"), size, m_probe.timer.durationElapsed());
+        }
+    }
+
+    QObject::disconnect(connection);
+    return success;
+}
+
+bool Benchmark::exportCollection(int size, const QString &filePath)
+{
+    bool exported = false;
+    const auto connection =
+        QObject::connect(m_importExportManager.get(), &ImportExportManager::exportSucceeded, m_importExportManager.get(), [&exported](const QString &filePath) {
+            Q_UNUSED(filePath)
+            exported = true;
+        });
+
+    bool success = true;
+    for (int i = 0; i < m_options.repeat && success; ++i) {
+        exported = false;
+
+        beginProbe();
+        m_importExportManager->exportToFile(filePath, QStringLiteral("keepsecret-bench"), m_collectionModel->exportItems());
+        success = waitUntil(QStringLiteral("export"), [&exported]() {
+            return exported;
+        });
+        if (success) {
+            addSample(QStringLiteral("export"), size, m_probe.timer.durationElapsed());
+        }
+    }
+
+    QObject::disconnect(connection);
+    return success;
+}
+
+bool Benchmark::externalDelete(int size)
+{
+    // Deleted by another client, only the model of this one is watched
+    const QString dbusPath = m_collectionModel->dbusPathAt(size / 2);
+    const QDBusMessage call =
+        QDBusMessage::createMethodCall(QStringLiteral("org.freedesktop.secrets"), dbusPath, QStringLiteral("org.freedesktop.Secret.Item"), QStringLiteral("Delete"));
+    QDBusConnection connection = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("keepsecret-bench-external"));
+
+    beginProbe();
+    const QDBusPendingCall pending = connection.asyncCall(call);
+    const bool done = waitUntil(QStringLiteral("external_delete"), [this, size, &pending]() {
+        if (pending.isFinished() && pending.isError()) {
+            m_stateError = pending.error().message();
+        }
+        return m_collectionModel->rowCount() == size - 1 && isCollectionReady();
+    });
+    const auto duration = m_probe.timer.durationElapsed();
+    QDBusConnection::disconnectFromBus(QStringLiteral("keepsecret-bench-external"));
+
+    if (!done) {
+        return false;
+    }
+    addSample(QStringLiteral("external_delete"), size, duration);
+    addMetric(QStringLiteral("external_delete"), size, QStringLiteral("resets"), m_probe.resets);
+    addMetric(QStringLiteral("external_delete"), size, QStringLiteral("rows_changed"), m_probe.rowsChanged);
+    return true;
+}
+
+bool Benchmark::bulkDelete(int size, bool record)
+{
+    bool deleted = false;
+    const auto connection =
+        QObject::connect(m_collectionModel.get(), &CollectionModel::itemsDeleted, m_collectionModel.get(), [&deleted](const QStringList &dbusPaths) {
+            Q_UNUSED(dbusPaths)
+            deleted = true;
+        });
+
+    beginProbe();
+    m_collectionModel->deleteItems(m_collectionModel->dbusPaths());
+    const bool done = waitUntil(QStringLiteral("bulk_delete"), [&deleted]() {
+        return deleted && isCollectionReady();
+    });
+    const auto duration = m_probe.timer.durationElapsed();
+    QObject::disconnect(connection);
+
+    if (!done) {
+        return false;
+    }
+    if (m_collectionModel->rowCount() != 0) {
+        m_errorString = QStringLiteral("bulk_delete: %1 items left").arg(m_collectionModel->rowCount());
+        return false;
+    }
+    if (record) {
+        addSample(QStringLiteral("bulk_delete"), size, duration);
+    }
+    return true;
+}
+
+bool Benchmark::importFile(int size, const QString &filePath)
+{
+    bool imported = false;
+    const auto connection =
+        QObject::connect(m_importExportManager.get(), &ImportExportManager::importSucceeded, m_importExportManager.get(), [&imported](int count) {
+            Q_UNUSED(count)
+            imported = true;
+        });
+
+    beginProbe();
+    m_importExportManager->importFromFile(filePath);
+    // The last chunks are still being written when the file is done
+    const bool done = waitUntil(QStringLiteral("import"), [&imported]() {
+        return imported && !StateTracker::instance()->isBusy() && isCollectionReady();
+    });
+    const auto duration = m_probe.timer.durationElapsed();
+    QObject::disconnect(connection);
+
+    if (!done) {
+        return false;
+    }
+    if (m_collectionModel->rowCount() != size) {
+        m_errorString = QStringLiteral("import: %1 of %2 items imported").arg(m_collectionModel->rowCount()).arg(size);
+        return false;
+    }
+    addSample(QStringLiteral("import"), size, duration);
+    return true;
+}
+
+bool Benchmark::waitUntil(const QString &step, const std::function<bool()> &done)
+{
+    m_stateError.clear();
+
+    // Wakes up the loop for the deadline, and sees when it didn't run
+    QTimer probeTimer;
+    probeTimer.setTimerType(Qt::PreciseTimer);
+    QObject::connect(&probeTimer, &QTimer::timeout, &probeTimer, [this]() {
+        updateProbe();
+    });
+    probeTimer.start(s_probeInterval);
+    const QDeadlineTimer deadline(m_options.timeout);
+
+    QEventLoop loop;
+    while (!done()) {
+        if (!m_stateError.isEmpty()) {
+            m_errorString = QStringLiteral("%1: %2").arg(step, m_stateError);
+            return false;
+        }
+        if (deadline.hasExpired()) {
+            m_errorString = QStringLiteral("%1: timed out").arg(step);
+            return false;
+        }
+        loop.processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    updateProbe();
+    return true;
+}
+
+void Benchmark::beginProbe()
+{
+    m_probe = Probe();
+    m_probe.timer.start();
+    m_probe.lastTick.start();
+    m_probe.startResident = residentBytes();
+    m_probe.peakResident = m_probe.startResident;
+    if (m_options.providerCalls) {
+        m_probe.startProviderCalls = m_options.providerCalls();
+    }
+}
+
+void Benchmark::updateProbe()
+{
+    m_probe.maxStall = std::max(m_probe.maxStall, m_probe.lastTick.restart());
+    m_probe.peakResident = std::max(m_probe.peakResident, residentBytes());
+}
+
+Benchmark::Result &Benchmark::result(const QString &step, int items)
+{
+    auto it = std::find_if(m_results.begin(), m_results.end(), [&step, items](const Result &result) {
+        return result.step == step && result.items == items;
+    });
+    if (it == m_results.end()) {
+        m_results.append(Result{step, items, {}, {}});
+        it = std::prev(m_results.end());
+    }
+    return *it;
+}
+
+void Benchmark::addSample(const QString &step, int items, std::chrono::nanoseconds duration)
+{
+    result(step, items).samples.append(duration.count() / 1000000.0);
+
+    addMetric(step, items, QStringLiteral("max_stall_ms"), m_probe.maxStall);
+    if (m_probe.startResident >= 0) {
+        addMetric(step, items, QStringLiteral("rss_growth_mb"), (m_probe.peakResident - m_probe.startResident) / (1024.0 * 1024.0));
+    }
+    if (m_options.providerCalls && items > 0) {
+        addMetric(step, items, QStringLiteral("provider_calls_per_item"), qreal(m_options.providerCalls() - m_probe.startProviderCalls) / items);
+    }
+}
+
+void Benchmark::addMetric(const QString &step, int items, const QString &name, qreal value)
+{
+    Result &stepResult = result(step, items);
+    stepResult.metrics[name] = std::max(stepResult.metrics.value(name, value), value);
+}
+
+QStringList Benchmark::checkLimits(const QJsonObject &limits) const
+{
+    QStringList failures;
+    for (const Result &result : m_results) {
+        const QJsonObject stepLimits = limits.value(result.step).toObject();
+        for (auto it = stepLimits.constBegin(); it != stepLimits.constEnd(); ++it) {
+            qreal value = 0;
+            if (it.key() == QStringLiteral("median_ms")) {
+                value = median(result.samples);
+            } else if (result.metrics.contains(it.key())) {
+                value = result.metrics.value(it.key());
+            } else {
+                // Not measured with this provider or on this system
+                continue;
+            }
+
+            if (value > it.value().toDouble()) {
+                failures.append(QStringLiteral("%1 with %2 items: %3 is %4, more than %5")
+                                    .arg(result.step)
+                                    .arg(result.items)
+                                    .arg(it.key())
+                                    .arg(value)
+                                    .arg(it.value().toDouble()));
+            }
+        }
+    }
+    return failures;
+}
+
+qreal Benchmark::median(QList<qreal> samples)
+{
+    std::sort(samples.begin(), samples.end());
+    return samples.at(samples.count() / 2);
+}
+
+QJsonObject Benchmark::results() const
+{
+    QJsonArray steps;
+    for (const Result &result : m_results) {
+        QList<qreal> sorted = result.samples;
+        std::sort(sorted.begin(), sorted.end());
+
+        qreal total = 0;
+        QJsonArray samples;
+        for (qreal sample : result.samples) {
+            samples.append(sample);
+            total += sample;
+        }
+
+        QJsonObject metrics;
+        for (auto it = result.metrics.constBegin(); it != result.metrics.constEnd(); ++it) {
+            metrics[it.key()] = it.value();
+        }
+
+        steps.append(QJsonObject{
+            {QStringLiteral("step"), result.step},
+            {QStringLiteral("items"), result.items},
+            {QStringLiteral("samples"), samples},
+            {QStringLiteral("min"), sorted.first()},
+            {QStringLiteral("median"), median(result.samples)},
+            {QStringLiteral("mean"), total / sorted.count()},
+            {QStringLiteral("max"), sorted.last()},
+            {QStringLiteral("metrics"), metrics},
+        });
+    }
+
+    return QJsonObject{
+        {QStringLiteral("version"), QStringLiteral(KEEPSECRET_VERSION_STRING)},
+        {QStringLiteral("unit"), QStringLiteral("ms")},
+        {QStringLiteral("steps"), steps},
+        {QStringLiteral("latency"), LatencyStats::instance()->toJson()},
+    };
+}
+
+QVariantList Benchmark::generateItems(int size)
+{
+    QVariantList items;
+    items.reserve(size);
+    for (int i = 0; i < size; ++i) {
+        const QString server = QStringLiteral("server%1.example.org").arg(i % 100);
+        items.append(QVariantMap{
+            {QStringLiteral("label"), QStringLiteral("Bench item %1").arg(i)},
+            {QStringLiteral("secret"), QByteArray::number(i).rightJustified(32, 'x')},
+            {QStringLiteral("contentType"), QStringLiteral("text/plain")},
+            {QStringLiteral("attributes"),
+             QVariantMap{
+                 {QStringLiteral("xdg:schema"), QStringLiteral("org.qt.keychain")},
+                 {QStringLiteral("server"), server},
+                 {QStringLiteral("user"), QStringLiteral("user%1").arg(i)},
+             }},
+        });
+    }
+    return items;
+}
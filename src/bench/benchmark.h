@@ -0,0 +1,125 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QMetaObject>
+#include <QString>
+#include <QTemporaryDir>
+#include <QVariantList>
+#include <chrono>
+#include <functional>
+#include <memory>
+
+class CollectionModel;
+class ImportExportManager;
+class SecretItemProxy;
+class SecretServiceClient;
+
+/**
+ * Times the main paths of the application against whatever provides the
+ * secret service on the session bus, in the default collection, which is
+ * expected to start empty.
+ * For every collection size the collection is filled and emptied again:
+ * bulk create, load, loadItem, export, bulk delete and import of the
+ * exported file, plus the deletion of one item by another client. Each
+ * step is measured from the call to the moment its result can be seen in
+ * the models, as the user would see it.
+ * Besides the time, each step records metrics: the longest time the event
+ * loop didn't run, the growth of the resident memory, the model resets and
+ * changed rows, and the method calls the provider got, when it can tell.
+ */
+class Benchmark
+{
+public:
+    struct Options {
+        QList<int> collectionSizes = {100, 1000};
+        // Samples of the steps which leave the collection as it was
+        int repeat = 5;
+        std::chrono::milliseconds timeout = std::chrono::minutes(10);
+        // Method calls received by the provider so far, if it counts them
+        std::function<quint64()> providerCalls;
+    };
+
+    explicit Benchmark(const Options &options);
+    ~Benchmark();
+    Q_DISABLE_COPY_MOVE(Benchmark)
+
+    // False if any step failed or timed out, the results so far are kept
+    bool run();
+    QString errorString() const;
+
+    // Machine readable results: the samples of each step in milliseconds,
+    // plus the latencies of the single calls from LatencyStats
+    QJsonObject results() const;
+
+    // The limits are maxima by step and then by metric, or median_ms for
+    // the time, like {"collection_load": {"max_stall_ms": 500}}. They apply
+    // to every collection size; metrics which weren't measured are skipped.
+    // Returns a description of each exceeded limit
+    QStringList checkLimits(const QJsonObject &limits) const;
+
+private:
+    struct Result {
+        QString step;
+        int items = 0;
+        QList<qreal> samples;
+        // The worst value of all the samples
+        QMap<QString, qreal> metrics;
+    };
+
+    // Of the step being measured
+    struct Probe {
+        QElapsedTimer timer;
+        QElapsedTimer lastTick;
+        qint64 maxStall = 0;
+        qint64 startResident = -1;
+        qint64 peakResident = -1;
+        quint64 startProviderCalls = 0;
+        int resets = 0;
+        int rowsChanged = 0;
+    };
+
+    bool connectToService();
+    bool runCollectionSize(int size);
+
+    bool bulkCreate(int size);
+    bool loadCollection(int size);
+    bool loadItems(int size);
+    bool exportCollection(int size, const QString &filePath);
+    bool externalDelete(int size);
+    // The collection is emptied again after the import, without a sample
+    bool bulkDelete(int size, bool record = true);
+    bool importFile(int size, const QString &filePath);
+
+    // Runs the event loop until done() is true, false on timeout or on an
+    // error of the StateTracker
+    bool waitUntil(const QString &step, const std::function<bool()> &done);
+    // Right before the call starting a step
+    void beginProbe();
+    void updateProbe();
+
+    Result &result(const QString &step, int items);
+    // Also records the metrics of the probe
+    void addSample(const QString &step, int items, std::chrono::nanoseconds duration);
+    void addMetric(const QString &step, int items, const QString &name, qreal value);
+    static qreal median(QList<qreal> samples);
+    static QVariantList generateItems(int size);
+
+    Options m_options;
+    QTemporaryDir m_directory;
+    // Created by connectToService(), as the client connects right away
+    std::unique_ptr<SecretServiceClient> m_secretServiceClient;
+    std::unique_ptr<CollectionModel> m_collectionModel;
+    std::unique_ptr<SecretItemProxy> m_secretItemProxy;
+    std::unique_ptr<ImportExportManager> m_importExportManager;
+    QList<Result> m_results;
+    Probe m_probe;
+    QMetaObject::Connection m_errorConnection;
+    QString m_stateError;
+    QString m_errorString;
+};
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include <QCommandLineParser>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#include "benchenvironment.h"
+#include "benchmark.h"
+#include "version-keepsecret.h"
+#include <KLocalizedString>
+
+using namespace Qt::Literals::StringLiterals;
+
+int main(int argc, char *argv[])
+{
+    // The clipboard manager needs a gui application, but never a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName(u"keepsecret-bench"_s);
+    QCoreApplication::setApplicationVersion(QStringLiteral(KEEPSECRET_VERSION_STRING));
+    KLocalizedString::setApplicationDomain("keepsecret");
+    // Don't touch the configuration and state of the user
+    QStandardPaths::setTestModeEnabled(true);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(u"Times keepsecret against a secret service on a private D-Bus session"_s);
+    parser.addHelpOption();
+    parser.addVersionOption();
+    const QCommandLineOption providerOption(u"provider"_s,
+                                            u"Command starting the secret service provider, gnome-keyring-daemon by default, or fake for one in this process"_s,
+                                            u"command"_s,
+                                            u"gnome-keyring-daemon --foreground --components=secrets --unlock"_s);
+    parser.addOption(providerOption);
+    const QCommandLineOption latencyOption(u"latency"_s, u"Milliseconds the fake provider takes to answer each call"_s, u"ms"_s, u"0"_s);
+    parser.addOption(latencyOption);
+    const QCommandLineOption jitterOption(u"jitter"_s, u"Random milliseconds added to the latency of the fake provider"_s, u"ms"_s, u"0"_s);
+    parser.addOption(jitterOption);
+    const QCommandLineOption failureRateOption(u"failure-rate"_s, u"Fraction of the calls the fake provider fails, from 0 to 1"_s, u"rate"_s, u"0"_s);
+    parser.addOption(failureRateOption);
+    const QCommandLineOption itemsOption(u"items"_s, u"Comma separated sizes of the collections, 100,1000 by default"_s, u"sizes"_s, u"100,1000"_s);
+    parser.addOption(itemsOption);
+    const QCommandLineOption repeatOption(u"repeat"_s, u"Samples of the repeatable steps, 5 by default"_s, u"count"_s, u"5"_s);
+    parser.addOption(repeatOption);
+    const QCommandLineOption timeoutOption(u"timeout"_s, u"Seconds a single step may take, 600 by default"_s, u"seconds"_s, u"600"_s);
+    parser.addOption(timeoutOption);
+    const QCommandLineOption limitsOption(u"limits"_s, u"Fail if the results exceed the limits in the JSON <file>, like bench/limits.json"_s, u"file"_s);
+    parser.addOption(limitsOption);
+    const QCommandLineOption outputOption(u"output"_s, u"Write the JSON results to <file> instead of the standard output"_s, u"file"_s);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    Benchmark::Options options;
+    options.collectionSizes.clear();
+    for (const QString &size : parser.value(itemsOption).split(u',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int value = size.trimmed().toInt(&ok);
+        if (!ok || value <= 0) {
+            qCritical().noquote() << "Invalid collection size" << size;
+            return 2;
+        }
+        options.collectionSizes.append(value);
+    }
+    options.repeat = qMax(1, parser.value(repeatOption).toInt());
+    options.timeout = std::chrono::seconds(qMax(1, parser.value(timeoutOption).toInt()));
+
+    QJsonObject limits;
+    if (parser.isSet(limitsOption)) {
+        QFile file(parser.value(limitsOption));
+        QJsonParseError parseError;
+        if (file.open(QIODevice::ReadOnly)) {
+            limits = QJsonDocument::fromJson(file.readAll(), &parseError).object();
+        }
+        if (!file.isOpen() || parseError.error != QJsonParseError::NoError) {
+            qCritical().noquote() << "Cannot read the limits from" << file.fileName();
+            return 2;
+        }
+    }
+
+    BenchEnvironment environment;
+    bool started = false;
+    if (parser.value(providerOption) == u"fake"_s) {
+        FakeSecretService::Options fakeOptions;
+        fakeOptions.latency = std::chrono::milliseconds(parser.value(latencyOption).toInt());
+        fakeOptions.jitter = std::chrono::milliseconds(parser.value(jitterOption).toInt());
+        fakeOptions.failureRate = parser.value(failureRateOption).toDouble();
+        started = environment.startFake(fakeOptions);
+        options.providerCalls = [&environment]() {
+            return environment.fakeProvider()->callCount();
+        };
+    } else {
+        started = environment.start(parser.value(providerOption), std::chrono::seconds(30));
+    }
+    if (!started) {
+        qCritical().noquote() << environment.errorString();
+        return 2;
+    }
+
+    QJsonObject results;
+    bool success = false;
+    {
+        Benchmark benchmark(options);
+        success = benchmark.run();
+        results = benchmark.results();
+        results[u"provider"_s] = parser.value(providerOption);
+        results[u"success"_s] = success;
+        if (!success) {
+            results[u"error"_s] = benchmark.errorString();
+            qCritical().noquote() << benchmark.errorString();
+        } else if (parser.isSet(limitsOption)) {
+            const QStringList failures = benchmark.checkLimits(limits);
+            for (const QString &failure : failures) {
+                qCritical().noquote() << failure;
+            }
+            results[u"limitsExceeded"_s] = QJsonArray::fromStringList(failures);
+            success = failures.isEmpty();
+        }
+    }
+    environment.stop();
+
+    const QByteArray json = QJsonDocument(results).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size()) {
+            qCritical().noquote() << "Cannot write" << file.fileName() << file.errorString();
+            return 2;
+        }
+    } else {
+        QTextStream(stdout) << json;
+    }
+
+    return success ? 0 : 1;
+}
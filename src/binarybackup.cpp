@@ -0,0 +1,419 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "binarybackup.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QtEndian>
+
+static constexpr char s_magic[] = "KSBACKUP";
+static constexpr char s_indexMagic[] = "KSBINDEX";
+static constexpr qint64 s_magicSize = 8;
+static constexpr quint16 s_version = 1;
+static constexpr qint64 s_headerSize = s_magicSize + 2 * sizeof(quint16);
+static constexpr qint64 s_recordHeaderSize = sizeof(quint8) + sizeof(quint32);
+static constexpr qint64 s_footerSize = sizeof(quint64) + s_magicSize;
+// Refuse records bigger than this, rather than allocating whatever a corrupted size says
+static constexpr quint32 s_maxRecordSize = 64 * 1024 * 1024;
+
+enum RecordType : quint8 {
+    SectionRecord = 1,
+    ItemRecord,
+    IndexRecord,
+};
+
+using BinaryBackup::setupStream;
+
+bool BinaryBackup::isBinaryBackup(QIODevice *device)
+{
+    return device->peek(s_magicSize) == QByteArray(s_magic, s_magicSize);
+}
+
+void BinaryBackup::setupStream(QDataStream &stream)
+{
+    stream.setVersion(QDataStream::Qt_6_0);
+    stream.setByteOrder(QDataStream::BigEndian);
+}
+
+void BinaryBackup::writeItemFields(QDataStream &stream, const QVariantMap &item)
+{
+    stream << item.value(QStringLiteral("label")).toString() << item.value(QStringLiteral("contentType")).toString()
+           << item.value(QStringLiteral("folder")).toString() << item.value(QStringLiteral("attributes")).toMap()
+           << item.value(QStringLiteral("secret")).toByteArray();
+}
+
+bool BinaryBackup::readItemFields(QDataStream &stream, QVariantMap *item)
+{
+    QString label;
+    QString contentType;
+    QString folder;
+    QVariantMap attributes;
+    QByteArray secret;
+
+    stream >> label >> contentType >> folder >> attributes >> secret;
+    if (stream.status() != QDataStream::Ok) {
+        return false;
+    }
+
+    item->insert(QStringLiteral("label"), label);
+    item->insert(QStringLiteral("secret"), secret);
+    item->insert(QStringLiteral("contentType"), contentType);
+    item->insert(QStringLiteral("attributes"), attributes);
+    item->insert(QStringLiteral("folder"), folder);
+    return true;
+}
+
+BinaryBackupWriter::BinaryBackupWriter(QIODevice *device, bool compress)
+    : m_device(device)
+    , m_compress(compress)
+{
+    QByteArray header(s_magic, s_magicSize);
+    header.resize(s_headerSize);
+    qToBigEndian<quint16>(s_version, header.data() + s_magicSize);
+    qToBigEndian<quint16>(compress ? BinaryBackup::Compressed : BinaryBackup::NoFlags, header.data() + s_magicSize + sizeof(quint16));
+
+    m_error = m_device->write(header) != header.size();
+    m_offset = header.size();
+}
+
+void BinaryBackupWriter::writeRecord(quint8 type, const QByteArray &payload)
+{
+    if (m_error) {
+        return;
+    }
+
+    char recordHeader[s_recordHeaderSize];
+    recordHeader[0] = char(type);
+    qToBigEndian<quint32>(payload.size(), recordHeader + 1);
+
+    if (m_device->write(recordHeader, s_recordHeaderSize) != s_recordHeaderSize || m_device->write(payload) != payload.size()) {
+        m_error = true;
+        return;
+    }
+    m_offset += s_recordHeaderSize + payload.size();
+}
+
+void BinaryBackupWriter::beginWallet(const QString &walletName)
+{
+    m_sections << walletName;
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    setupStream(stream);
+    stream << walletName;
+
+    writeRecord(SectionRecord, payload);
+}
+
+void BinaryBackupWriter::writeItem(const QVariantMap &item)
+{
+    const QString label = item.value(QStringLiteral("label")).toString();
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    setupStream(stream);
+    BinaryBackup::writeItemFields(stream, item);
+
+    m_index.append({quint32(m_sections.count() - 1), m_offset, label});
+
+    if (m_compress) {
+        QByteArray compressed = qCompress(payload);
+        payload.fill(0);
+        writeRecord(ItemRecord, compressed);
+        compressed.fill(0);
+    } else {
+        writeRecord(ItemRecord, payload);
+        payload.fill(0);
+    }
+}
+
+void BinaryBackupWriter::endWallet()
+{
+}
+
+void BinaryBackupWriter::finish()
+{
+    const quint64 indexOffset = m_offset;
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    setupStream(stream);
+    stream << m_sections << quint32(m_index.count());
+    for (const IndexEntry &entry : std::as_const(m_index)) {
+        stream << entry.section << entry.offset << entry.label;
+    }
+    writeRecord(IndexRecord, payload);
+
+    if (m_error) {
+        return;
+    }
+
+    char footer[s_footerSize];
+    qToBigEndian<quint64>(indexOffset, footer);
+    memcpy(footer + sizeof(quint64), s_indexMagic, s_magicSize);
+    m_error = m_device->write(footer, s_footerSize) != s_footerSize;
+}
+
+bool BinaryBackupWriter::hasError() const
+{
+    return m_error;
+}
+
+BinaryBackupReader::BinaryBackupReader(QIODevice *device)
+    : m_device(device)
+{
+    // Read rather than peeked, as sequential devices may not support peeking
+    if (!readHeader(m_device->read(s_headerSize))) {
+        return;
+    }
+
+    // Otherwise falls back to walking the records sequentially
+    if (auto *file = qobject_cast<QFile *>(m_device)) {
+        mapIndex(file);
+    }
+}
+
+BinaryBackupReader::~BinaryBackupReader()
+{
+    if (m_map) {
+        m_mappedFile->unmap(const_cast<uchar *>(m_map));
+    }
+}
+
+void BinaryBackupReader::setError(const QString &message)
+{
+    m_error = message;
+    m_atEnd = true;
+}
+
+bool BinaryBackupReader::readHeader(const QByteArray &header)
+{
+    if (header.size() < s_headerSize || !header.startsWith(QByteArray(s_magic, s_magicSize))) {
+        setError(QStringLiteral("Not a valid KeepSecret backup file."));
+        return false;
+    }
+
+    const quint16 version = qFromBigEndian<quint16>(header.constData() + s_magicSize);
+    if (version > s_version) {
+        setError(QStringLiteral("This backup was made by a newer version of KeepSecret."));
+        return false;
+    }
+    m_flags = qFromBigEndian<quint16>(header.constData() + s_magicSize + sizeof(quint16));
+    return true;
+}
+
+bool BinaryBackupReader::mapIndex(QFile *file)
+{
+    const qint64 size = file->size();
+    if (size < s_headerSize + s_footerSize) {
+        setError(QStringLiteral("The backup file is truncated."));
+        return false;
+    }
+
+    uchar *map = file->map(0, size);
+    if (!map) {
+        return false;
+    }
+    m_mappedFile = file;
+    m_map = map;
+    m_mapSize = size;
+
+    const uchar *footer = m_map + m_mapSize - s_footerSize;
+    if (memcmp(footer + sizeof(quint64), s_indexMagic, s_magicSize) != 0) {
+        setError(QStringLiteral("The backup file is truncated."));
+        return false;
+    }
+
+    const quint64 indexOffset = qFromBigEndian<quint64>(footer);
+    if (indexOffset < quint64(s_headerSize) || indexOffset + s_recordHeaderSize > quint64(m_mapSize - s_footerSize)) {
+        setError(QStringLiteral("The backup index is corrupted."));
+        return false;
+    }
+
+    const uchar *record = m_map + indexOffset;
+    const quint32 indexSize = qFromBigEndian<quint32>(record + 1);
+    if (record[0] != IndexRecord || indexOffset + s_recordHeaderSize + indexSize > quint64(m_mapSize - s_footerSize)) {
+        setError(QStringLiteral("The backup index is corrupted."));
+        return false;
+    }
+
+    const QByteArray payload = QByteArray::fromRawData(reinterpret_cast<const char *>(record + s_recordHeaderSize), indexSize);
+    QDataStream stream(payload);
+    setupStream(stream);
+
+    quint32 count = 0;
+    stream >> m_sections >> count;
+    m_index.reserve(qMin<quint32>(count, indexSize));
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        IndexEntry entry;
+        stream >> entry.section >> entry.offset >> entry.label;
+        if (entry.section >= quint32(m_sections.count()) || entry.offset >= indexOffset) {
+            break;
+        }
+        m_index.append(entry);
+    }
+
+    if (stream.status() != QDataStream::Ok || quint32(m_index.count()) != count) {
+        m_index.clear();
+        setError(QStringLiteral("The backup index is corrupted."));
+        return false;
+    }
+
+    return true;
+}
+
+bool BinaryBackupReader::hasIndex() const
+{
+    return m_map != nullptr && !hasError();
+}
+
+int BinaryBackupReader::count() const
+{
+    return m_index.count();
+}
+
+QString BinaryBackupReader::labelAt(int index) const
+{
+    return m_index.value(index).label;
+}
+
+QString BinaryBackupReader::walletAt(int index) const
+{
+    if (index < 0 || index >= m_index.count()) {
+        return QString();
+    }
+    return m_sections.value(m_index[index].section);
+}
+
+QVariantMap BinaryBackupReader::itemAt(int index)
+{
+    if (!hasIndex() || index < 0 || index >= m_index.count()) {
+        return QVariantMap();
+    }
+    return readMappedItem(index);
+}
+
+QVariantMap BinaryBackupReader::decodeItem(const QByteArray &payload, const QString &wallet)
+{
+    QByteArray data = (m_flags & BinaryBackup::Compressed) ? qUncompress(payload) : payload;
+    if (data.isEmpty()) {
+        setError(QStringLiteral("A backup record is corrupted."));
+        return QVariantMap();
+    }
+
+    QVariantMap item;
+    QDataStream stream(data);
+    setupStream(stream);
+    const bool ok = BinaryBackup::readItemFields(stream, &item);
+    if (m_flags & BinaryBackup::Compressed) {
+        data.fill(0);
+    }
+
+    if (!ok) {
+        setError(QStringLiteral("A backup record is corrupted."));
+        return QVariantMap();
+    }
+    item[QStringLiteral("wallet")] = wallet;
+    return item;
+}
+
+QVariantMap BinaryBackupReader::readMappedItem(int index)
+{
+    const IndexEntry &entry = m_index[index];
+    const uchar *record = m_map + entry.offset;
+    const quint32 size = qFromBigEndian<quint32>(record + 1);
+
+    if (record[0] != ItemRecord || entry.offset + s_recordHeaderSize + size > quint64(m_mapSize)) {
+        setError(QStringLiteral("A backup record is corrupted."));
+        return QVariantMap();
+    }
+
+    const QByteArray payload = QByteArray::fromRawData(reinterpret_cast<const char *>(record + s_recordHeaderSize), size);
+    return decodeItem(payload, m_sections.value(entry.section));
+}
+
+QVariantMap BinaryBackupReader::readNextRecord(bool *isItem)
+{
+    *isItem = false;
+
+    const QByteArray recordHeader = m_device->read(s_recordHeaderSize);
+    if (recordHeader.size() != s_recordHeaderSize) {
+        setError(QStringLiteral("The backup file is truncated."));
+        return QVariantMap();
+    }
+
+    const quint8 type = quint8(recordHeader[0]);
+    const quint32 size = qFromBigEndian<quint32>(recordHeader.constData() + 1);
+    if (type == IndexRecord) {
+        // The index is only useful for random access
+        m_atEnd = true;
+        return QVariantMap();
+    }
+    if (size > s_maxRecordSize) {
+        setError(QStringLiteral("A backup record is corrupted."));
+        return QVariantMap();
+    }
+
+    QByteArray payload = m_device->read(size);
+    if (payload.size() != qsizetype(size)) {
+        setError(QStringLiteral("The backup file is truncated."));
+        return QVariantMap();
+    }
+
+    QVariantMap item;
+    if (type == SectionRecord) {
+        QDataStream stream(payload);
+        setupStream(stream);
+        stream >> m_currentSection;
+    } else if (type == ItemRecord) {
+        item = decodeItem(payload, m_currentSection);
+        *isItem = !item.isEmpty();
+    }
+    // Unknown record types are skipped, newer minor versions may add some
+    payload.fill(0);
+
+    return item;
+}
+
+QVariantList BinaryBackupReader::readItems(int maxItems)
+{
+    QVariantList items;
+
+    while (items.count() < maxItems && !m_atEnd) {
+        if (m_map) {
+            if (m_next >= m_index.count()) {
+                m_atEnd = true;
+                break;
+            }
+            // Keeps the device position meaningful for the progress reporting
+            m_device->seek(m_index[m_next].offset);
+            const QVariantMap item = readMappedItem(m_next++);
+            if (!item.isEmpty()) {
+                items.append(item);
+            }
+            continue;
+        }
+
+        bool isItem = false;
+        const QVariantMap item = readNextRecord(&isItem);
+        if (isItem) {
+            items.append(item);
+        }
+    }
+
+    if (hasError()) {
+        items.clear();
+    }
+    return items;
+}
+
+bool BinaryBackupReader::atEnd() const
+{
+    return m_atEnd;
+}
+
+QString BinaryBackupReader::errorString() const
+{
+    return m_error;
+}
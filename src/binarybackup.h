@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "itemreader.h"
+#include "itemwriter.h"
+
+#include <QList>
+#include <QStringList>
+
+class QDataStream;
+class QFile;
+class QIODevice;
+
+/**
+ * Compact backup format. All integers are big endian, strings and byte
+ * arrays are serialized with QDataStream (Qt 6.0 format).
+ *
+ * header:  "KSBACKUP" quint16 version, quint16 flags
+ * records: quint8 type, quint32 payload size, payload
+ *          - Section: the name of the wallet the following items belong to
+ *          - Item: label, contentType, folder, attributes, secret,
+ *                  passed through qCompress() if the Compressed flag is set
+ *          - Index: the section names, then for every item its section,
+ *                   the offset of its record and its label
+ * footer:  quint64 offset of the index record, "KSBINDEX"
+ *
+ * The index makes it possible to read a single item out of a memory
+ * mapped file, without decoding any of the others.
+ */
+namespace BinaryBackup
+{
+enum Flag : quint16 {
+    NoFlags = 0,
+    Compressed = 1,
+};
+
+// True if the device starts with the backup magic, doesn't consume any data
+bool isBinaryBackup(QIODevice *device);
+
+// Shared with the other binary formats (see BackupJournalWriter)
+void setupStream(QDataStream &stream);
+void writeItemFields(QDataStream &stream, const QVariantMap &item);
+// Returns false if the stream is corrupted
+bool readItemFields(QDataStream &stream, QVariantMap *item);
+}
+
+class BinaryBackupWriter : public ItemWriter
+{
+public:
+    BinaryBackupWriter(QIODevice *device, bool compress);
+
+    void beginWallet(const QString &walletName) override;
+    void writeItem(const QVariantMap &item) override;
+    void endWallet() override;
+    void finish() override;
+    bool hasError() const override;
+
+private:
+    struct IndexEntry {
+        quint32 section;
+        quint64 offset;
+        QString label;
+    };
+
+    void writeRecord(quint8 type, const QByteArray &payload);
+
+    QIODevice *m_device;
+    bool m_compress;
+    bool m_error = false;
+    // Tracked here rather than asked to the device, which may not be seekable
+    quint64 m_offset = 0;
+    QStringList m_sections;
+    QList<IndexEntry> m_index;
+};
+
+class BinaryBackupReader : public ItemReader
+{
+public:
+    // If the device is a QFile it gets memory mapped and the index is used,
+    // otherwise the records are read sequentially
+    explicit BinaryBackupReader(QIODevice *device);
+    ~BinaryBackupReader() override;
+
+    QVariantList readItems(int maxItems) override;
+    bool atEnd() const override;
+    QString errorString() const override;
+
+    // Random access, available only when the file could be mapped
+    bool hasIndex() const;
+    int count() const;
+    QString labelAt(int index) const;
+    QString walletAt(int index) const;
+    QVariantMap itemAt(int index);
+
+private:
+    struct IndexEntry {
+        quint32 section;
+        quint64 offset;
+        QString label;
+    };
+
+    bool readHeader(const QByteArray &header);
+    bool mapIndex(QFile *file);
+    QVariantMap decodeItem(const QByteArray &payload, const QString &wallet);
+    QVariantMap readMappedItem(int index);
+    QVariantMap readNextRecord(bool *isItem);
+    void setError(const QString &message);
+
+    QIODevice *m_device;
+    QFile *m_mappedFile = nullptr;
+    const uchar *m_map = nullptr;
+    qint64 m_mapSize = 0;
+
+    quint16 m_flags = BinaryBackup::NoFlags;
+    QStringList m_sections;
+    QList<IndexEntry> m_index;
+    QString m_currentSection;
+    int m_next = 0;
+    QString m_error;
+    bool m_atEnd = false;
+};
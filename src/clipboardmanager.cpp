@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "clipboardmanager.h"
+#include "keepsecret_debug.h"
+
+#include <QClipboard>
+#include <QGuiApplication>
+#include <QMimeData>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <memory>
+
+static const QString s_tokenMimeType = QStringLiteral("application/x-keepsecret-token");
+
+class ClipboardManagerSingleton
+{
+public:
+    ClipboardManagerSingleton();
+    std::unique_ptr<ClipboardManager> clipboardManager;
+};
+
+ClipboardManagerSingleton::ClipboardManagerSingleton()
+    : clipboardManager(std::make_unique<ClipboardManager>())
+{
+}
+
+Q_GLOBAL_STATIC(ClipboardManagerSingleton, s_clipboardManager)
+
+ClipboardManager::ClipboardManager(QObject *parent)
+    : QObject(parent)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &ClipboardManager::expire);
+
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &ClipboardManager::clearAll);
+}
+
+ClipboardManager::~ClipboardManager()
+{
+}
+
+ClipboardManager *ClipboardManager::instance()
+{
+    return s_clipboardManager->clipboardManager.get();
+}
+
+QByteArray ClipboardManager::copy(const QString &text, std::chrono::seconds timeout)
+{
+    quint64 random[2];
+    QRandomGenerator::system()->fillRange(random);
+    const QByteArray token = QByteArray(reinterpret_cast<const char *>(random), sizeof(random)).toHex();
+
+    auto *mimeData = new QMimeData();
+    mimeData->setText(text);
+    mimeData->setData(QStringLiteral("x-kde-passwordManagerHint"), QByteArrayLiteral("secret"));
+    mimeData->setData(s_tokenMimeType, token);
+    qApp->clipboard()->setMimeData(mimeData);
+
+    m_pending.append({token, QDeadlineTimer(timeout)});
+    scheduleNext();
+    Q_EMIT pendingCountChanged();
+
+    return token;
+}
+
+QByteArray ClipboardManager::copy(const QString &text, int timeoutSeconds)
+{
+    return copy(text, std::chrono::seconds(timeoutSeconds));
+}
+
+void ClipboardManager::clear(const QByteArray &token)
+{
+    for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+        if (it->token == token) {
+            it->deadline = QDeadlineTimer(0);
+            break;
+        }
+    }
+    expire();
+}
+
+int ClipboardManager::pendingCount() const
+{
+    return m_pending.count();
+}
+
+bool ClipboardManager::clipboardHasToken(const QByteArray &token) const
+{
+    const QMimeData *mimeData = qApp->clipboard()->mimeData();
+    return mimeData && mimeData->data(s_tokenMimeType) == token;
+}
+
+void ClipboardManager::expire()
+{
+    QList<QByteArray> expired;
+
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (it->deadline.hasExpired()) {
+            // Someone else may have put something new on the clipboard in the meantime
+            if (clipboardHasToken(it->token)) {
+                qApp->clipboard()->clear();
+            }
+            expired << it->token;
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    scheduleNext();
+
+    if (expired.isEmpty()) {
+        return;
+    }
+    for (const QByteArray &token : std::as_const(expired)) {
+        Q_EMIT cleared(token);
+    }
+    Q_EMIT pendingCountChanged();
+}
+
+void ClipboardManager::scheduleNext()
+{
+    if (m_pending.isEmpty()) {
+        m_timer->stop();
+        return;
+    }
+
+    QDeadlineTimer next = m_pending.first().deadline;
+    for (const PendingCopy &pending : std::as_const(m_pending)) {
+        next = qMin(next, pending.deadline);
+    }
+
+    m_timer->start(std::chrono::ceil<std::chrono::milliseconds>(next.remainingTimeAsDuration()));
+}
+
+void ClipboardManager::clearAll()
+{
+    for (PendingCopy &pending : m_pending) {
+        pending.deadline = QDeadlineTimer(0);
+    }
+    expire();
+}
+
+#include "moc_clipboardmanager.cpp"
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include <QDeadlineTimer>
+#include <QObject>
+#include <chrono>
+#include <qqmlregistration.h>
+
+class QTimer;
+
+/**
+ * Puts secrets on the clipboard and removes them after a timeout.
+ * Every copy is tagged with a random token stored in the mime data, the
+ * clipboard is cleared only if it still carries that token. A single
+ * timer is armed for the earliest deadline, and only while a copy is pending.
+ */
+class ClipboardManager : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Cannot create elements of type ClipboardManager")
+
+    Q_PROPERTY(int pendingCount READ pendingCount NOTIFY pendingCountChanged)
+
+public:
+    explicit ClipboardManager(QObject *parent = nullptr);
+    ~ClipboardManager() override;
+
+    static ClipboardManager *instance();
+
+    // Returns the token identifying this copy, used by cleared()
+    QByteArray copy(const QString &text, std::chrono::seconds timeout);
+    Q_INVOKABLE QByteArray copy(const QString &text, int timeoutSeconds);
+
+    // Removes the copy right away if it's still on the clipboard
+    Q_INVOKABLE void clear(const QByteArray &token);
+
+    int pendingCount() const;
+
+Q_SIGNALS:
+    void cleared(const QByteArray &token);
+    void pendingCountChanged();
+
+private:
+    struct PendingCopy {
+        QByteArray token;
+        QDeadlineTimer deadline;
+    };
+
+    bool clipboardHasToken(const QByteArray &token) const;
+    void expire();
+    void scheduleNext();
+    void clearAll();
+
+    QList<PendingCopy> m_pending;
+    QTimer *m_timer = nullptr;
+};
@@ -2,23 +2,31 @@
 // SPDX-FileCopyrightText: 2025 Marco Martin <notmart@gmail.com>
 
 #include "collectionmodel.h"
+#include "keepsecret_debug.h"
+#include "latencystats.h"
 #include "secretserviceclient.h"
 #include "statetracker.h"
+#include "tracing.h"
 
-#include <KConfig>
-#include <KConfigGroup>
 #include <KLocalizedString>
-#include <KSharedConfig>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QHash>
+#include <QPointer>
+#include <QSet>
+#include <optional>
+#include <utility>
+
+// How many delete and create requests we hand to the SecretServiceClient at once,
+// which in turn runs them in its background request slots
+static constexpr int s_maxDeletesInFlight = 4;
+static constexpr int s_maxCreatesInFlight = 8;
 
 CollectionModel::CollectionModel(SecretServiceClient *secretServiceClient, QObject *parent)
     : QAbstractListModel(parent)
     , m_secretServiceClient(secretServiceClient)
 {
     connect(StateTracker::instance(), &StateTracker::serviceConnectedChanged, this, [this](bool connected) {
-        if (m_currentCollectionPath.isEmpty()) {
-            KConfigGroup windowGroup(KSharedConfig::openStateConfig(), QStringLiteral("MainWindow"));
-            setCollectionPath(windowGroup.readEntry(QStringLiteral("CurrentCollectionPath"), QString()));
-        }
         if (m_currentCollectionPath.isEmpty()) {
             const auto &collections = m_secretServiceClient->listCollections();
 
@@ -30,6 +38,7 @@ CollectionModel::CollectionModel(SecretServiceClient *secretServiceClient, QObje
         if (connected) {
             loadWallet();
         } else {
+            m_itemsReady = false;
             beginResetModel();
             m_items.clear();
             endResetModel();
@@ -56,15 +65,13 @@ CollectionModel::CollectionModel(SecretServiceClient *secretServiceClient, QObje
             loadWallet();
         }
     });
-
-    if (StateTracker::instance()->status() & StateTracker::ServiceConnected) {
-        KConfigGroup windowGroup(KSharedConfig::openStateConfig(), QStringLiteral("MainWindow"));
-        setCollectionPath(windowGroup.readEntry(QStringLiteral("CurrentCollectionPath"), QString()));
-    }
 }
 
 CollectionModel::~CollectionModel()
 {
+    if (m_notifyHandlerId > 0) {
+        g_signal_handler_disconnect(m_secretCollection.get(), m_notifyHandlerId);
+    }
 }
 
 QString CollectionModel::collectionName() const
@@ -89,21 +96,25 @@ void CollectionModel::setCollectionPath(const QString &collectionPath)
 
     if (m_notifyHandlerId > 0) {
         g_signal_handler_disconnect(m_secretCollection.get(), m_notifyHandlerId);
+        m_notifyHandlerId = 0;
     }
+    // Whatever is still loading is for the collection we are leaving
+    m_loadCanceller.cancel();
 
     m_currentCollectionPath = collectionPath;
+    m_itemsReady = false;
+    // Only changes to the new collection are of interest from now on
+    m_itemsChangedWhilePaused = false;
+    dropDeferredImports();
 
-    if (collectionPath.isEmpty()) {
-        beginResetModel();
-        m_items.clear();
-        endResetModel();
-    } else if (StateTracker::instance()->isServiceConnected()) {
+    beginResetModel();
+    m_items.clear();
+    endResetModel();
+
+    if (!collectionPath.isEmpty() && StateTracker::instance()->isServiceConnected()) {
         loadWallet();
     }
 
-    KConfigGroup windowGroup(KSharedConfig::openStateConfig(), QStringLiteral("MainWindow"));
-    windowGroup.writeEntry(QStringLiteral("CurrentCollectionPath"), collectionPath);
-
     Q_EMIT collectionPathChanged(m_currentCollectionPath);
     Q_EMIT collectionNameChanged(collectionName());
 }
@@ -178,9 +189,25 @@ static void onCollectionNotify(SecretCollection *collection, GParamSpec *pspec,
     if (g_strcmp0(pspec->name, "items") != 0) {
         return;
     }
+    Tracing::instant("SecretCollection items changed", "dbus");
 
     CollectionModel *collectionModel = (CollectionModel *)inst;
-    collectionModel->refreshWallet();
+    collectionModel->onItemsChanged();
+}
+
+bool CollectionModel::notificationsPaused() const
+{
+    return m_deleteBatch || m_importBatch;
+}
+
+void CollectionModel::onItemsChanged()
+{
+    if (notificationsPaused()) {
+        m_itemsChangedWhilePaused = true;
+        return;
+    }
+
+    refreshWallet();
 }
 
 void CollectionModel::loadWallet()
@@ -198,6 +225,79 @@ void CollectionModel::loadWallet()
     refreshWallet();
 }
 
+// The items are loaded first, then all their secrets with a single request
+struct LoadRequest {
+    QPointer<CollectionModel> model;
+    SecretCollectionPtr collection;
+    StateTracker::OperationHandle operation;
+    GCancellablePtr cancellable;
+    QList<SecretItemPtr> items;
+    SecretServiceClient::RequestSlot slot;
+    // Started with each request, not counting the time in the queue
+    std::optional<LatencyTimer> latency;
+    std::optional<LatencyTimer> refreshLatency;
+};
+
+static void onCollectionSecretsLoaded(GObject *source, GAsyncResult *result, gpointer data)
+{
+    Q_UNUSED(source);
+    std::unique_ptr<LoadRequest> request(static_cast<LoadRequest *>(data));
+    GError *error = nullptr;
+    QString message;
+
+    secret_item_load_secrets_finish(result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error) || !request->model) {
+        g_clear_error(&error);
+        return;
+    }
+
+    const bool success = SecretServiceClient::wasErrorFree(&error, message);
+    request->model->itemsLoaded(request->items, success, message);
+}
+
+static void onCollectionItemsLoaded(GObject *source, GAsyncResult *result, gpointer data)
+{
+    std::unique_ptr<LoadRequest> request(static_cast<LoadRequest *>(data));
+    GError *error = nullptr;
+    QString message;
+
+    secret_collection_load_items_finish((SecretCollection *)source, result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error) || !request->model) {
+        g_clear_error(&error);
+        return;
+    }
+
+    if (!SecretServiceClient::wasErrorFree(&error, message)) {
+        request->model->itemsLoaded({}, false, message);
+        return;
+    }
+
+    GListPtr list = GListPtr(secret_collection_get_items(request->collection.get()));
+    for (GList *l = list.get(); l != nullptr; l = l->next) {
+        request->items.append(SecretItemPtr(SECRET_ITEM(l->data)));
+    }
+    if (request->items.isEmpty()) {
+        request->model->itemsLoaded(request->items, true, QString());
+        return;
+    }
+
+    // The list doesn't own the items, the request keeps them alive until it's done
+    GList *items = nullptr;
+    for (const SecretItemPtr &item : std::as_const(request->items)) {
+        items = g_list_prepend(items, item.get());
+    }
+    GListPtr secretsList = GListPtr(g_list_reverse(items));
+
+    // The same slot is kept for both requests
+    request->latency.emplace("secret_item_load_secrets");
+    LoadRequest *secretsRequest = request.release();
+    secret_item_load_secrets(secretsList.get(), secretsRequest->cancellable.get(), onCollectionSecretsLoaded, secretsRequest);
+}
+
 void CollectionModel::refreshWallet()
 {
     if (!m_secretCollection) {
@@ -206,89 +306,116 @@ void CollectionModel::refreshWallet()
 
     if (m_notifyHandlerId > 0) {
         g_signal_handler_disconnect(m_secretCollection.get(), m_notifyHandlerId);
+        m_notifyHandlerId = 0;
     }
+    // A previous load would deliver outdated items
+    m_loadCanceller.cancel();
+    m_itemsReady = false;
 
     StateTracker::instance()->clearError();
 
     StateTracker::instance()->clearState(StateTracker::CollectionLocked);
     StateTracker::instance()->clearState(StateTracker::CollectionReady);
-    beginResetModel();
-    m_items.clear();
 
     if (secret_collection_get_locked(m_secretCollection.get())) {
-        StateTracker::instance()->setState(StateTracker::CollectionLocked);
+        beginResetModel();
+        m_items.clear();
         endResetModel();
+        StateTracker::instance()->setState(StateTracker::CollectionLocked);
         return;
     }
 
-    GError *error = nullptr;
-    secret_collection_load_items_sync(m_secretCollection.get(), nullptr, &error);
+    // Taken before reading, so that anything changed meanwhile is newer
+    m_loadedAt = QDateTime::currentSecsSinceEpoch();
 
-    if (error) {
-        StateTracker::instance()->setError(StateTracker::CollectionLoadError, QString::fromUtf8(error->message));
-        g_error_free(error);
-        endResetModel();
+    // The current items stay in the model until the new ones are there
+    auto *request = new LoadRequest{this,
+                                    SecretCollectionPtr(SECRET_COLLECTION(g_object_ref(m_secretCollection.get()))),
+                                    StateTracker::instance()->beginOperation(StateTracker::CollectionLoading),
+                                    m_loadCanceller.ref()};
+    request->refreshLatency.emplace("CollectionModel::refreshWallet");
+    m_secretServiceClient->scheduleRequest(SecretServiceClient::InteractivePriority, [request](SecretServiceClient::RequestSlot slot) {
+        request->slot = std::move(slot);
+        request->latency.emplace("secret_collection_load_items");
+        secret_collection_load_items(request->collection.get(), request->cancellable.get(), onCollectionItemsLoaded, request);
+    });
+}
+
+void CollectionModel::itemsLoaded(const QList<SecretItemPtr> &items, bool success, const QString &message)
+{
+    if (!success) {
+        StateTracker::instance()->setError(StateTracker::CollectionLoadError, message);
+        if (!m_items.isEmpty()) {
+            beginRemoveRows(QModelIndex(), 0, m_items.count() - 1);
+            m_items.clear();
+            endRemoveRows();
+        }
         return;
     }
 
-    GListPtr list = GListPtr(secret_collection_get_items(m_secretCollection.get()));
-    if (list) {
-        for (GList *l = list.get(); l != nullptr; l = l->next) {
-            SecretItemPtr item = SecretItemPtr(SECRET_ITEM(l->data));
-            Entry entry;
-            entry.label = QString::fromUtf8(secret_item_get_label(item.get()));
-            entry.dbusPath = QString::fromUtf8(g_dbus_proxy_get_object_path(G_DBUS_PROXY(item.get())));
-            entry.folder = QString();
-            GHashTablePtr attributes = GHashTablePtr(secret_item_get_attributes(item.get()));
-
-            // Retrieve "server" value
-            const char *server = static_cast<gchar *>(g_hash_table_lookup(attributes.get(), "server"));
-            if (server) {
-                entry.folder = QString::fromUtf8(server);
-            } else {
-                // If there is no "server", try with "service"
-                const char *service = static_cast<gchar *>(g_hash_table_lookup(attributes.get(), "service"));
-                if (service) {
-                    entry.folder = QString::fromUtf8(service);
-                }
-            }
-            if (entry.folder.isEmpty()) {
-                entry.folder = i18nc("@info Other type of secret", "Other");
-            }
-            
-            // Load secret value
-            GError *secretError = nullptr;
-            secret_item_load_secret_sync(item.get(), nullptr, &secretError);
-            if (!secretError) {
-                SecretValuePtr sv = SecretValuePtr(secret_item_get_secret(item.get()));
-                if (sv) {
-                    gsize length = 0;
-                    const gchar *pw = secret_value_get(sv.get(), &length);
-                    entry.secret = QByteArray(pw, length);
-                    entry.contentType = QString::fromUtf8(secret_value_get_content_type(sv.get()));
-                }
-            } else {
-                g_error_free(secretError);
-            }
-            
-            // Store all attributes
-            GHashTableIter iter;
-            gpointer key, value;
-            g_hash_table_iter_init(&iter, attributes.get());
-            while (g_hash_table_iter_next(&iter, &key, &value)) {
-                entry.attributes[QString::fromUtf8(static_cast<const gchar *>(key))] = 
-                QString::fromUtf8(static_cast<const gchar *>(value));
-            }
-            
-            m_items << entry;
-        }
+    QList<Entry> entries;
+    entries.reserve(items.count());
+    for (const SecretItemPtr &item : items) {
+        // Secrets already loaded by secret_item_load_secrets()
+        entries << entryForItem(item.get());
     }
+    // A reload keeps the rows which are still there, and the views' state with them
+    updateEntries(std::move(entries));
 
     StateTracker::instance()->setState(StateTracker::CollectionReady);
-
-    endResetModel();
+    m_itemsReady = true;
 
     m_notifyHandlerId = g_signal_connect(m_secretCollection.get(), "notify", G_CALLBACK(onCollectionNotify), this);
+
+    if (!m_deferredImports.isEmpty()) {
+        importChunk(std::exchange(m_deferredImports, {}));
+        if (std::exchange(m_deferredImportEnded, false)) {
+            endImport();
+        }
+    }
+}
+
+CollectionModel::Entry CollectionModel::entryForItem(SecretItem *item)
+{
+    Entry entry;
+    entry.label = QString::fromUtf8(secret_item_get_label(item));
+    entry.dbusPath = QString::fromUtf8(g_dbus_proxy_get_object_path(G_DBUS_PROXY(item)));
+    entry.folder = QString();
+    entry.modified = secret_item_get_modified(item);
+    GHashTablePtr attributes = GHashTablePtr(secret_item_get_attributes(item));
+
+    // Retrieve "server" value
+    const char *server = static_cast<gchar *>(g_hash_table_lookup(attributes.get(), "server"));
+    if (server) {
+        entry.folder = QString::fromUtf8(server);
+    } else {
+        // If there is no "server", try with "service"
+        const char *service = static_cast<gchar *>(g_hash_table_lookup(attributes.get(), "service"));
+        if (service) {
+            entry.folder = QString::fromUtf8(service);
+        }
+    }
+    if (entry.folder.isEmpty()) {
+        entry.folder = i18nc("@info Other type of secret", "Other");
+    }
+
+    SecretValuePtr sv = SecretValuePtr(secret_item_get_secret(item));
+    if (sv) {
+        gsize length = 0;
+        const gchar *pw = secret_value_get(sv.get(), &length);
+        entry.secret = QByteArray(pw, length);
+        entry.contentType = QString::fromUtf8(secret_value_get_content_type(sv.get()));
+    }
+
+    // Store all attributes
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, attributes.get());
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        entry.attributes[QString::fromUtf8(static_cast<const gchar *>(key))] = QString::fromUtf8(static_cast<const gchar *>(value));
+    }
+
+    return entry;
 }
 
 QVariantList CollectionModel::exportItems()
@@ -306,6 +433,717 @@ QVariantList CollectionModel::exportItems()
     return result;
 }
 
+QVariantList CollectionModel::exportItemsModifiedSince(qint64 modifiedSince) const
+{
+    QVariantList result;
+    for (const Entry &e : m_items) {
+        if (qint64(e.modified) < modifiedSince) {
+            continue;
+        }
+        result.append(changedItemMap(e));
+    }
+    return result;
+}
+
+QVariantMap CollectionModel::changedItemMap(const Entry &e)
+{
+    QVariantMap entry;
+    entry[QStringLiteral("label")] = e.label;
+    entry[QStringLiteral("secret")] = e.secret;
+    entry[QStringLiteral("contentType")] = e.contentType;
+    entry[QStringLiteral("attributes")] = e.attributes;
+    entry[QStringLiteral("folder")] = e.folder;
+    entry[QStringLiteral("dbusPath")] = e.dbusPath;
+    entry[QStringLiteral("modified")] = e.modified;
+    return entry;
+}
+
+QStringList CollectionModel::dbusPaths() const
+{
+    QStringList paths;
+    paths.reserve(m_items.count());
+    for (const Entry &e : m_items) {
+        paths << e.dbusPath;
+    }
+    return paths;
+}
+
+qint64 CollectionModel::loadedAt() const
+{
+    return m_loadedAt;
+}
+
+// Like LoadRequest, but the secrets are loaded only for the changed items
+struct ChangedItemsRequest {
+    QPointer<CollectionModel> model;
+    QString collectionPath;
+    SecretCollectionPtr collection;
+    qint64 modifiedSince;
+    qint64 backupPoint;
+    StateTracker::OperationHandle operation;
+    GCancellablePtr cancellable;
+    QList<SecretItemPtr> changed;
+    QStringList dbusPaths;
+    SecretServiceClient::RequestSlot slot;
+    // Started with each request, not counting the time in the queue
+    std::optional<LatencyTimer> latency;
+};
+
+static void onChangedSecretsLoaded(GObject *source, GAsyncResult *result, gpointer data)
+{
+    Q_UNUSED(source);
+    std::unique_ptr<ChangedItemsRequest> request(static_cast<ChangedItemsRequest *>(data));
+    GError *error = nullptr;
+    QString message;
+
+    secret_item_load_secrets_finish(result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error) || !request->model) {
+        g_clear_error(&error);
+        return;
+    }
+
+    const bool success = SecretServiceClient::wasErrorFree(&error, message);
+    request->model->changedItemsRead(request->collectionPath, request->changed, request->dbusPaths, request->backupPoint, success, message);
+}
+
+static void onChangedItemsListed(GObject *source, GAsyncResult *result, gpointer data)
+{
+    std::unique_ptr<ChangedItemsRequest> request(static_cast<ChangedItemsRequest *>(data));
+    GError *error = nullptr;
+    QString message;
+
+    secret_collection_load_items_finish((SecretCollection *)source, result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error) || !request->model) {
+        g_clear_error(&error);
+        return;
+    }
+
+    if (!SecretServiceClient::wasErrorFree(&error, message)) {
+        request->model->changedItemsRead(request->collectionPath, {}, {}, request->backupPoint, false, message);
+        return;
+    }
+
+    // The modification time comes with the item, the secret needs a request
+    GList *changed = nullptr;
+    GListPtr list = GListPtr(secret_collection_get_items(request->collection.get()));
+    for (GList *l = list.get(); l != nullptr; l = l->next) {
+        SecretItemPtr item = SecretItemPtr(SECRET_ITEM(l->data));
+        request->dbusPaths << QString::fromUtf8(g_dbus_proxy_get_object_path(G_DBUS_PROXY(item.get())));
+        if (qint64(secret_item_get_modified(item.get())) >= request->modifiedSince) {
+            changed = g_list_prepend(changed, item.get());
+            request->changed.append(std::move(item));
+        }
+    }
+    if (request->changed.isEmpty()) {
+        request->model->changedItemsRead(request->collectionPath, {}, request->dbusPaths, request->backupPoint, true, QString());
+        return;
+    }
+
+    // The list doesn't own the items, the request keeps them alive until it's done
+    GListPtr secretsList = GListPtr(g_list_reverse(changed));
+
+    // The same slot is kept for both requests
+    request->latency.emplace("secret_item_load_secrets");
+    ChangedItemsRequest *secretsRequest = request.release();
+    secret_item_load_secrets(secretsList.get(), secretsRequest->cancellable.get(), onChangedSecretsLoaded, secretsRequest);
+}
+
+void CollectionModel::loadChangedItems(qint64 modifiedSince)
+{
+    if (!m_secretCollection) {
+        return;
+    }
+
+    // Taken before reading, so that anything changed meanwhile goes in the next backup
+    auto *request = new ChangedItemsRequest{this,
+                                            m_currentCollectionPath,
+                                            SecretCollectionPtr(SECRET_COLLECTION(g_object_ref(m_secretCollection.get()))),
+                                            modifiedSince,
+                                            QDateTime::currentSecsSinceEpoch(),
+                                            StateTracker::instance()->beginOperation(StateTracker::CollectionLoading),
+                                            m_canceller.ref()};
+    m_secretServiceClient->scheduleRequest(SecretServiceClient::BackgroundPriority, [request](SecretServiceClient::RequestSlot slot) {
+        request->slot = std::move(slot);
+        request->latency.emplace("secret_collection_load_items");
+        secret_collection_load_items(request->collection.get(), request->cancellable.get(), onChangedItemsListed, request);
+    });
+}
+
+void CollectionModel::changedItemsRead(const QString &collectionPath,
+                                       const QList<SecretItemPtr> &changed,
+                                       const QStringList &dbusPaths,
+                                       qint64 backupPoint,
+                                       bool success,
+                                       const QString &message)
+{
+    if (!success) {
+        StateTracker::instance()->setError(StateTracker::CollectionLoadError, message);
+        return;
+    }
+
+    QVariantList items;
+    items.reserve(changed.count());
+    for (const SecretItemPtr &item : changed) {
+        items.append(changedItemMap(entryForItem(item.get())));
+    }
+    Q_EMIT changedItemsLoaded(collectionPath, items, dbusPaths, backupPoint);
+}
+
+struct DeleteRequest {
+    QPointer<CollectionModel> model;
+    QString dbusPath;
+    SecretItemPtr item;
+    GCancellablePtr cancellable;
+    SecretServiceClient::RequestSlot slot;
+    // Started with the request, not counting the time in the queue
+    std::optional<LatencyTimer> latency;
+};
+
+static void onBatchDeleteFinished(GObject *source, GAsyncResult *result, gpointer data)
+{
+    std::unique_ptr<DeleteRequest> request(static_cast<DeleteRequest *>(data));
+    GError *error = nullptr;
+    QString message;
+
+    secret_item_delete_finish((SecretItem *)source, result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
+    const bool success = SecretServiceClient::wasErrorFree(&error, message);
+
+    if (request->model) {
+        request->model->deleteItemFinished(request->dbusPath, success, message);
+    }
+}
+
+void CollectionModel::deleteItems(const QStringList &dbusPaths)
+{
+    if (!StateTracker::instance()->isServiceConnected() || !m_secretCollection || dbusPaths.isEmpty()) {
+        return;
+    }
+
+    if (m_deleteBatch) {
+        qCWarning(KEEPSECRET_LOG) << "A delete is already in progress";
+        return;
+    }
+
+    // Look up all the items in a single pass over the collection
+    const QSet<QString> wanted(dbusPaths.begin(), dbusPaths.end());
+    auto batch = std::make_unique<DeleteBatch>();
+    batch->collectionPath = m_currentCollectionPath;
+
+    GListPtr list = GListPtr(secret_collection_get_items(m_secretCollection.get()));
+    for (GList *l = list.get(); l != nullptr; l = l->next) {
+        SecretItemPtr item = SecretItemPtr(SECRET_ITEM(l->data));
+        const QString path = QString::fromUtf8(g_dbus_proxy_get_object_path(G_DBUS_PROXY(item.get())));
+        if (wanted.contains(path)) {
+            batch->queue.append(std::move(item));
+        }
+    }
+
+    if (batch->queue.isEmpty()) {
+        return;
+    }
+
+    batch->total = batch->queue.count();
+    m_deleteBatch = std::move(batch);
+    m_itemsChangedWhilePaused = false;
+
+    StateTracker::instance()->clearError();
+    m_deleteBatch->operation = StateTracker::instance()->beginOperation(StateTracker::ItemDeleting);
+    Q_EMIT deleteProgress(0, m_deleteBatch->total);
+
+    deleteNextItems();
+}
+
+void CollectionModel::deleteNextItems()
+{
+    while (m_deleteBatch->inFlight < s_maxDeletesInFlight && !m_deleteBatch->queue.isEmpty()) {
+        SecretItemPtr item = m_deleteBatch->queue.takeFirst();
+        const QString dbusPath = QString::fromUtf8(g_dbus_proxy_get_object_path(G_DBUS_PROXY(item.get())));
+        auto *request = new DeleteRequest{this, dbusPath, std::move(item), m_canceller.ref()};
+
+        ++m_deleteBatch->inFlight;
+        m_secretServiceClient->scheduleRequest(SecretServiceClient::BackgroundPriority, [request](SecretServiceClient::RequestSlot slot) {
+            request->slot = std::move(slot);
+            request->latency.emplace("secret_item_delete");
+            secret_item_delete(request->item.get(), request->cancellable.get(), onBatchDeleteFinished, request);
+        });
+    }
+}
+
+void CollectionModel::deleteItemFinished(const QString &dbusPath, bool success, const QString &message)
+{
+    if (!m_deleteBatch) {
+        return;
+    }
+
+    --m_deleteBatch->inFlight;
+    ++m_deleteBatch->done;
+    if (success) {
+        m_deleteBatch->deleted << dbusPath;
+    } else {
+        ++m_deleteBatch->failed;
+        m_deleteBatch->lastError = message;
+    }
+
+    Q_EMIT deleteProgress(m_deleteBatch->done, m_deleteBatch->total);
+
+    if (m_deleteBatch->done < m_deleteBatch->total) {
+        deleteNextItems();
+    } else {
+        finishDelete();
+    }
+}
+
+void CollectionModel::finishDelete()
+{
+    std::unique_ptr<DeleteBatch> batch = std::move(m_deleteBatch);
+
+    if (batch->failed > 0) {
+        StateTracker::instance()->setError(StateTracker::ItemDeleteError,
+                                           i18ncp("@info:status",
+                                                  "Failed to delete %1 item: %2",
+                                                  "Failed to delete %1 items: %2",
+                                                  batch->failed,
+                                                  batch->lastError));
+    }
+
+    if (batch->collectionPath == m_currentCollectionPath) {
+        removeEntries(QSet<QString>(batch->deleted.begin(), batch->deleted.end()));
+    }
+
+    // The notifications are for the current collection, which may not be the
+    // one of the batch, and someone else may have changed it meanwhile in a way
+    // a comparison can't see (an item added and one deleted, an item edited):
+    // reload whenever any came
+    if (!m_importBatch && std::exchange(m_itemsChangedWhilePaused, false) && m_secretCollection) {
+        refreshWallet();
+    }
+
+    batch->operation.end();
+    Q_EMIT itemsDeleted(batch->deleted);
+}
+
+void CollectionModel::removeEntries(const QSet<QString> &dbusPaths)
+{
+    if (dbusPaths.isEmpty()) {
+        return;
+    }
+
+    // Remove from the bottom, merging adjacent rows in a single removal
+    int row = m_items.count() - 1;
+    while (row >= 0) {
+        if (!dbusPaths.contains(m_items[row].dbusPath)) {
+            --row;
+            continue;
+        }
+        const int last = row;
+        while (row > 0 && dbusPaths.contains(m_items[row - 1].dbusPath)) {
+            --row;
+        }
+        beginRemoveRows(QModelIndex(), row, last);
+        m_items.remove(row, last - row + 1);
+        endRemoveRows();
+        --row;
+    }
+}
+
+bool CollectionModel::sameEntry(const Entry &a, const Entry &b)
+{
+    return a.modified == b.modified && a.label == b.label && a.folder == b.folder && a.secret == b.secret && a.contentType == b.contentType
+        && a.attributes == b.attributes;
+}
+
+void CollectionModel::updateEntries(QList<Entry> entries)
+{
+    QHash<QString, qsizetype> newRows;
+    newRows.reserve(entries.count());
+    for (qsizetype i = 0; i < entries.count(); ++i) {
+        newRows.insert(entries[i].dbusPath, i);
+    }
+
+    QSet<QString> gone;
+    for (const Entry &entry : std::as_const(m_items)) {
+        if (!newRows.contains(entry.dbusPath)) {
+            gone.insert(entry.dbusPath);
+        }
+    }
+    removeEntries(gone);
+
+    // What is left is still there, update it in place
+    QList<bool> known(entries.count(), false);
+    for (int row = 0; row < m_items.count(); ++row) {
+        const qsizetype i = newRows.value(m_items[row].dbusPath);
+        known[i] = true;
+        if (!sameEntry(m_items[row], entries[i])) {
+            m_items[row] = std::move(entries[i]);
+            Q_EMIT dataChanged(index(row, 0), index(row, 0));
+        }
+    }
+
+    // The views sort the rows, new ones can go at the end
+    QList<Entry> added;
+    for (qsizetype i = 0; i < entries.count(); ++i) {
+        if (!known[i]) {
+            added << std::move(entries[i]);
+        }
+    }
+    if (!added.isEmpty()) {
+        beginInsertRows(QModelIndex(), m_items.count(), m_items.count() + added.count() - 1);
+        m_items.append(std::move(added));
+        endInsertRows();
+    }
+}
+
+struct ImportRequest {
+    QPointer<CollectionModel> model;
+    QString label;
+    SecretCollectionPtr collection;
+    GHashTablePtr attributes;
+    SecretValuePtr secretValue;
+    SecretItemCreateFlags flags;
+    GCancellablePtr cancellable;
+    SecretServiceClient::RequestSlot slot;
+    // Started with the request, not counting the time in the queue
+    std::optional<LatencyTimer> latency;
+};
+
+static void onBatchCreateFinished(GObject *source, GAsyncResult *result, gpointer data)
+{
+    Q_UNUSED(source);
+    std::unique_ptr<ImportRequest> request(static_cast<ImportRequest *>(data));
+    GError *error = nullptr;
+    QString message;
+
+    SecretItemPtr item = SecretItemPtr(secret_item_create_finish(result, &error));
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
+    const bool success = SecretServiceClient::wasErrorFree(&error, message);
+
+    if (request->model) {
+        request->model->importItemFinished(request->label, success, message);
+    }
+}
+
+// Fills in what importNextItems() would add, so that identities match the stored items
+static QVariantMap normalizedImportItem(QVariantMap item)
+{
+    QString contentType = item.value(QStringLiteral("contentType")).toString();
+    QVariantMap attributes = item.value(QStringLiteral("attributes")).toMap();
+
+    if (contentType.isEmpty()) {
+        contentType = QStringLiteral("text/plain");
+    }
+    // Items without a schema are saved as QtKeychain ones, so they can be edited
+    if (!attributes.contains(QStringLiteral("xdg:schema"))) {
+        attributes[QStringLiteral("xdg:schema")] = QStringLiteral("org.qt.keychain");
+    }
+    if (!attributes.contains(QStringLiteral("type"))) {
+        const SecretServiceClient::Type type =
+            contentType == QStringLiteral("application/octet-stream") ? SecretServiceClient::Binary : SecretServiceClient::PlainText;
+        attributes[QStringLiteral("type")] = SecretServiceClient::typeToString(type);
+    }
+
+    item[QStringLiteral("contentType")] = contentType;
+    item[QStringLiteral("attributes")] = attributes;
+    return item;
+}
+
+static QByteArray importIdentity(const QVariantMap &attributes)
+{
+    // QVariantMap is sorted by key, the schema is among the attributes as xdg:schema
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    for (auto it = attributes.constBegin(); it != attributes.constEnd(); ++it) {
+        hash.addData(it.key().toUtf8());
+        hash.addData(QByteArrayView("", 1));
+        hash.addData(it.value().toString().toUtf8());
+        hash.addData(QByteArrayView("", 1));
+    }
+    return hash.result();
+}
+
+static QByteArray importContents(const QString &label, const QString &contentType, const QByteArray &secret)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(label.toUtf8());
+    hash.addData(QByteArrayView("", 1));
+    hash.addData(contentType.toUtf8());
+    hash.addData(QByteArrayView("", 1));
+    hash.addData(secret);
+    return hash.result();
+}
+
+void CollectionModel::buildImportIndex(ImportIndex &index) const
+{
+    index.contents.reserve(m_items.count());
+    for (const Entry &e : m_items) {
+        index.contents.insert(importIdentity(e.attributes), importContents(e.label, e.contentType, e.secret));
+    }
+}
+
+CollectionModel::ImportAction CollectionModel::classifyImport(ImportIndex &index, const QVariantMap &item) const
+{
+    const QByteArray identity = importIdentity(item.value(QStringLiteral("attributes")).toMap());
+    const QByteArray contents = importContents(item.value(QStringLiteral("label")).toString(),
+                                               item.value(QStringLiteral("contentType")).toString(),
+                                               item.value(QStringLiteral("secret")).toByteArray());
+
+    auto it = index.contents.find(identity);
+    if (it == index.contents.end()) {
+        // Duplicates further on in the same import will be skipped
+        index.contents.insert(identity, contents);
+        ++index.created;
+        return ImportCreate;
+    }
+    if (*it == contents) {
+        ++index.skipped;
+        return ImportSkip;
+    }
+    *it = contents;
+    ++index.updated;
+    return ImportUpdate;
+}
+
+void CollectionModel::queueImports(const QVariantList &items)
+{
+    for (const QVariant &variant : items) {
+        const QVariantMap item = normalizedImportItem(variant.toMap());
+        const ImportAction action = classifyImport(m_importBatch->index, item);
+        if (action == ImportSkip) {
+            continue;
+        }
+        m_importBatch->queue.append({item, action == ImportUpdate});
+        ++m_importBatch->total;
+    }
+}
+
+void CollectionModel::importItems(const QVariantList &items)
+{
+    importChunk(items);
+    endImport();
+}
+
+void CollectionModel::importChunk(const QVariantList &items)
+{
+    if (!StateTracker::instance()->isServiceConnected() || !m_secretCollection || items.isEmpty()) {
+        return;
+    }
+
+    if (!m_importBatch && !m_itemsReady) {
+        // Classified against items still loading, everything would look new
+        // and be created again: wait for the load to finish
+        m_deferredImports.append(items);
+        // Still to be written, for the backlog of the parser
+        Q_EMIT importProgress(0, m_deferredImports.count());
+        return;
+    }
+
+    if (m_importBatch) {
+        // Already importing: just queue more
+        queueImports(items);
+        Q_EMIT importProgress(m_importBatch->done, m_importBatch->total);
+        importNextItems();
+        return;
+    }
+
+    m_importBatch = std::make_unique<ImportBatch>();
+    m_importBatch->collectionPath = m_currentCollectionPath;
+    // Keep our own reference, the current collection may change while importing
+    m_importBatch->collection = SecretCollectionPtr(SECRET_COLLECTION(g_object_ref(m_secretCollection.get())));
+    buildImportIndex(m_importBatch->index);
+    queueImports(items);
+    if (!m_deleteBatch) {
+        m_itemsChangedWhilePaused = false;
+    }
+
+    StateTracker::instance()->clearError();
+    m_importBatch->operation = StateTracker::instance()->beginOperation(StateTracker::ItemCreating);
+    Q_EMIT importProgress(0, m_importBatch->total);
+
+    importNextItems();
+}
+
+void CollectionModel::endImport()
+{
+    if (!m_importBatch) {
+        // Still waiting for the collection
+        m_deferredImportEnded = !m_deferredImports.isEmpty();
+        return;
+    }
+
+    m_importBatch->inputEnded = true;
+    if (m_importBatch->inFlight == 0 && m_importBatch->queue.isEmpty()) {
+        finishImport();
+    }
+}
+
+QVariantMap CollectionModel::planImport(const QVariantList &items)
+{
+    if (!m_importPlan) {
+        if (!m_itemsReady) {
+            // Same as importItems(), but the caller needs the result now
+            StateTracker::instance()->setError(StateTracker::CollectionLoadError,
+                                               i18nc("@info:status", "The wallet is still loading, try again once it is open"));
+            return {};
+        }
+        m_importPlan = std::make_unique<ImportIndex>();
+        buildImportIndex(*m_importPlan);
+    }
+
+    for (const QVariant &item : items) {
+        classifyImport(*m_importPlan, normalizedImportItem(item.toMap()));
+    }
+
+    return {{QStringLiteral("created"), m_importPlan->created},
+            {QStringLiteral("updated"), m_importPlan->updated},
+            {QStringLiteral("skipped"), m_importPlan->skipped}};
+}
+
+void CollectionModel::resetImportPlan()
+{
+    m_importPlan.reset();
+}
+
+void CollectionModel::dropDeferredImports()
+{
+    if (m_deferredImports.isEmpty()) {
+        return;
+    }
+
+    const int dropped = m_deferredImports.count();
+    m_deferredImports.clear();
+    m_deferredImportEnded = false;
+    Q_EMIT importProgress(0, 0);
+    Q_EMIT importFinished(0, dropped);
+}
+
+void CollectionModel::cancelImport()
+{
+    if (!m_importBatch) {
+        if (!m_deferredImports.isEmpty()) {
+            m_deferredImports.clear();
+            m_deferredImportEnded = false;
+            Q_EMIT importProgress(0, 0);
+        }
+        return;
+    }
+
+    m_importBatch->total -= m_importBatch->queue.count();
+    m_importBatch->queue.clear();
+    m_importBatch->inputEnded = true;
+    Q_EMIT importProgress(m_importBatch->done, m_importBatch->total);
+
+    if (m_importBatch->inFlight == 0) {
+        finishImport();
+    }
+}
+
+void CollectionModel::importNextItems()
+{
+    while (m_importBatch->inFlight < s_maxCreatesInFlight && !m_importBatch->queue.isEmpty()) {
+        // Already normalized by queueImports()
+        const PendingImport pending = m_importBatch->queue.takeFirst();
+        const QString label = pending.item.value(QStringLiteral("label")).toString();
+        const QByteArray secret = pending.item.value(QStringLiteral("secret")).toByteArray();
+        const QString contentType = pending.item.value(QStringLiteral("contentType")).toString();
+        const QVariantMap attributes = pending.item.value(QStringLiteral("attributes")).toMap();
+
+        GHashTablePtr attributeTable = GHashTablePtr(g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free));
+        for (auto it = attributes.constBegin(); it != attributes.constEnd(); ++it) {
+            g_hash_table_insert(attributeTable.get(), g_strdup(it.key().toUtf8().constData()), g_strdup(it.value().toString().toUtf8().constData()));
+        }
+
+        SecretValuePtr secretValue = SecretValuePtr(secret_value_new(secret.constData(), secret.size(), contentType.toUtf8().constData()));
+
+        // Only updates need the provider to look for the item to replace
+        auto *request = new ImportRequest{this,
+                                          label,
+                                          SecretCollectionPtr(SECRET_COLLECTION(g_object_ref(m_importBatch->collection.get()))),
+                                          std::move(attributeTable),
+                                          std::move(secretValue),
+                                          pending.replace ? SECRET_ITEM_CREATE_REPLACE : SECRET_ITEM_CREATE_NONE,
+                                          m_canceller.ref()};
+
+        ++m_importBatch->inFlight;
+        m_secretServiceClient->scheduleRequest(SecretServiceClient::BackgroundPriority, [request](SecretServiceClient::RequestSlot slot) {
+            request->slot = std::move(slot);
+            request->latency.emplace("secret_item_create");
+            // The schema is already in the attributes as xdg:schema
+            secret_item_create(request->collection.get(),
+                               nullptr,
+                               request->attributes.get(),
+                               request->label.toUtf8().constData(),
+                               request->secretValue.get(),
+                               request->flags,
+                               request->cancellable.get(),
+                               onBatchCreateFinished,
+                               request);
+        });
+    }
+}
+
+void CollectionModel::importItemFinished(const QString &label, bool success, const QString &message)
+{
+    if (!m_importBatch) {
+        return;
+    }
+
+    --m_importBatch->inFlight;
+    ++m_importBatch->done;
+    if (!success) {
+        ++m_importBatch->failed;
+        m_importBatch->lastError = message;
+        Q_EMIT importItemFailed(label, message);
+    }
+
+    Q_EMIT importProgress(m_importBatch->done, m_importBatch->total);
+
+    if (m_importBatch->done < m_importBatch->total || !m_importBatch->inputEnded) {
+        // More chunks may still come
+        importNextItems();
+    } else {
+        finishImport();
+    }
+}
+
+void CollectionModel::finishImport()
+{
+    std::unique_ptr<ImportBatch> batch = std::move(m_importBatch);
+
+    if (batch->failed > 0) {
+        StateTracker::instance()->setError(StateTracker::ItemCreationError,
+                                           i18ncp("@info:status",
+                                                  "Failed to import %1 item: %2",
+                                                  "Failed to import %1 items: %2",
+                                                  batch->failed,
+                                                  batch->lastError));
+    }
+
+    batch->operation.end();
+
+    if (!m_deleteBatch) {
+        // The notifications that came are for the current collection, see finishDelete()
+        // Nothing to reload if every item was already there
+        const bool changedWhilePaused = std::exchange(m_itemsChangedWhilePaused, false);
+        if (((batch->collectionPath == m_currentCollectionPath && batch->done > 0) || changedWhilePaused) && m_secretCollection) {
+            refreshWallet();
+        }
+    }
+
+    Q_EMIT importFinished(batch->done - batch->failed, batch->failed);
+    Q_EMIT importSummary(batch->index.created, batch->index.updated, batch->index.skipped, batch->failed);
+}
+
 QString CollectionModel::dbusPathAt(int row) const
 {
     if (row < 0 || row >= m_items.count()) {
@@ -4,8 +4,10 @@
 #pragma once
 
 #include "secretserviceclient.h"
-#include <QVariantMap>
+#include "statetracker.h"
 #include <QAbstractListModel>
+#include <QSet>
+#include <QVariantMap>
 
 class SecretServiceClient;
 
@@ -33,7 +35,44 @@ public:
     QString collectionPath() const;
     void setCollectionPath(const QString &collectionPath);
 
+    // Reloads the items asynchronously, the current ones stay in the model until then
     void refreshWallet();
+    // Called by libsecret when the items of the collection changed
+    void onItemsChanged();
+
+    // Deletes all the given items, with a bounded amount of requests in flight at once.
+    // The model is updated once when all of them are done
+    Q_INVOKABLE void deleteItems(const QStringList &dbusPaths);
+    // Creates all the given items (maps in the format of exportItems()) in the collection,
+    // with a bounded amount of requests in flight. The model is reloaded once at the
+    // end, if anything was written. While the collection is loading the items wait
+    // for it, to be compared with the existing ones
+    Q_INVOKABLE void importItems(const QVariantList &items);
+    // Like importItems() for the chunks of a file: they all go in the same import,
+    // which finishes and reports once after endImport(). Items waiting for the
+    // collection to load count as not written yet in importProgress()
+    Q_INVOKABLE void importChunk(const QVariantList &items);
+    // No more chunks are coming, the import finishes when the queued items are written
+    Q_INVOKABLE void endImport();
+    // Drops the items still waiting to be written, the ones in flight are completed
+    Q_INVOKABLE void cancelImport();
+    // Dry run of importItems(): classifies the items without writing anything.
+    // Can be called repeatedly for the chunks of a file, returns the totals so far
+    // in a map with the keys created, updated and skipped. Fails with an empty map
+    // if the first chunk comes while the collection is loading
+    Q_INVOKABLE QVariantMap planImport(const QVariantList &items);
+    Q_INVOKABLE void resetImportPlan();
+
+    // For the static libsecret handlers
+    void itemsLoaded(const QList<SecretItemPtr> &items, bool success, const QString &message);
+    void deleteItemFinished(const QString &dbusPath, bool success, const QString &message);
+    void importItemFinished(const QString &label, bool success, const QString &message);
+    void changedItemsRead(const QString &collectionPath,
+                          const QList<SecretItemPtr> &changed,
+                          const QStringList &dbusPaths,
+                          qint64 backupPoint,
+                          bool success,
+                          const QString &message);
 
     Q_INVOKABLE void lock();
     Q_INVOKABLE void unlock();
@@ -42,15 +81,48 @@ public:
     QHash<int, QByteArray> roleNames() const override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     Q_INVOKABLE QVariantList exportItems();
+    // Only the items modified at or after the given time, in seconds since the epoch.
+    // Besides the keys of exportItems() these have dbusPath and modified
+    Q_INVOKABLE QVariantList exportItemsModifiedSince(qint64 modifiedSince) const;
+    Q_INVOKABLE QStringList dbusPaths() const;
+    // When the items were last read from the service, in seconds since the epoch
+    Q_INVOKABLE qint64 loadedAt() const;
+    // Reads the items of the current collection again from the service, with the
+    // secrets of only the ones modified at or after the given time: for an incremental
+    // backup, which this way doesn't depend on the items loaded in the model.
+    // Answers with changedItemsLoaded()
+    Q_INVOKABLE void loadChangedItems(qint64 modifiedSince);
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
 
 Q_SIGNALS:
     void collectionNameChanged(const QString &name);
     void collectionPathChanged(const QString &collectionPath);
     bool lockedChanged(bool locked);
+    void deleteProgress(int done, int total);
+    void itemsDeleted(const QStringList &dbusPaths);
+    void importProgress(int done, int total);
+    void importItemFailed(const QString &label, const QString &message);
+    void importFinished(int imported, int failed);
+    // Identical items are skipped, items with the same attributes but different
+    // contents are updated, the others are created
+    void importSummary(int created, int updated, int skipped, int failed);
+    // items are in the format of exportItemsModifiedSince(), dbusPaths are all the items
+    // of the collection and backupPoint is when the reading started
+    void changedItemsLoaded(const QString &collectionPath, const QVariantList &items, const QStringList &dbusPaths, qint64 backupPoint);
 
 protected:
     void loadWallet();
+    void deleteNextItems();
+    void finishDelete();
+    void removeEntries(const QSet<QString> &dbusPaths);
+    // Replaces m_items signalling only the rows which changed
+    void updateEntries(QList<Entry> entries);
+    void queueImports(const QVariantList &items);
+    void importNextItems();
+    void finishImport();
+    // For the previous collection, counted as failed
+    void dropDeferredImports();
+    bool notificationsPaused() const;
 
 private:
     struct Entry {
@@ -60,10 +132,80 @@ private:
         QByteArray secret;
         QString contentType;
         QVariantMap attributes;
+        quint64 modified = 0;
+    };
+    struct DeleteBatch {
+        StateTracker::OperationHandle operation;
+        QString collectionPath;
+        QList<SecretItemPtr> queue;
+        QStringList deleted;
+        QString lastError;
+        int total = 0;
+        int done = 0;
+        int failed = 0;
+        int inFlight = 0;
+    };
+    // Existing items by identity (a digest of schema and attributes),
+    // with a digest of their contents. Built in a single pass over m_items
+    struct ImportIndex {
+        QHash<QByteArray, QByteArray> contents;
+        int created = 0;
+        int updated = 0;
+        int skipped = 0;
     };
+    enum ImportAction {
+        ImportCreate,
+        ImportUpdate,
+        ImportSkip
+    };
+    struct PendingImport {
+        QVariantMap item;
+        bool replace = false;
+    };
+    struct ImportBatch {
+        StateTracker::OperationHandle operation;
+        QString collectionPath;
+        SecretCollectionPtr collection;
+        ImportIndex index;
+        QList<PendingImport> queue;
+        QString lastError;
+        int total = 0;
+        int done = 0;
+        int failed = 0;
+        int inFlight = 0;
+        // endImport() was called
+        bool inputEnded = false;
+    };
+
+    // The item and its secret must be loaded
+    static Entry entryForItem(SecretItem *item);
+    // With the keys of exportItemsModifiedSince()
+    static QVariantMap changedItemMap(const Entry &entry);
+    static bool sameEntry(const Entry &a, const Entry &b);
+    void buildImportIndex(ImportIndex &index) const;
+    ImportAction classifyImport(ImportIndex &index, const QVariantMap &item) const;
+
     QString m_currentCollectionPath;
     QList<Entry> m_items;
+    qint64 m_loadedAt = 0;
+    std::unique_ptr<DeleteBatch> m_deleteBatch;
+    std::unique_ptr<ImportBatch> m_importBatch;
+    std::unique_ptr<ImportIndex> m_importPlan;
+    // m_items is the complete content of the current collection: no load is
+    // running and the last one succeeded
+    bool m_itemsReady = false;
+    // Given to importChunk() before m_itemsReady
+    QVariantList m_deferredImports;
+    // endImport() came for them too
+    bool m_deferredImportEnded = false;
+    // Item change notifications are held back while we are changing a collection ourselves.
+    // They only come for the current collection, so this is reset when switching
+    bool m_itemsChangedWhilePaused = false;
     SecretCollectionPtr m_secretCollection;
     SecretServiceClient *const m_secretServiceClient;
+    // Loading the items, cancelled when leaving the collection or reloading it
+    RequestCanceller m_loadCanceller;
+    // Deleting and importing, cancelled only with the model
+    RequestCanceller m_canceller;
     ulong m_notifyHandlerId = 0;
 };
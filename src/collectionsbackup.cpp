@@ -0,0 +1,268 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "collectionsbackup.h"
+#include "keepsecret_debug.h"
+#include "latencystats.h"
+
+#include <KLocalizedString>
+#include <QPointer>
+#include <optional>
+
+// How many collections are queued for reading at the same time
+static constexpr int s_maxCollectionsInFlight = 3;
+// How many secrets are fetched with a single request
+static constexpr int s_secretsBatchSize = 64;
+
+// The collection and the items are owned by the CollectionsBackup:
+// if it's gone or cancelled before the request gets its slot, the request is dropped
+struct CollectionsBackupRequest {
+    QPointer<CollectionsBackup> backup;
+    int collection;
+    GCancellablePtr cancellable;
+    SecretCollection *secretCollection = nullptr;
+    GListPtr items;
+    SecretServiceClient::RequestSlot slot;
+    // Started with the libsecret call, not counting the time in the queue
+    std::optional<LatencyTimer> latency;
+};
+
+static bool startBackupRequest(CollectionsBackupRequest *request, SecretServiceClient::RequestSlot slot)
+{
+    if (!request->backup || g_cancellable_is_cancelled(request->cancellable.get())) {
+        delete request;
+        return false;
+    }
+    request->slot = std::move(slot);
+    return true;
+}
+
+static void onItemsLoaded(GObject *source, GAsyncResult *result, gpointer data)
+{
+    std::unique_ptr<CollectionsBackupRequest> request(static_cast<CollectionsBackupRequest *>(data));
+    GError *error = nullptr;
+    QString message;
+
+    secret_collection_load_items_finish((SecretCollection *)source, result, &error);
+    request->latency.reset();
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
+    const bool success = SecretServiceClient::wasErrorFree(&error, message);
+
+    if (request->backup) {
+        request->backup->itemsLoaded(request->collection, success, message);
+    }
+}
+
+static void onSecretsLoaded(GObject *source, GAsyncResult *result, gpointer data)
+{
+    Q_UNUSED(source)
+    std::unique_ptr<CollectionsBackupRequest> request(static_cast<CollectionsBackupRequest *>(data));
+    GError *error = nullptr;
+    QString message;
+
+    secret_item_load_secrets_finish(result, &error);
+    request->latency.reset();
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
+    const bool success = SecretServiceClient::wasErrorFree(&error, message);
+
+    if (request->backup) {
+        request->backup->secretsLoaded(request->collection, success, message);
+    }
+}
+
+// Same fields as CollectionModel::exportItems()
+static QVariantMap exportItem(SecretItem *item)
+{
+    GHashTablePtr attributes = GHashTablePtr(secret_item_get_attributes(item));
+
+    QVariantMap attributesMap;
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, attributes.get());
+    while (g_hash_table_iter_next(&iter, &key, &value)) {
+        attributesMap[QString::fromUtf8(static_cast<const gchar *>(key))] = QString::fromUtf8(static_cast<const gchar *>(value));
+    }
+
+    QString folder = attributesMap.value(QStringLiteral("server")).toString();
+    if (folder.isEmpty()) {
+        folder = attributesMap.value(QStringLiteral("service")).toString();
+    }
+    if (folder.isEmpty()) {
+        folder = i18nc("@info Other type of secret", "Other");
+    }
+
+    QByteArray secret;
+    QString contentType;
+    SecretValuePtr secretValue = SecretValuePtr(secret_item_get_secret(item));
+    if (secretValue) {
+        gsize length = 0;
+        const gchar *data = secret_value_get(secretValue.get(), &length);
+        secret = QByteArray(data, length);
+        contentType = QString::fromUtf8(secret_value_get_content_type(secretValue.get()));
+    }
+
+    QVariantMap entry;
+    entry[QStringLiteral("label")] = QString::fromUtf8(secret_item_get_label(item));
+    entry[QStringLiteral("secret")] = secret;
+    entry[QStringLiteral("contentType")] = contentType;
+    entry[QStringLiteral("attributes")] = attributesMap;
+    entry[QStringLiteral("folder")] = folder;
+    return entry;
+}
+
+CollectionsBackup::CollectionsBackup(SecretServiceClient *secretServiceClient, QObject *parent)
+    : QObject(parent)
+    , m_secretServiceClient(secretServiceClient)
+{
+    const auto collections = m_secretServiceClient->listCollections();
+    for (const SecretServiceClient::CollectionEntry &entry : collections) {
+        if (entry.locked) {
+            qCDebug(KEEPSECRET_LOG) << "Skipping locked collection" << entry.name;
+            continue;
+        }
+        PendingCollection collection;
+        collection.name = entry.name;
+        m_collections.push_back(std::move(collection));
+        m_collections.back().collection = SecretCollectionPtr(m_secretServiceClient->retrieveCollection(entry.dbusPath));
+    }
+}
+
+CollectionsBackup::~CollectionsBackup()
+{
+}
+
+int CollectionsBackup::collectionCount() const
+{
+    return m_collections.size();
+}
+
+void CollectionsBackup::start()
+{
+    if (m_collections.empty()) {
+        Q_EMIT finished();
+        return;
+    }
+    startNextCollections();
+}
+
+void CollectionsBackup::cancel()
+{
+    m_cancelled = true;
+    m_canceller.cancel();
+}
+
+void CollectionsBackup::startNextCollections()
+{
+    while (!m_cancelled && m_inFlight < s_maxCollectionsInFlight && m_next < int(m_collections.size())) {
+        const int index = m_next++;
+        PendingCollection &collection = m_collections[index];
+        if (!collection.collection) {
+            itemsLoaded(index, false, QStringLiteral("The wallet is not available anymore."));
+            continue;
+        }
+
+        ++m_inFlight;
+        auto *request = new CollectionsBackupRequest{this, index, m_canceller.ref(), collection.collection.get()};
+        m_secretServiceClient->scheduleRequest(SecretServiceClient::BackgroundPriority, [request](SecretServiceClient::RequestSlot slot) {
+            if (startBackupRequest(request, std::move(slot))) {
+                request->latency.emplace("secret_collection_load_items");
+                secret_collection_load_items(request->secretCollection, request->cancellable.get(), onItemsLoaded, request);
+            }
+        });
+    }
+}
+
+void CollectionsBackup::itemsLoaded(int collection, bool success, const QString &message)
+{
+    if (m_cancelled) {
+        return;
+    }
+
+    PendingCollection &pending = m_collections[collection];
+    if (!success) {
+        m_cancelled = true;
+        Q_EMIT collectionFailed(pending.name, message);
+        Q_EMIT finished();
+        return;
+    }
+
+    GListPtr list = GListPtr(secret_collection_get_items(pending.collection.get()));
+    for (GList *l = list.get(); l != nullptr; l = l->next) {
+        pending.queue.append(SecretItemPtr(SECRET_ITEM(l->data)));
+    }
+    pending.items.reserve(pending.queue.count());
+
+    loadNextBatch(collection);
+}
+
+void CollectionsBackup::loadNextBatch(int collection)
+{
+    PendingCollection &pending = m_collections[collection];
+    pending.batch.clear();
+
+    if (pending.queue.isEmpty()) {
+        finishCollection(collection);
+        return;
+    }
+
+    // The list doesn't own the items, the batch keeps them alive until the request is done
+    GList *items = nullptr;
+    while (pending.batch.count() < s_secretsBatchSize && !pending.queue.isEmpty()) {
+        pending.batch.append(pending.queue.takeFirst());
+        items = g_list_prepend(items, pending.batch.last().get());
+    }
+    auto *request = new CollectionsBackupRequest{this, collection, m_canceller.ref(), pending.collection.get(), GListPtr(g_list_reverse(items))};
+    m_secretServiceClient->scheduleRequest(SecretServiceClient::BackgroundPriority, [request](SecretServiceClient::RequestSlot slot) {
+        if (startBackupRequest(request, std::move(slot))) {
+            request->latency.emplace("secret_item_load_secrets");
+            secret_item_load_secrets(request->items.get(), request->cancellable.get(), onSecretsLoaded, request);
+        }
+    });
+}
+
+void CollectionsBackup::secretsLoaded(int collection, bool success, const QString &message)
+{
+    if (m_cancelled) {
+        return;
+    }
+
+    PendingCollection &pending = m_collections[collection];
+    if (!success) {
+        m_cancelled = true;
+        Q_EMIT collectionFailed(pending.name, message);
+        Q_EMIT finished();
+        return;
+    }
+
+    for (const SecretItemPtr &item : std::as_const(pending.batch)) {
+        pending.items.append(exportItem(item.get()));
+    }
+
+    loadNextBatch(collection);
+}
+
+void CollectionsBackup::finishCollection(int collection)
+{
+    PendingCollection &pending = m_collections[collection];
+    const QVariantList items = std::move(pending.items);
+    pending.items = QVariantList();
+    pending.collection.reset();
+    --m_inFlight;
+
+    Q_EMIT collectionRead(pending.name, items);
+
+    if (m_cancelled) {
+        return;
+    }
+    if (m_inFlight == 0 && m_next >= int(m_collections.size())) {
+        Q_EMIT finished();
+        return;
+    }
+    startNextCollections();
+}
+
+#include "moc_collectionsbackup.cpp"
@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "secretserviceclient.h"
+
+#include <QObject>
+#include <QVariantList>
+#include <vector>
+
+/**
+ * Reads the items of all the unlocked collections, to back them up at once
+ * without loading each of them in the CollectionModel.
+ * A few collections are read in parallel, the secrets of each are fetched
+ * in batches with a single request per batch. Every collection is delivered
+ * whole with collectionRead(), in the order they complete.
+ */
+class CollectionsBackup : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CollectionsBackup(SecretServiceClient *secretServiceClient, QObject *parent = nullptr);
+    ~CollectionsBackup() override;
+
+    // The unlocked collections which will be read, the locked ones are skipped
+    int collectionCount() const;
+
+    void start();
+    // No more collections are delivered, the requests in flight are cancelled
+    void cancel();
+
+    // For the static libsecret handlers
+    void itemsLoaded(int collection, bool success, const QString &message);
+    void secretsLoaded(int collection, bool success, const QString &message);
+
+Q_SIGNALS:
+    // Items in the format of CollectionModel::exportItems()
+    void collectionRead(const QString &walletName, const QVariantList &items);
+    void collectionFailed(const QString &walletName, const QString &message);
+    // After the last collection has been read, or after a failure
+    void finished();
+
+private:
+    struct PendingCollection {
+        QString name;
+        SecretCollectionPtr collection;
+        // Items whose secret is still to be fetched
+        QList<SecretItemPtr> queue;
+        QList<SecretItemPtr> batch;
+        QVariantList items;
+    };
+
+    void startNextCollections();
+    void loadNextBatch(int collection);
+    void finishCollection(int collection);
+
+    SecretServiceClient *const m_secretServiceClient;
+    std::vector<PendingCollection> m_collections;
+    int m_next = 0;
+    int m_inFlight = 0;
+    bool m_cancelled = false;
+    RequestCanceller m_canceller;
+};
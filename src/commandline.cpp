@@ -0,0 +1,439 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "commandline.h"
+#include "collectionmodel.h"
+#include "importexportmanager.h"
+#include "searchmodel.h"
+#include "secretitemproxy.h"
+#include "statetracker.h"
+#include "version-keepsecret.h"
+
+#include <KLocalizedString>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+using namespace Qt::Literals::StringLiterals;
+
+static const QString s_listOption = u"list"_s;
+static const QString s_getOption = u"get"_s;
+static const QString s_searchOption = u"search"_s;
+static const QString s_exportOption = u"export"_s;
+static const QString s_importOption = u"import"_s;
+static const QString s_collectionOption = u"collection"_s;
+
+// Items are below their collection, like /org/freedesktop/secrets/collection/login/1
+static QString collectionPathOfItem(const QString &itemPath)
+{
+    return itemPath.section(u'/', 0, -2);
+}
+
+QList<QCommandLineOption> CommandLine::options()
+{
+    return {
+        QCommandLineOption(s_listOption, i18nc("@info:shell", "Print the collections as JSON, or the items of the one given with --collection, and exit")),
+        QCommandLineOption(s_getOption,
+                           i18nc("@info:shell", "Print the item at the D-Bus <path> as JSON, including its secret, and exit"),
+                           i18nc("@info:shell value name", "path")),
+        QCommandLineOption(s_searchOption,
+                           i18nc("@info:shell", "Print the items of all the collections having the attribute as JSON and exit, can be repeated"),
+                           i18nc("@info:shell value name", "attribute=value")),
+        QCommandLineOption(s_exportOption,
+                           i18nc("@info:shell", "Write the collection given with --collection, or all of them, to <file> and exit"),
+                           i18nc("@info:shell value name", "file")),
+        QCommandLineOption(s_importOption,
+                           i18nc("@info:shell", "Import <file> into the collection given with --collection, or the default one, and exit"),
+                           i18nc("@info:shell value name", "file")),
+        QCommandLineOption(s_collectionOption,
+                           i18nc("@info:shell", "The D-Bus <path> of the collection for --list, --export and --import"),
+                           i18nc("@info:shell value name", "path")),
+    };
+}
+
+bool CommandLine::isRequested(int argc, char *argv[])
+{
+    static const QStringList commands = {s_listOption, s_getOption, s_searchOption, s_exportOption, s_importOption};
+
+    for (int i = 1; i < argc; ++i) {
+        QString argument = QString::fromLocal8Bit(argv[i]);
+        if (argument == u"--"_s) {
+            break;
+        }
+        if (!argument.startsWith(u'-')) {
+            continue;
+        }
+        argument = argument.section(u'=', 0, 0);
+        while (argument.startsWith(u'-')) {
+            argument.remove(0, 1);
+        }
+        if (commands.contains(argument)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int CommandLine::run(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    KLocalizedString::setApplicationDomain("keepsecret");
+    QCoreApplication::setOrganizationName(u"KDE"_s);
+    QCoreApplication::setApplicationName(u"keepsecret"_s);
+    QCoreApplication::setApplicationVersion(QStringLiteral(KEEPSECRET_VERSION_STRING));
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOptions(options());
+    parser.process(app);
+
+    QList<Command> commands;
+    if (parser.isSet(s_listOption)) {
+        commands.append(ListCommand);
+    }
+    if (parser.isSet(s_getOption)) {
+        commands.append(GetCommand);
+    }
+    if (parser.isSet(s_searchOption)) {
+        commands.append(SearchCommand);
+    }
+    if (parser.isSet(s_exportOption)) {
+        commands.append(ExportCommand);
+    }
+    if (parser.isSet(s_importOption)) {
+        commands.append(ImportCommand);
+    }
+    if (commands.size() != 1) {
+        QTextStream(stderr) << i18nc("@info:shell", "Only one of --list, --get, --search, --export and --import can be given") << Qt::endl;
+        return 2;
+    }
+
+    QString argument;
+    switch (commands.constFirst()) {
+    case GetCommand:
+        argument = parser.value(s_getOption);
+        break;
+    case ExportCommand:
+        argument = parser.value(s_exportOption);
+        break;
+    case ImportCommand:
+        argument = parser.value(s_importOption);
+        break;
+    default:
+        break;
+    }
+
+    const QStringList searchTerms = parser.values(s_searchOption);
+    for (const QString &term : searchTerms) {
+        if (term.indexOf(u'=') <= 0) {
+            QTextStream(stderr) << i18nc("@info:shell", "Invalid search term %1, expected attribute=value", term) << Qt::endl;
+            return 2;
+        }
+    }
+
+    CommandLine commandLine(commands.constFirst(), argument, parser.value(s_collectionOption), searchTerms);
+    return app.exec();
+}
+
+CommandLine::CommandLine(Command command, const QString &argument, const QString &collectionPath, const QStringList &searchTerms)
+    : QObject()
+    , m_command(command)
+    , m_argument(argument)
+    , m_collectionPath(collectionPath)
+    , m_searchTerms(searchTerms)
+{
+    connect(StateTracker::instance(), &StateTracker::errorChanged, this, [this](StateTracker::Error error, const QString &message) {
+        // Without a default collection the first one is used
+        if (error != StateTracker::NoError && error != StateTracker::CollectionReadDefaultError) {
+            fail(message);
+        }
+    });
+
+    m_secretServiceClient = new SecretServiceClient(this);
+
+    connect(m_secretServiceClient, &SecretServiceClient::promptClosed, this, [this](bool accepted) {
+        if (!accepted) {
+            fail(i18nc("@info:shell", "The prompt of the secret service was dismissed"));
+        }
+    });
+
+    // From the event loop, as finishing before it runs would not exit
+    QMetaObject::invokeMethod(
+        this,
+        [this]() {
+            when(
+                []() {
+                    return !(StateTracker::instance()->operations() & (StateTracker::ServiceConnecting | StateTracker::CollectionReadingDefault));
+                },
+                [this]() {
+                    if (StateTracker::instance()->isServiceConnected()) {
+                        start();
+                    } else {
+                        fail(i18nc("@info:shell", "Cannot connect to the secret service"));
+                    }
+                });
+        },
+        Qt::QueuedConnection);
+}
+
+CommandLine::~CommandLine()
+{
+}
+
+void CommandLine::start()
+{
+    switch (m_command) {
+    case ListCommand:
+        list();
+        break;
+    case GetCommand:
+        get();
+        break;
+    case SearchCommand:
+        search();
+        break;
+    case ExportCommand:
+        exportFile();
+        break;
+    case ImportCommand:
+        importFile();
+        break;
+    }
+}
+
+void CommandLine::list()
+{
+    if (m_collectionPath.isEmpty()) {
+        QJsonArray collections;
+        for (const SecretServiceClient::CollectionEntry &entry : m_secretServiceClient->listCollections()) {
+            collections.append(QJsonObject{{u"name"_s, entry.name}, {u"dbusPath"_s, entry.dbusPath}, {u"locked"_s, entry.locked}});
+        }
+        finish(QJsonObject{{u"default"_s, m_secretServiceClient->defaultCollection()}, {u"collections"_s, collections}});
+        return;
+    }
+
+    openCollection([this]() {
+        QJsonArray items;
+        for (int row = 0; row < m_collectionModel->rowCount(); ++row) {
+            const QModelIndex index = m_collectionModel->index(row, 0);
+            items.append(QJsonObject{{u"label"_s, index.data(Qt::DisplayRole).toString()},
+                                     {u"folder"_s, index.data(CollectionModel::FolderRole).toString()},
+                                     {u"dbusPath"_s, index.data(CollectionModel::DbusPathRole).toString()}});
+        }
+        finish(QJsonObject{{u"name"_s, m_collectionModel->collectionName()},
+                           {u"dbusPath"_s, m_collectionModel->collectionPath()},
+                           {u"items"_s, items}});
+    });
+}
+
+void CommandLine::get()
+{
+    m_secretItemProxy = new SecretItemProxy(m_secretServiceClient, this);
+
+    connect(m_secretItemProxy, &SecretItemProxy::itemLoaded, this, [this]() {
+        const SecretServiceClient::Type type = m_secretItemProxy->type();
+        finish(QJsonObject{
+            {u"label"_s, m_secretItemProxy->label()},
+            {u"dbusPath"_s, m_argument},
+            {u"collection"_s, collectionPathOfItem(m_argument)},
+            {u"type"_s, SecretServiceClient::typeToString(type)},
+            {u"secret"_s, type == SecretServiceClient::Binary ? m_secretItemProxy->formattedBinarySecret() : m_secretItemProxy->secretValue()},
+            {u"attributes"_s, QJsonObject::fromVariantMap(m_secretItemProxy->attributes())},
+            {u"created"_s, m_secretItemProxy->creationTime().toString(Qt::ISODate)},
+            {u"modified"_s, m_secretItemProxy->modificationTime().toString(Qt::ISODate)},
+        });
+    });
+
+    // Failures are reported through the StateTracker
+    m_secretItemProxy->loadItem(collectionPathOfItem(m_argument), m_argument);
+}
+
+void CommandLine::search()
+{
+    QVariantMap attributes;
+    for (const QString &term : std::as_const(m_searchTerms)) {
+        attributes.insert(term.section(u'=', 0, 0), term.section(u'=', 1));
+    }
+
+    auto *searchModel = new SearchModel(m_secretServiceClient, this);
+    auto report = [this, searchModel]() {
+        if (searchModel->isSearching()) {
+            return;
+        }
+
+        QJsonArray results;
+        for (int row = 0; row < searchModel->rowCount(); ++row) {
+            const QModelIndex index = searchModel->index(row, 0);
+            results.append(QJsonObject{{u"label"_s, index.data(Qt::DisplayRole).toString()},
+                                       {u"dbusPath"_s, index.data(SearchModel::DbusPathRole).toString()},
+                                       {u"collection"_s, index.data(SearchModel::CollectionPathRole).toString()},
+                                       {u"locked"_s, index.data(SearchModel::LockedRole).toBool()},
+                                       {u"attributes"_s, QJsonObject::fromVariantMap(index.data(SearchModel::AttributesRole).toMap())}});
+        }
+        finish(results);
+    };
+    connect(searchModel, &SearchModel::searchingChanged, this, report);
+    searchModel->search(attributes, QString());
+    // Without collections it's already done
+    report();
+}
+
+void CommandLine::exportFile()
+{
+    ImportExportManager *manager = importExportManager();
+    connect(manager, &ImportExportManager::exportSucceeded, this, [this](const QString &filePath) {
+        finish(QJsonObject{{u"exported"_s, filePath}});
+    });
+
+    if (m_collectionPath.isEmpty()) {
+        manager->backupAllCollections(m_argument);
+        return;
+    }
+
+    openCollection([this, manager]() {
+        manager->exportToFile(m_argument, m_collectionModel->collectionName(), m_collectionModel->exportItems());
+    });
+}
+
+void CommandLine::importFile()
+{
+    openCollection([this]() {
+        ImportExportManager *manager = importExportManager();
+        connect(manager, &ImportExportManager::itemsImported, m_collectionModel, &CollectionModel::importChunk);
+        connect(manager, &ImportExportManager::importSucceeded, m_collectionModel, &CollectionModel::endImport);
+        connect(manager, &ImportExportManager::errorOccurred, m_collectionModel, &CollectionModel::endImport);
+        connect(m_collectionModel, &CollectionModel::importProgress, manager, [manager](int done, int total) {
+            manager->setImportBacklog(total - done);
+        });
+        connect(m_collectionModel, &CollectionModel::importFinished, this, [this](int imported, int failed) {
+            m_importedItems += imported;
+            m_failedItems += failed;
+        });
+        connect(manager, &ImportExportManager::passphraseRequired, this, [this]() {
+            fail(i18nc("@info:shell", "%1 is protected by a passphrase, import it from the application", m_argument));
+        });
+        connect(manager, &ImportExportManager::importSucceeded, this, [this]() {
+            // The last items read may still be being written
+            when(
+                []() {
+                    // Also the items waiting for a reload of the collection
+                    return !(StateTracker::instance()->operations() & (StateTracker::ItemCreating | StateTracker::CollectionLoading));
+                },
+                [this]() {
+                    finish(QJsonObject{{u"collection"_s, m_collectionModel->collectionPath()},
+                                       {u"imported"_s, m_importedItems},
+                                       {u"failed"_s, m_failedItems}});
+                });
+        });
+
+        manager->importFromFile(m_argument);
+    });
+}
+
+void CommandLine::openCollection(const std::function<void()> &then)
+{
+    QString collectionPath = m_collectionPath;
+    if (collectionPath.isEmpty()) {
+        collectionPath = m_secretServiceClient->defaultCollection();
+    }
+    if (collectionPath.isEmpty()) {
+        const auto collections = m_secretServiceClient->listCollections();
+        if (!collections.isEmpty()) {
+            collectionPath = collections.constFirst().dbusPath;
+        }
+    }
+    if (collectionPath.isEmpty()) {
+        fail(i18nc("@info:shell", "There are no collections"));
+        return;
+    }
+
+    m_collectionModel = new CollectionModel(m_secretServiceClient, this);
+    m_collectionModel->setCollectionPath(collectionPath);
+
+    auto *stateTracker = StateTracker::instance();
+    if (!(stateTracker->operations() & StateTracker::CollectionLoading) && !(stateTracker->status() & StateTracker::CollectionLocked)) {
+        fail(i18nc("@info:shell", "Cannot open the collection %1", collectionPath));
+        return;
+    }
+
+    when(
+        [stateTracker]() {
+            return !(stateTracker->operations() & StateTracker::CollectionLoading);
+        },
+        [this, stateTracker, then]() {
+            if (stateTracker->status() & StateTracker::CollectionLocked) {
+                // Loaded again once the prompt has been answered
+                m_collectionModel->unlock();
+            }
+            when(
+                [stateTracker]() {
+                    return (stateTracker->status() & StateTracker::CollectionReady) && !(stateTracker->operations() & StateTracker::CollectionLoading);
+                },
+                then);
+        });
+}
+
+void CommandLine::when(const std::function<bool()> &condition, const std::function<void()> &then)
+{
+    if (m_finished) {
+        return;
+    }
+    if (condition()) {
+        then();
+        return;
+    }
+
+    auto connections = std::make_shared<QList<QMetaObject::Connection>>();
+    auto check = [this, condition, then, connections]() {
+        if (m_finished || !condition()) {
+            return;
+        }
+        for (const QMetaObject::Connection &connection : std::as_const(*connections)) {
+            disconnect(connection);
+        }
+        then();
+    };
+    connections->append(connect(StateTracker::instance(), &StateTracker::operationsChanged, this, check));
+    connections->append(connect(StateTracker::instance(), &StateTracker::statusChanged, this, check));
+}
+
+ImportExportManager *CommandLine::importExportManager()
+{
+    if (!m_importExportManager) {
+        m_importExportManager = new ImportExportManager(m_secretServiceClient, this);
+        connect(m_importExportManager, &ImportExportManager::errorOccurred, this, &CommandLine::fail);
+    }
+    return m_importExportManager;
+}
+
+void CommandLine::finish(const QJsonValue &result)
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+
+    const QJsonDocument document = result.isArray() ? QJsonDocument(result.toArray()) : QJsonDocument(result.toObject());
+    QTextStream(stdout) << document.toJson();
+    QCoreApplication::exit(0);
+}
+
+void CommandLine::fail(const QString &message)
+{
+    if (m_finished) {
+        return;
+    }
+    m_finished = true;
+
+    if (m_importExportManager) {
+        m_importExportManager->cancel();
+    }
+    QTextStream(stderr) << message << Qt::endl;
+    QCoreApplication::exit(1);
+}
+
+#include "moc_commandline.cpp"
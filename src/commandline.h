@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "secretserviceclient.h"
+#include <QCommandLineOption>
+#include <QJsonValue>
+#include <QObject>
+#include <functional>
+
+class CollectionModel;
+class ImportExportManager;
+class SecretItemProxy;
+
+/**
+ * Runs a single command against the secret service without any user
+ * interface, for scripts: the result goes to the standard output as JSON,
+ * errors to the standard error with a non zero exit code.
+ * Prompts of the service, for instance to unlock a collection, are still
+ * shown by the service itself.
+ */
+class CommandLine : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Also added to the parser of the application, for --help
+    static QList<QCommandLineOption> options();
+    // If the arguments ask for a command instead of the window
+    static bool isRequested(int argc, char *argv[]);
+    // Creates its own QCoreApplication, returns the exit code
+    static int run(int argc, char *argv[]);
+
+private:
+    enum Command {
+        ListCommand,
+        GetCommand,
+        SearchCommand,
+        ExportCommand,
+        ImportCommand
+    };
+
+    CommandLine(Command command, const QString &argument, const QString &collectionPath, const QStringList &searchTerms);
+    ~CommandLine() override;
+
+    void start();
+    void list();
+    void get();
+    void search();
+    void exportFile();
+    void importFile();
+
+    // The collection of --collection, or the default one, loaded and unlocked
+    void openCollection(const std::function<void()> &then);
+    // then() runs as soon as condition() is true, checked whenever the state changes
+    void when(const std::function<bool()> &condition, const std::function<void()> &then);
+    ImportExportManager *importExportManager();
+
+    void finish(const QJsonValue &result);
+    void fail(const QString &message);
+
+    Command m_command;
+    QString m_argument;
+    QString m_collectionPath;
+    QStringList m_searchTerms;
+    bool m_finished = false;
+    int m_importedItems = 0;
+    int m_failedItems = 0;
+
+    SecretServiceClient *m_secretServiceClient = nullptr;
+    CollectionModel *m_collectionModel = nullptr;
+    SecretItemProxy *m_secretItemProxy = nullptr;
+    ImportExportManager *m_importExportManager = nullptr;
+};
@@ -0,0 +1,284 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "csvreader.h"
+
+#include <QIODevice>
+#include <QUrl>
+
+static constexpr qint64 s_blockSize = 64 * 1024;
+// Refuse fields bigger than this, rather than reading a whole broken file in one
+static constexpr qsizetype s_maxFieldSize = 1024 * 1024;
+
+bool CsvColumnMapping::isEmpty() const
+{
+    return label.isEmpty() && secret.isEmpty() && server.isEmpty() && user.isEmpty();
+}
+
+CsvColumnMapping CsvColumnMapping::chrome()
+{
+    return {QStringLiteral("name"), QStringLiteral("password"), QStringLiteral("url"), QStringLiteral("username")};
+}
+
+CsvColumnMapping CsvColumnMapping::firefox()
+{
+    // No name column: the label falls back to the server
+    return {QString(), QStringLiteral("password"), QStringLiteral("url"), QStringLiteral("username")};
+}
+
+CsvColumnMapping CsvColumnMapping::keePassXC()
+{
+    return {QStringLiteral("Title"), QStringLiteral("Password"), QStringLiteral("URL"), QStringLiteral("Username")};
+}
+
+CsvColumnMapping CsvColumnMapping::fromVariantMap(const QVariantMap &map)
+{
+    const QString preset = map.value(QStringLiteral("preset")).toString().toLower();
+    if (preset == QStringLiteral("chrome")) {
+        return chrome();
+    } else if (preset == QStringLiteral("firefox")) {
+        return firefox();
+    } else if (preset == QStringLiteral("keepassxc")) {
+        return keePassXC();
+    }
+
+    return {map.value(QStringLiteral("label")).toString(),
+            map.value(QStringLiteral("secret")).toString(),
+            map.value(QStringLiteral("server")).toString(),
+            map.value(QStringLiteral("user")).toString()};
+}
+
+CsvColumnMapping CsvColumnMapping::detect(const QStringList &header)
+{
+    const auto hasColumn = [&header](const QString &name) {
+        return header.contains(name, Qt::CaseInsensitive);
+    };
+
+    if (hasColumn(QStringLiteral("Title")) && hasColumn(QStringLiteral("Group"))) {
+        return keePassXC();
+    }
+    if (!hasColumn(QStringLiteral("name")) && hasColumn(QStringLiteral("formActionOrigin"))) {
+        return firefox();
+    }
+    return chrome();
+}
+
+CsvReader::CsvReader(QIODevice *device, const CsvColumnMapping &mapping)
+    : m_device(device)
+    , m_mapping(mapping)
+{
+}
+
+bool CsvReader::atEnd() const
+{
+    return m_atEnd;
+}
+
+QString CsvReader::errorString() const
+{
+    return m_error;
+}
+
+bool CsvReader::fillBuffer()
+{
+    if (m_deviceAtEnd) {
+        return false;
+    }
+
+    // Drop what was consumed already
+    m_buffer.remove(0, m_position);
+    m_position = 0;
+
+    const QByteArray block = m_device->read(s_blockSize);
+    if (block.isEmpty()) {
+        m_deviceAtEnd = true;
+        return false;
+    }
+    m_buffer.append(block);
+    return true;
+}
+
+bool CsvReader::readRecord(QStringList *fields)
+{
+    enum State {
+        FieldStart,
+        Unquoted,
+        Quoted,
+        QuoteInQuoted
+    };
+
+    fields->clear();
+    QByteArray field;
+    State state = FieldStart;
+    bool anyData = false;
+
+    while (true) {
+        if (m_position >= m_buffer.size() && !fillBuffer()) {
+            // End of file: a last record without line break still counts
+            if (state == Quoted) {
+                m_error = QStringLiteral("Unterminated quoted field at line %1.").arg(m_line);
+                return false;
+            }
+            if (anyData) {
+                *fields << QString::fromUtf8(field);
+                return true;
+            }
+            return false;
+        }
+
+        const char c = m_buffer.at(m_position++);
+        anyData = true;
+
+        switch (state) {
+        case FieldStart:
+        case Unquoted:
+            if (c == '"' && state == FieldStart) {
+                state = Quoted;
+            } else if (c == ',') {
+                *fields << QString::fromUtf8(field);
+                field.clear();
+                state = FieldStart;
+            } else if (c == '\n' || c == '\r') {
+                if (c == '\r' && (m_position < m_buffer.size() || fillBuffer()) && m_buffer.at(m_position) == '\n') {
+                    ++m_position;
+                }
+                ++m_line;
+                *fields << QString::fromUtf8(field);
+                return true;
+            } else {
+                field.append(c);
+                state = Unquoted;
+            }
+            break;
+        case Quoted:
+            if (c == '"') {
+                state = QuoteInQuoted;
+            } else {
+                if (c == '\n') {
+                    ++m_line;
+                }
+                field.append(c);
+            }
+            break;
+        case QuoteInQuoted:
+            if (c == '"') {
+                // Escaped quote
+                field.append('"');
+                state = Quoted;
+            } else {
+                // Closing quote, be lenient on anything after it
+                --m_position;
+                state = Unquoted;
+            }
+            break;
+        }
+
+        if (field.size() > s_maxFieldSize) {
+            m_error = QStringLiteral("Field too long at line %1.").arg(m_line);
+            return false;
+        }
+    }
+}
+
+bool CsvReader::readHeader()
+{
+    m_headerRead = true;
+
+    QStringList header;
+    if (!readRecord(&header)) {
+        if (m_error.isEmpty()) {
+            m_error = QStringLiteral("The CSV file is empty.");
+        }
+        return false;
+    }
+    // Spreadsheets like to start with a byte order mark
+    if (!header.isEmpty() && header.first().startsWith(QChar(0xFEFF))) {
+        header.first().remove(0, 1);
+    }
+
+    if (m_mapping.isEmpty()) {
+        m_mapping = CsvColumnMapping::detect(header);
+    }
+
+    const auto column = [&header](const QString &name) {
+        if (name.isEmpty()) {
+            return -1;
+        }
+        for (int i = 0; i < header.count(); ++i) {
+            if (header[i].trimmed().compare(name, Qt::CaseInsensitive) == 0) {
+                return i;
+            }
+        }
+        return -1;
+    };
+    m_labelColumn = column(m_mapping.label);
+    m_secretColumn = column(m_mapping.secret);
+    m_serverColumn = column(m_mapping.server);
+    m_userColumn = column(m_mapping.user);
+
+    if (m_secretColumn < 0) {
+        m_error = QStringLiteral("The CSV file has no column \"%1\" for the passwords.").arg(m_mapping.secret);
+        return false;
+    }
+    return true;
+}
+
+QVariantMap CsvReader::itemFromRecord(const QStringList &fields) const
+{
+    const auto value = [&fields](int column) {
+        return column >= 0 ? fields.value(column) : QString();
+    };
+
+    QString server = value(m_serverColumn);
+    // Browsers export whole URLs, the folders group by host
+    const QUrl url(server);
+    if (!url.host().isEmpty()) {
+        server = url.host();
+    }
+    const QString user = value(m_userColumn);
+
+    QString label = value(m_labelColumn);
+    if (label.isEmpty()) {
+        label = user.isEmpty() ? server : user + QLatin1Char('@') + server;
+    }
+
+    QVariantMap attributes;
+    attributes[QStringLiteral("server")] = server;
+    attributes[QStringLiteral("user")] = user;
+
+    QVariantMap item;
+    item[QStringLiteral("label")] = label;
+    item[QStringLiteral("secret")] = value(m_secretColumn).toUtf8();
+    item[QStringLiteral("contentType")] = QStringLiteral("text/plain");
+    item[QStringLiteral("attributes")] = attributes;
+    item[QStringLiteral("folder")] = server;
+    return item;
+}
+
+QVariantList CsvReader::readItems(int maxItems)
+{
+    QVariantList items;
+
+    if (m_atEnd || (!m_headerRead && !readHeader())) {
+        m_atEnd = true;
+        return items;
+    }
+
+    QStringList fields;
+    while (items.count() < maxItems) {
+        if (!readRecord(&fields)) {
+            m_atEnd = true;
+            break;
+        }
+        // Blank lines
+        if (fields.count() == 1 && fields.first().isEmpty()) {
+            continue;
+        }
+        items.append(itemFromRecord(fields));
+    }
+
+    if (hasError()) {
+        items.clear();
+    }
+    return items;
+}
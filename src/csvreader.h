@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "itemreader.h"
+
+#include <QByteArray>
+#include <QStringList>
+#include <QVariantMap>
+
+class QIODevice;
+
+/**
+ * Which CSV columns, by header name, hold the fields of an item.
+ * The names are compared case insensitively.
+ */
+struct CsvColumnMapping {
+    QString label;
+    QString secret;
+    QString server;
+    QString user;
+
+    bool isEmpty() const;
+
+    // Chrome and Chromium based browsers
+    static CsvColumnMapping chrome();
+    static CsvColumnMapping firefox();
+    static CsvColumnMapping keePassXC();
+    // Either a preset, as {"preset": "chrome"|"firefox"|"keepassxc"},
+    // or the column names with the keys label, secret, server and user
+    static CsvColumnMapping fromVariantMap(const QVariantMap &map);
+    // The preset matching the header, chrome() if none does
+    static CsvColumnMapping detect(const QStringList &header);
+};
+
+/**
+ * Streaming RFC 4180 parser: quoted fields can contain separators, quotes
+ * written as "" and line breaks. The first record is the header.
+ * The device is read in blocks, only the current record is kept in memory.
+ */
+class CsvReader : public ItemReader
+{
+public:
+    // An empty mapping is detected from the header
+    explicit CsvReader(QIODevice *device, const CsvColumnMapping &mapping = CsvColumnMapping());
+
+    QVariantList readItems(int maxItems) override;
+    bool atEnd() const override;
+    QString errorString() const override;
+
+private:
+    bool readHeader();
+    // Returns false at the end of the file or on error
+    bool readRecord(QStringList *fields);
+    bool fillBuffer();
+    QVariantMap itemFromRecord(const QStringList &fields) const;
+
+    QIODevice *m_device;
+    CsvColumnMapping m_mapping;
+    int m_labelColumn = -1;
+    int m_secretColumn = -1;
+    int m_serverColumn = -1;
+    int m_userColumn = -1;
+
+    QByteArray m_buffer;
+    qsizetype m_position = 0;
+    qint64 m_line = 1;
+    bool m_headerRead = false;
+    bool m_deviceAtEnd = false;
+    QString m_error;
+    bool m_atEnd = false;
+};
@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "csvwriter.h"
+
+#include <QIODevice>
+
+static QByteArray escapeField(const QString &field)
+{
+    QByteArray data = field.toUtf8();
+    if (!data.contains(',') && !data.contains('"') && !data.contains('\n') && !data.contains('\r')) {
+        return data;
+    }
+    data.replace("\"", "\"\"");
+    return '"' + data + '"';
+}
+
+CsvWriter::CsvWriter(QIODevice *device, const CsvColumnMapping &mapping)
+    : m_device(device)
+    , m_mapping(mapping)
+{
+}
+
+void CsvWriter::writeRecord(const QStringList &fields)
+{
+    if (m_error) {
+        return;
+    }
+
+    QByteArray record;
+    for (const QString &field : fields) {
+        if (!record.isEmpty()) {
+            record.append(',');
+        }
+        record.append(escapeField(field));
+    }
+    // RFC 4180 wants CRLF
+    record.append("\r\n");
+
+    m_error = m_device->write(record) != record.size();
+    record.fill(0);
+}
+
+void CsvWriter::beginWallet(const QString &walletName)
+{
+    Q_UNUSED(walletName)
+
+    // A single header even for many wallets
+    if (m_headerWritten) {
+        return;
+    }
+    m_headerWritten = true;
+
+    QStringList header;
+    for (const QString &column : {m_mapping.label, m_mapping.server, m_mapping.user, m_mapping.secret}) {
+        if (!column.isEmpty()) {
+            header << column;
+        }
+    }
+    writeRecord(header);
+}
+
+void CsvWriter::writeItem(const QVariantMap &item)
+{
+    if (item.value(QStringLiteral("contentType")).toString() == QStringLiteral("application/octet-stream")) {
+        return;
+    }
+
+    const QVariantMap attributes = item.value(QStringLiteral("attributes")).toMap();
+    const QString values[] = {item.value(QStringLiteral("label")).toString(),
+                              attributes.value(QStringLiteral("server")).toString(),
+                              attributes.value(QStringLiteral("user")).toString(),
+                              QString::fromUtf8(item.value(QStringLiteral("secret")).toByteArray())};
+    const QString columns[] = {m_mapping.label, m_mapping.server, m_mapping.user, m_mapping.secret};
+
+    QStringList fields;
+    for (int i = 0; i < 4; ++i) {
+        if (!columns[i].isEmpty()) {
+            fields << values[i];
+        }
+    }
+    writeRecord(fields);
+}
+
+void CsvWriter::endWallet()
+{
+}
+
+void CsvWriter::finish()
+{
+}
+
+bool CsvWriter::hasError() const
+{
+    return m_error;
+}
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "csvreader.h"
+#include "itemwriter.h"
+
+class QIODevice;
+
+/**
+ * Writes items as RFC 4180 CSV, with a header naming the columns of the
+ * mapping (by default the Chrome layout). Fields are quoted only when needed.
+ * Binary secrets can't be represented and are skipped.
+ */
+class CsvWriter : public ItemWriter
+{
+public:
+    explicit CsvWriter(QIODevice *device, const CsvColumnMapping &mapping = CsvColumnMapping::chrome());
+
+    void beginWallet(const QString &walletName) override;
+    void writeItem(const QVariantMap &item) override;
+    void endWallet() override;
+    void finish() override;
+
+    bool hasError() const override;
+
+private:
+    void writeRecord(const QStringList &fields);
+
+    QIODevice *m_device;
+    CsvColumnMapping m_mapping;
+    bool m_headerWritten = false;
+    bool m_error = false;
+};
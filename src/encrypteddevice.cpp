@@ -0,0 +1,390 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "encrypteddevice.h"
+#include "keepsecret_debug.h"
+
+#include <QtEndian>
+
+#include <gcrypt.h>
+#include <limits>
+#include <mutex>
+
+static constexpr char s_magic[] = "KSCRYPT1";
+static constexpr qsizetype s_magicSize = 8;
+static constexpr quint8 s_kdfPbkdf2Sha256 = 1;
+static constexpr quint32 s_iterations = 600000;
+// Refuse files asking for more than this, deriving the key would take forever
+static constexpr quint32 s_maxIterations = 10000000;
+static constexpr qsizetype s_saltSize = 16;
+static constexpr qsizetype s_noncePrefixSize = 8;
+static constexpr qsizetype s_nonceSize = s_noncePrefixSize + sizeof(quint32);
+static constexpr qsizetype s_headerSize = s_magicSize + sizeof(quint8) + sizeof(quint32) + s_saltSize + s_noncePrefixSize + sizeof(quint32);
+static constexpr qsizetype s_keySize = 32;
+static constexpr qsizetype s_tagSize = 16;
+static constexpr qsizetype s_chunkHeaderSize = sizeof(quint8) + sizeof(quint32);
+static constexpr quint32 s_chunkSize = 64 * 1024;
+static constexpr quint32 s_maxChunkSize = 16 * 1024 * 1024;
+
+enum ChunkFlag : quint8 {
+    FinalChunk = 1,
+};
+
+void EncryptedDevice::initializeGcrypt()
+{
+    static std::once_flag initialized;
+    std::call_once(initialized, []() {
+        // libsecret may have initialized it already
+        if (!gcry_control(GCRYCTL_INITIALIZATION_FINISHED_P)) {
+            gcry_check_version(nullptr);
+            gcry_control(GCRYCTL_INITIALIZATION_FINISHED, 0);
+        }
+    });
+}
+
+EncryptedDevice::EncryptedDevice(QIODevice *device, const QByteArray &passphrase, QObject *parent)
+    : QIODevice(parent)
+    , m_device(device)
+    , m_passphrase(passphrase)
+{
+    initializeGcrypt();
+}
+
+EncryptedDevice::~EncryptedDevice()
+{
+    if (isOpen()) {
+        close();
+    }
+    m_passphrase.fill(0);
+    m_buffer.fill(0);
+}
+
+bool EncryptedDevice::isEncrypted(QIODevice *device)
+{
+    return device->peek(s_magicSize) == QByteArray(s_magic, s_magicSize);
+}
+
+bool EncryptedDevice::isSequential() const
+{
+    return true;
+}
+
+bool EncryptedDevice::hasError() const
+{
+    return m_error;
+}
+
+void EncryptedDevice::fail(const QString &message)
+{
+    m_error = true;
+    setErrorString(message);
+}
+
+qint64 EncryptedDevice::bytesAvailable() const
+{
+    return m_buffer.size() - m_bufferPosition + QIODevice::bytesAvailable();
+}
+
+bool EncryptedDevice::open(OpenMode mode)
+{
+    if (mode != ReadOnly && mode != WriteOnly) {
+        fail(QStringLiteral("Encrypted files can only be read or written sequentially."));
+        return false;
+    }
+
+    m_error = false;
+    m_chunkIndex = 0;
+    m_finalChunkSeen = false;
+    m_buffer.clear();
+    m_bufferPosition = 0;
+
+    const bool headerOk = mode == WriteOnly ? writeHeader() : readHeader();
+    if (!headerOk || !setupCipher()) {
+        return false;
+    }
+
+    if (mode == WriteOnly) {
+        m_buffer.reserve(m_chunkSize);
+    }
+    return QIODevice::open(mode | Unbuffered);
+}
+
+void EncryptedDevice::close()
+{
+    if (openMode() & WriteOnly && !m_error) {
+        writeChunk(true);
+    }
+
+    if (m_cipher) {
+        gcry_cipher_close(m_cipher);
+        m_cipher = nullptr;
+    }
+    m_buffer.fill(0);
+    m_buffer.clear();
+    m_bufferPosition = 0;
+
+    QIODevice::close();
+}
+
+bool EncryptedDevice::writeHeader()
+{
+    m_iterations = s_iterations;
+    m_chunkSize = s_chunkSize;
+    m_salt.resize(s_saltSize);
+    gcry_randomize(m_salt.data(), m_salt.size(), GCRY_STRONG_RANDOM);
+    m_noncePrefix.resize(s_noncePrefixSize);
+    gcry_create_nonce(m_noncePrefix.data(), m_noncePrefix.size());
+
+    m_header = QByteArray(s_magic, s_magicSize);
+    m_header.append(char(s_kdfPbkdf2Sha256));
+
+    char number[sizeof(quint32)];
+    qToBigEndian<quint32>(m_iterations, number);
+    m_header.append(number, sizeof(number));
+    m_header.append(m_salt);
+    m_header.append(m_noncePrefix);
+    qToBigEndian<quint32>(m_chunkSize, number);
+    m_header.append(number, sizeof(number));
+
+    if (m_device->write(m_header) != m_header.size()) {
+        fail(QStringLiteral("Cannot write the encryption header."));
+        return false;
+    }
+    return true;
+}
+
+bool EncryptedDevice::readHeader()
+{
+    m_header = m_device->read(s_headerSize);
+    if (m_header.size() != s_headerSize || !m_header.startsWith(QByteArray(s_magic, s_magicSize))) {
+        fail(QStringLiteral("Not a valid encrypted KeepSecret file."));
+        return false;
+    }
+
+    const char *data = m_header.constData() + s_magicSize;
+    if (quint8(data[0]) != s_kdfPbkdf2Sha256) {
+        fail(QStringLiteral("This file was encrypted by a newer version of KeepSecret."));
+        return false;
+    }
+    data += sizeof(quint8);
+
+    m_iterations = qFromBigEndian<quint32>(data);
+    data += sizeof(quint32);
+    m_salt = QByteArray(data, s_saltSize);
+    data += s_saltSize;
+    m_noncePrefix = QByteArray(data, s_noncePrefixSize);
+    data += s_noncePrefixSize;
+    m_chunkSize = qFromBigEndian<quint32>(data);
+
+    if (m_iterations == 0 || m_iterations > s_maxIterations || m_chunkSize == 0 || m_chunkSize > s_maxChunkSize) {
+        fail(QStringLiteral("The encryption header is corrupted."));
+        return false;
+    }
+    return true;
+}
+
+bool EncryptedDevice::setupCipher()
+{
+    unsigned char key[s_keySize];
+    gcry_error_t error = gcry_kdf_derive(m_passphrase.constData(),
+                                         m_passphrase.size(),
+                                         GCRY_KDF_PBKDF2,
+                                         GCRY_MD_SHA256,
+                                         m_salt.constData(),
+                                         m_salt.size(),
+                                         m_iterations,
+                                         sizeof(key),
+                                         key);
+    m_passphrase.fill(0);
+
+    if (!error) {
+        error = gcry_cipher_open(&m_cipher, GCRY_CIPHER_AES256, GCRY_CIPHER_MODE_GCM, GCRY_CIPHER_SECURE);
+    }
+    if (!error) {
+        error = gcry_cipher_setkey(m_cipher, key, sizeof(key));
+    }
+    memset(key, 0, sizeof(key));
+
+    if (error) {
+        qCWarning(KEEPSECRET_LOG) << "Cannot set up the cipher:" << gcry_strerror(error);
+        fail(QStringLiteral("Cannot set up the encryption: ") + QString::fromUtf8(gcry_strerror(error)));
+        return false;
+    }
+    return true;
+}
+
+QByteArray EncryptedDevice::nonce() const
+{
+    QByteArray nonce = m_noncePrefix;
+    nonce.resize(s_nonceSize);
+    qToBigEndian<quint32>(m_chunkIndex, nonce.data() + s_noncePrefixSize);
+    return nonce;
+}
+
+QByteArray EncryptedDevice::additionalData(quint8 flags) const
+{
+    QByteArray data = m_header;
+    char number[sizeof(quint32)];
+    qToBigEndian<quint32>(m_chunkIndex, number);
+    data.append(number, sizeof(number));
+    data.append(char(flags));
+    return data;
+}
+
+qint64 EncryptedDevice::writeData(const char *data, qint64 size)
+{
+    if (m_error) {
+        return -1;
+    }
+
+    qint64 written = 0;
+    while (written < size) {
+        const qint64 amount = qMin<qint64>(size - written, m_chunkSize - m_buffer.size());
+        m_buffer.append(data + written, amount);
+        written += amount;
+
+        if (m_buffer.size() == qsizetype(m_chunkSize) && !writeChunk(false)) {
+            return -1;
+        }
+    }
+    return written;
+}
+
+bool EncryptedDevice::writeChunk(bool final)
+{
+    if (m_chunkIndex == std::numeric_limits<quint32>::max()) {
+        fail(QStringLiteral("The file is too big to be encrypted."));
+        return false;
+    }
+
+    const quint8 flags = final ? FinalChunk : 0;
+    const QByteArray iv = nonce();
+    const QByteArray aad = additionalData(flags);
+
+    QByteArray chunk(s_chunkHeaderSize + m_buffer.size() + s_tagSize, Qt::Uninitialized);
+    chunk[0] = char(flags);
+    qToBigEndian<quint32>(m_buffer.size(), chunk.data() + 1);
+    char *ciphertext = chunk.data() + s_chunkHeaderSize;
+
+    gcry_error_t error = gcry_cipher_reset(m_cipher);
+    if (!error) {
+        error = gcry_cipher_setiv(m_cipher, iv.constData(), iv.size());
+    }
+    if (!error) {
+        error = gcry_cipher_authenticate(m_cipher, aad.constData(), aad.size());
+    }
+    if (!error) {
+        error = gcry_cipher_final(m_cipher);
+    }
+    if (!error) {
+        error = gcry_cipher_encrypt(m_cipher, ciphertext, m_buffer.size(), m_buffer.constData(), m_buffer.size());
+    }
+    if (!error) {
+        error = gcry_cipher_gettag(m_cipher, ciphertext + m_buffer.size(), s_tagSize);
+    }
+
+    m_buffer.fill(0);
+    m_buffer.resize(0);
+
+    if (error) {
+        fail(QStringLiteral("Encryption failed: ") + QString::fromUtf8(gcry_strerror(error)));
+        return false;
+    }
+    if (m_device->write(chunk) != chunk.size()) {
+        fail(QStringLiteral("Cannot write the encrypted data."));
+        return false;
+    }
+
+    ++m_chunkIndex;
+    return true;
+}
+
+bool EncryptedDevice::readChunk()
+{
+    const QByteArray chunkHeader = m_device->read(s_chunkHeaderSize);
+    if (chunkHeader.size() != s_chunkHeaderSize) {
+        fail(QStringLiteral("The encrypted file is truncated."));
+        return false;
+    }
+
+    const quint8 flags = quint8(chunkHeader[0]);
+    const quint32 size = qFromBigEndian<quint32>(chunkHeader.constData() + 1);
+    if (size > m_chunkSize) {
+        fail(QStringLiteral("The encrypted file is corrupted."));
+        return false;
+    }
+
+    const QByteArray ciphertext = m_device->read(size + s_tagSize);
+    if (ciphertext.size() != qsizetype(size + s_tagSize)) {
+        fail(QStringLiteral("The encrypted file is truncated."));
+        return false;
+    }
+
+    const QByteArray iv = nonce();
+    const QByteArray aad = additionalData(flags);
+    m_buffer.fill(0);
+    m_buffer.resize(size);
+    m_bufferPosition = 0;
+
+    gcry_error_t error = gcry_cipher_reset(m_cipher);
+    if (!error) {
+        error = gcry_cipher_setiv(m_cipher, iv.constData(), iv.size());
+    }
+    if (!error) {
+        error = gcry_cipher_authenticate(m_cipher, aad.constData(), aad.size());
+    }
+    if (!error) {
+        error = gcry_cipher_final(m_cipher);
+    }
+    if (!error) {
+        error = gcry_cipher_decrypt(m_cipher, m_buffer.data(), size, ciphertext.constData(), size);
+    }
+    if (!error) {
+        error = gcry_cipher_checktag(m_cipher, ciphertext.constData() + size, s_tagSize);
+    }
+
+    if (error) {
+        m_buffer.fill(0);
+        m_buffer.clear();
+        if (gcry_err_code(error) == GPG_ERR_CHECKSUM) {
+            // The first chunk fails with a wrong passphrase, the others only if tampered with
+            fail(m_chunkIndex == 0 ? QStringLiteral("Wrong passphrase.") : QStringLiteral("The encrypted file is corrupted."));
+        } else {
+            fail(QStringLiteral("Decryption failed: ") + QString::fromUtf8(gcry_strerror(error)));
+        }
+        return false;
+    }
+
+    m_finalChunkSeen = flags & FinalChunk;
+    ++m_chunkIndex;
+    return true;
+}
+
+qint64 EncryptedDevice::readData(char *data, qint64 maxSize)
+{
+    if (m_error) {
+        return -1;
+    }
+
+    qint64 read = 0;
+    while (read < maxSize) {
+        if (m_bufferPosition >= m_buffer.size()) {
+            if (m_finalChunkSeen) {
+                break;
+            }
+            if (!readChunk()) {
+                return read > 0 ? read : -1;
+            }
+            continue;
+        }
+
+        const qint64 amount = qMin<qint64>(maxSize - read, m_buffer.size() - m_bufferPosition);
+        memcpy(data + read, m_buffer.constData() + m_bufferPosition, amount);
+        m_bufferPosition += amount;
+        read += amount;
+    }
+
+    return read;
+}
+
+#include "moc_encrypteddevice.cpp"
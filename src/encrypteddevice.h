@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+
+struct gcry_cipher_handle;
+
+/**
+ * Sequential device encrypting everything written to it, or decrypting
+ * everything read from it, with AES-256-GCM in fixed-size chunks.
+ * Only one chunk of plaintext is in memory at any time.
+ *
+ * header: "KSCRYPT1", quint8 kdf, quint32 iterations, 16 bytes salt,
+ *         8 bytes nonce prefix, quint32 chunk size
+ * chunks: quint8 flags, quint32 ciphertext size, ciphertext, 16 bytes tag
+ *
+ * The key is derived from the passphrase with PBKDF2-SHA256. Every chunk
+ * uses the nonce prefix followed by its index as nonce, and authenticates
+ * the header, its index and its flags: chunks can't be reordered, and a
+ * file missing the chunk flagged as final is reported as truncated.
+ */
+class EncryptedDevice : public QIODevice
+{
+    Q_OBJECT
+
+public:
+    EncryptedDevice(QIODevice *device, const QByteArray &passphrase, QObject *parent = nullptr);
+    ~EncryptedDevice() override;
+
+    // True if the device starts with the encryption magic, doesn't consume any data
+    static bool isEncrypted(QIODevice *device);
+    // Safe to call many times, from any thread, before using libgcrypt
+    static void initializeGcrypt();
+
+    // Only ReadOnly or WriteOnly
+    bool open(OpenMode mode) override;
+    // When writing, this writes the final chunk
+    void close() override;
+    bool isSequential() const override;
+    qint64 bytesAvailable() const override;
+
+    // Set on wrong passphrase, corruption or write errors, with errorString()
+    bool hasError() const;
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 size) override;
+
+private:
+    bool setupCipher();
+    bool writeHeader();
+    bool readHeader();
+    bool writeChunk(bool final);
+    bool readChunk();
+    QByteArray nonce() const;
+    QByteArray additionalData(quint8 flags) const;
+    void fail(const QString &message);
+
+    QIODevice *m_device;
+    QByteArray m_passphrase;
+    gcry_cipher_handle *m_cipher = nullptr;
+
+    QByteArray m_header;
+    QByteArray m_salt;
+    QByteArray m_noncePrefix;
+    quint32 m_iterations = 0;
+    quint32 m_chunkSize = 0;
+    quint32 m_chunkIndex = 0;
+
+    // Plaintext of the current chunk
+    QByteArray m_buffer;
+    qsizetype m_bufferPosition = 0;
+    bool m_finalChunkSeen = false;
+    bool m_error = false;
+};
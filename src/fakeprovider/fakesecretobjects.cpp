@@ -0,0 +1,820 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "fakesecretobjects.h"
+
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QDateTime>
+#include <QPointer>
+#include <QRandomGenerator>
+#include <QTimer>
+
+using namespace Qt::Literals::StringLiterals;
+
+static const QString s_basePath = u"/org/freedesktop/secrets"_s;
+static const QDBusObjectPath s_noPrompt = QDBusObjectPath(u"/"_s);
+
+static const QString s_errorFailed = u"org.freedesktop.DBus.Error.Failed"_s;
+static const QString s_errorNotSupported = u"org.freedesktop.DBus.Error.NotSupported"_s;
+static const QString s_errorIsLocked = u"org.freedesktop.Secret.Error.IsLocked"_s;
+static const QString s_errorNoSession = u"org.freedesktop.Secret.Error.NoSession"_s;
+static const QString s_errorNoSuchObject = u"org.freedesktop.Secret.Error.NoSuchObject"_s;
+
+static quint64 now()
+{
+    return QDateTime::currentSecsSinceEpoch();
+}
+
+QDBusArgument &operator<<(QDBusArgument &argument, const FakeSecret &secret)
+{
+    argument.beginStructure();
+    argument << secret.session << secret.parameters << secret.value << secret.contentType;
+    argument.endStructure();
+    return argument;
+}
+
+const QDBusArgument &operator>>(const QDBusArgument &argument, FakeSecret &secret)
+{
+    argument.beginStructure();
+    argument >> secret.session >> secret.parameters >> secret.value >> secret.contentType;
+    argument.endStructure();
+    return argument;
+}
+
+void registerFakeSecretTypes()
+{
+    qDBusRegisterMetaType<FakeSecret>();
+    qDBusRegisterMetaType<FakeStringMap>();
+    qDBusRegisterMetaType<FakeSecretMap>();
+}
+
+FakeObject::FakeObject(FakeService *service, const QString &path, QObject *parent)
+    : QObject(parent)
+    , m_service(service)
+    , m_path(path)
+{
+}
+
+FakeObject::~FakeObject()
+{
+}
+
+FakeService *FakeObject::service() const
+{
+    return m_service;
+}
+
+QString FakeObject::path() const
+{
+    return m_path;
+}
+
+QDBusObjectPath FakeObject::objectPath() const
+{
+    return QDBusObjectPath(m_path);
+}
+
+bool FakeObject::acceptCall()
+{
+    setDelayedReply(true);
+    if (m_service->shouldFail(message().member())) {
+        sendError(s_errorFailed, u"Injected failure of %1"_s.arg(message().member()));
+        return false;
+    }
+    return true;
+}
+
+void FakeObject::sendReply(const QVariantList &arguments, const std::function<void()> &then)
+{
+    m_service->sendLater(message().createReply(arguments), message().member(), this, then);
+}
+
+void FakeObject::sendError(const QString &name, const QString &text)
+{
+    m_service->sendLater(message().createErrorReply(name, text), message().member(), this, {});
+}
+
+void FakeObject::notifyPropertyChanged(const QString &property, const QVariant &value)
+{
+    const int index = metaObject()->indexOfClassInfo("D-Bus Interface");
+    QDBusMessage signal = QDBusMessage::createSignal(m_path, u"org.freedesktop.DBus.Properties"_s, u"PropertiesChanged"_s);
+    signal << QString::fromLatin1(metaObject()->classInfo(index).value()) << QVariantMap{{property, value}} << QStringList();
+    m_service->connection().send(signal);
+}
+
+void FakeObject::notifyPropertyInvalidated(const QString &property)
+{
+    const int index = metaObject()->indexOfClassInfo("D-Bus Interface");
+    QDBusMessage signal = QDBusMessage::createSignal(m_path, u"org.freedesktop.DBus.Properties"_s, u"PropertiesChanged"_s);
+    signal << QString::fromLatin1(metaObject()->classInfo(index).value()) << QVariantMap() << QStringList{property};
+    m_service->connection().send(signal);
+}
+
+FakeService::FakeService(const FakeSecretService::Options &options)
+    : FakeObject(this, s_basePath)
+    , m_options(options)
+    , m_connectionName(u"keepsecret-fake-secret-service-%1"_s.arg(quintptr(this), 0, 16))
+    , m_connection(m_connectionName)
+{
+}
+
+FakeService::~FakeService()
+{
+    if (m_connection.isConnected()) {
+        m_connection.unregisterService(u"org.freedesktop.secrets"_s);
+        m_connection.unregisterObject(s_basePath, QDBusConnection::UnregisterTree);
+    }
+    QDBusConnection::disconnectFromBus(m_connectionName);
+}
+
+bool FakeService::registerOnBus(QString *errorString)
+{
+    // Its own connection, so that the calls of the application are
+    // dispatched to this thread whatever the application is doing
+    m_connection = QDBusConnection::connectToBus(QDBusConnection::SessionBus, m_connectionName);
+    if (!m_connection.isConnected()) {
+        *errorString = u"Cannot connect to the session bus: %1"_s.arg(m_connection.lastError().message());
+        return false;
+    }
+
+    registerObject(this);
+    if (!m_connection.registerService(u"org.freedesktop.secrets"_s)) {
+        *errorString = u"Cannot register org.freedesktop.secrets: %1"_s.arg(m_connection.lastError().message());
+        return false;
+    }
+
+    if (!m_options.defaultCollectionLabel.isEmpty()) {
+        m_aliases[u"default"_s] = createCollection(m_options.defaultCollectionLabel)->path();
+    }
+    return true;
+}
+
+void FakeService::setOptions(const FakeSecretService::Options &options)
+{
+    m_options = options;
+}
+
+QDBusConnection FakeService::connection() const
+{
+    return m_connection;
+}
+
+bool FakeService::shouldFail(const QString &member)
+{
+    m_callCount.fetch_add(1, std::memory_order_relaxed);
+    if (m_options.failureRate <= 0) {
+        return false;
+    }
+    if (!m_options.failingMethods.isEmpty() && !m_options.failingMethods.contains(member)) {
+        return false;
+    }
+    return QRandomGenerator::global()->generateDouble() < m_options.failureRate;
+}
+
+quint64 FakeService::callCount() const
+{
+    return m_callCount.load(std::memory_order_relaxed);
+}
+
+void FakeService::sendLater(const QDBusMessage &message, const QString &member, QObject *context, const std::function<void()> &then)
+{
+    std::chrono::milliseconds delay = m_options.methodLatencies.value(member, m_options.latency);
+    if (m_options.jitter > std::chrono::milliseconds::zero()) {
+        delay += std::chrono::milliseconds(QRandomGenerator::global()->bounded(qint64(m_options.jitter.count()) + 1));
+    }
+
+    // The reply also goes out if context is deleted meanwhile, like
+    // a collection answering to its own Delete
+    QPointer<QObject> guard(context);
+    auto send = [this, message, guard, then]() {
+        m_connection.send(message);
+        if (then && guard) {
+            then();
+        }
+    };
+
+    if (delay <= std::chrono::milliseconds::zero()) {
+        send();
+    } else {
+        QTimer::singleShot(delay, this, send);
+    }
+}
+
+void FakeService::registerObject(FakeObject *object)
+{
+    m_connection.registerObject(object->path(),
+                                object,
+                                QDBusConnection::ExportAllSlots | QDBusConnection::ExportAllSignals | QDBusConnection::ExportAllProperties);
+}
+
+void FakeService::unregisterObject(FakeObject *object)
+{
+    m_connection.unregisterObject(object->path());
+}
+
+QList<QDBusObjectPath> FakeService::collections() const
+{
+    QList<QDBusObjectPath> paths;
+    paths.reserve(m_collections.size());
+    for (FakeCollection *collection : m_collections) {
+        paths.append(collection->objectPath());
+    }
+    return paths;
+}
+
+FakeCollection *FakeService::findCollection(const QString &path) const
+{
+    for (FakeCollection *collection : m_collections) {
+        if (collection->path() == path) {
+            return collection;
+        }
+    }
+    return nullptr;
+}
+
+FakeItem *FakeService::findItem(const QString &path) const
+{
+    FakeCollection *collection = findCollection(path.section(u'/', 0, -2));
+    return collection ? collection->findItem(path) : nullptr;
+}
+
+FakeCollection *FakeService::collectionOf(const QString &path) const
+{
+    if (FakeCollection *collection = findCollection(path)) {
+        return collection;
+    }
+    return findItem(path) ? findCollection(path.section(u'/', 0, -2)) : nullptr;
+}
+
+bool FakeService::hasSession(const QDBusObjectPath &session) const
+{
+    return m_sessions.contains(session.path());
+}
+
+FakeCollection *FakeService::createCollection(const QString &label)
+{
+    QString name;
+    for (const QChar c : label) {
+        name += c.isLetterOrNumber() && c.unicode() < 128 ? c.toLower() : u'_';
+    }
+    if (name.isEmpty()) {
+        name = u"collection"_s;
+    }
+    QString path = s_basePath + u"/collection/"_s + name;
+    for (int i = 1; findCollection(path); ++i) {
+        path = s_basePath + u"/collection/"_s + name + QString::number(i);
+    }
+
+    auto *collection = new FakeCollection(this, path, label);
+    m_collections.append(collection);
+    registerObject(collection);
+
+    Q_EMIT CollectionCreated(collection->objectPath());
+    notifyPropertyChanged(u"Collections"_s, QVariant::fromValue(collections()));
+    return collection;
+}
+
+void FakeService::removeCollection(FakeCollection *collection)
+{
+    m_connection.unregisterObject(collection->path(), QDBusConnection::UnregisterTree);
+    m_collections.removeOne(collection);
+    for (auto it = m_aliases.begin(); it != m_aliases.end();) {
+        if (it.value() == collection->path()) {
+            it = m_aliases.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    Q_EMIT CollectionDeleted(collection->objectPath());
+    notifyPropertyChanged(u"Collections"_s, QVariant::fromValue(collections()));
+    collection->deleteLater();
+}
+
+void FakeService::notifyCollectionChanged(FakeCollection *collection)
+{
+    Q_EMIT CollectionChanged(collection->objectPath());
+}
+
+void FakeService::removeObject(FakeObject *object)
+{
+    unregisterObject(object);
+    m_sessions.remove(object->path());
+    object->deleteLater();
+}
+
+void FakeService::OpenSession(const QString &algorithm, const QDBusVariant &input)
+{
+    Q_UNUSED(input)
+    if (!acceptCall()) {
+        return;
+    }
+    // libsecret falls back to plain on this error
+    if (algorithm != u"plain"_s) {
+        sendError(s_errorNotSupported, u"Only the plain algorithm is supported"_s);
+        return;
+    }
+
+    auto *session = new FakeSession(this, s_basePath + u"/session/"_s + QString::number(++m_lastObjectId));
+    m_sessions.insert(session->path());
+    registerObject(session);
+    sendReply({QVariant::fromValue(QDBusVariant(QString())), QVariant::fromValue(session->objectPath())});
+}
+
+void FakeService::CreateCollection(const QVariantMap &properties, const QString &alias)
+{
+    if (!acceptCall()) {
+        return;
+    }
+
+    FakeCollection *collection = alias.isEmpty() ? nullptr : findCollection(m_aliases.value(alias));
+    if (!collection) {
+        collection = createCollection(properties.value(u"org.freedesktop.Secret.Collection.Label"_s).toString());
+        if (!alias.isEmpty()) {
+            m_aliases[alias] = collection->path();
+        }
+    }
+    sendReply({QVariant::fromValue(collection->objectPath()), QVariant::fromValue(s_noPrompt)});
+}
+
+void FakeService::SearchItems(const FakeStringMap &attributes)
+{
+    if (!acceptCall()) {
+        return;
+    }
+
+    QList<QDBusObjectPath> unlocked;
+    QList<QDBusObjectPath> locked;
+    for (FakeCollection *collection : std::as_const(m_collections)) {
+        QList<QDBusObjectPath> &paths = collection->isLocked() ? locked : unlocked;
+        for (FakeItem *item : collection->search(attributes)) {
+            paths.append(item->objectPath());
+        }
+    }
+    sendReply({QVariant::fromValue(unlocked), QVariant::fromValue(locked)});
+}
+
+void FakeService::Unlock(const QList<QDBusObjectPath> &objects)
+{
+    if (!acceptCall()) {
+        return;
+    }
+
+    QList<QDBusObjectPath> unlocked;
+    QList<QDBusObjectPath> pending;
+    for (const QDBusObjectPath &object : objects) {
+        FakeCollection *collection = collectionOf(object.path());
+        if (!collection) {
+            continue;
+        }
+        (collection->isLocked() ? pending : unlocked).append(object);
+    }
+
+    if (pending.isEmpty()) {
+        sendReply({QVariant::fromValue(unlocked), QVariant::fromValue(s_noPrompt)});
+        return;
+    }
+
+    auto *prompt = new FakePrompt(this, s_basePath + u"/prompt/"_s + QString::number(++m_lastObjectId), [this, pending]() {
+        QList<QDBusObjectPath> unlocked;
+        for (const QDBusObjectPath &object : pending) {
+            if (FakeCollection *collection = collectionOf(object.path())) {
+                collection->setLocked(false);
+                unlocked.append(object);
+            }
+        }
+        return QDBusVariant(QVariant::fromValue(unlocked));
+    });
+    registerObject(prompt);
+    sendReply({QVariant::fromValue(unlocked), QVariant::fromValue(prompt->objectPath())});
+}
+
+void FakeService::Lock(const QList<QDBusObjectPath> &objects)
+{
+    if (!acceptCall()) {
+        return;
+    }
+
+    QList<QDBusObjectPath> locked;
+    for (const QDBusObjectPath &object : objects) {
+        if (FakeCollection *collection = collectionOf(object.path())) {
+            collection->setLocked(true);
+            locked.append(object);
+        }
+    }
+    sendReply({QVariant::fromValue(locked), QVariant::fromValue(s_noPrompt)});
+}
+
+void FakeService::GetSecrets(const QList<QDBusObjectPath> &items, const QDBusObjectPath &session)
+{
+    if (!acceptCall()) {
+        return;
+    }
+    if (!hasSession(session)) {
+        sendError(s_errorNoSession, u"No such session %1"_s.arg(session.path()));
+        return;
+    }
+
+    // Locked items are left out
+    FakeSecretMap secrets;
+    for (const QDBusObjectPath &path : items) {
+        FakeItem *item = findItem(path.path());
+        if (item && !item->isLocked()) {
+            secrets.insert(path, item->secret(session));
+        }
+    }
+    sendReply({QVariant::fromValue(secrets)});
+}
+
+void FakeService::ReadAlias(const QString &name)
+{
+    if (!acceptCall()) {
+        return;
+    }
+
+    FakeCollection *collection = findCollection(m_aliases.value(name));
+    sendReply({QVariant::fromValue(collection ? collection->objectPath() : s_noPrompt)});
+}
+
+void FakeService::SetAlias(const QString &name, const QDBusObjectPath &collection)
+{
+    if (!acceptCall()) {
+        return;
+    }
+
+    if (collection.path() == u"/"_s) {
+        m_aliases.remove(name);
+    } else if (findCollection(collection.path())) {
+        m_aliases[name] = collection.path();
+    } else {
+        sendError(s_errorNoSuchObject, u"No such collection %1"_s.arg(collection.path()));
+        return;
+    }
+    sendReply();
+}
+
+FakeCollection::FakeCollection(FakeService *service, const QString &path, const QString &label)
+    : FakeObject(service, path, service)
+    , m_label(label)
+    , m_created(now())
+    , m_modified(m_created)
+{
+}
+
+FakeCollection::~FakeCollection()
+{
+}
+
+QList<QDBusObjectPath> FakeCollection::items() const
+{
+    QList<QDBusObjectPath> paths;
+    paths.reserve(m_items.size());
+    for (FakeItem *item : m_items) {
+        paths.append(item->objectPath());
+    }
+    return paths;
+}
+
+QList<FakeItem *> FakeCollection::itemObjects() const
+{
+    return m_items;
+}
+
+FakeItem *FakeCollection::findItem(const QString &path) const
+{
+    return m_itemsByPath.value(path);
+}
+
+QList<FakeItem *> FakeCollection::search(const FakeStringMap &attributes) const
+{
+    QList<FakeItem *> found;
+    for (FakeItem *item : m_items) {
+        const FakeStringMap itemAttributes = item->attributes();
+        bool matches = true;
+        for (auto it = attributes.constBegin(); it != attributes.constEnd() && matches; ++it) {
+            matches = itemAttributes.value(it.key()) == it.value() && itemAttributes.contains(it.key());
+        }
+        if (matches) {
+            found.append(item);
+        }
+    }
+    return found;
+}
+
+QString FakeCollection::label() const
+{
+    return m_label;
+}
+
+void FakeCollection::setLabel(const QString &label)
+{
+    if (label == m_label) {
+        return;
+    }
+    m_label = label;
+    touch();
+    notifyPropertyChanged(u"Label"_s, m_label);
+}
+
+bool FakeCollection::isLocked() const
+{
+    return m_locked;
+}
+
+void FakeCollection::setLocked(bool locked)
+{
+    if (locked == m_locked) {
+        return;
+    }
+    m_locked = locked;
+    notifyPropertyChanged(u"Locked"_s, m_locked);
+    for (FakeItem *item : std::as_const(m_items)) {
+        notifyItemChanged(item);
+    }
+    m_service->notifyCollectionChanged(this);
+}
+
+quint64 FakeCollection::created() const
+{
+    return m_created;
+}
+
+quint64 FakeCollection::modified() const
+{
+    return m_modified;
+}
+
+void FakeCollection::touch()
+{
+    m_modified = now();
+    m_service->notifyCollectionChanged(this);
+}
+
+void FakeCollection::removeItem(FakeItem *item)
+{
+    m_service->unregisterObject(item);
+    m_items.removeOne(item);
+    m_itemsByPath.remove(item->path());
+    Q_EMIT ItemDeleted(item->objectPath());
+    // Sending the whole list each time would be quadratic in bulk changes
+    notifyPropertyInvalidated(u"Items"_s);
+    touch();
+    item->deleteLater();
+}
+
+void FakeCollection::notifyItemChanged(FakeItem *item)
+{
+    Q_EMIT ItemChanged(item->objectPath());
+}
+
+void FakeCollection::Delete()
+{
+    if (!acceptCall()) {
+        return;
+    }
+
+    sendReply({QVariant::fromValue(s_noPrompt)});
+    m_service->removeCollection(this);
+}
+
+void FakeCollection::SearchItems(const FakeStringMap &attributes)
+{
+    if (!acceptCall()) {
+        return;
+    }
+
+    QList<QDBusObjectPath> paths;
+    for (FakeItem *item : search(attributes)) {
+        paths.append(item->objectPath());
+    }
+    sendReply({QVariant::fromValue(paths)});
+}
+
+void FakeCollection::CreateItem(const QVariantMap &properties, const FakeSecret &secret, bool replace)
+{
+    if (!acceptCall()) {
+        return;
+    }
+    if (m_locked) {
+        sendError(s_errorIsLocked, u"The collection %1 is locked"_s.arg(path()));
+        return;
+    }
+    if (!m_service->hasSession(secret.session)) {
+        sendError(s_errorNoSession, u"No such session %1"_s.arg(secret.session.path()));
+        return;
+    }
+
+    const QString label = properties.value(u"org.freedesktop.Secret.Item.Label"_s).toString();
+    // Nested in the a{sv}, so still marshalled
+    const FakeStringMap attributes = qdbus_cast<FakeStringMap>(properties.value(u"org.freedesktop.Secret.Item.Attributes"_s));
+
+    if (replace) {
+        for (FakeItem *item : std::as_const(m_items)) {
+            if (item->attributes() == attributes) {
+                item->setLabel(label);
+                item->setSecret(secret);
+                sendReply({QVariant::fromValue(item->objectPath()), QVariant::fromValue(s_noPrompt)});
+                return;
+            }
+        }
+    }
+
+    auto *item = new FakeItem(this, path() + u'/' + QString::number(++m_lastItemId), label, attributes, secret);
+    m_items.append(item);
+    m_itemsByPath.insert(item->path(), item);
+    m_service->registerObject(item);
+
+    Q_EMIT ItemCreated(item->objectPath());
+    notifyPropertyInvalidated(u"Items"_s);
+    touch();
+    sendReply({QVariant::fromValue(item->objectPath()), QVariant::fromValue(s_noPrompt)});
+}
+
+FakeItem::FakeItem(FakeCollection *collection, const QString &path, const QString &label, const FakeStringMap &attributes, const FakeSecret &secret)
+    : FakeObject(collection->service(), path, collection)
+    , m_collection(collection)
+    , m_attributes(attributes)
+    , m_label(label)
+    , m_value(secret.value)
+    , m_contentType(secret.contentType)
+    , m_created(now())
+    , m_modified(m_created)
+{
+}
+
+FakeItem::~FakeItem()
+{
+}
+
+bool FakeItem::isLocked() const
+{
+    return m_collection->isLocked();
+}
+
+FakeStringMap FakeItem::attributes() const
+{
+    return m_attributes;
+}
+
+void FakeItem::setAttributes(const FakeStringMap &attributes)
+{
+    if (attributes == m_attributes) {
+        return;
+    }
+    m_attributes = attributes;
+    touch();
+    notifyPropertyChanged(u"Attributes"_s, QVariant::fromValue(m_attributes));
+}
+
+QString FakeItem::label() const
+{
+    return m_label;
+}
+
+void FakeItem::setLabel(const QString &label)
+{
+    if (label == m_label) {
+        return;
+    }
+    m_label = label;
+    touch();
+    notifyPropertyChanged(u"Label"_s, m_label);
+}
+
+quint64 FakeItem::created() const
+{
+    return m_created;
+}
+
+quint64 FakeItem::modified() const
+{
+    return m_modified;
+}
+
+FakeSecret FakeItem::secret(const QDBusObjectPath &session) const
+{
+    // With the plain algorithm the value travels as it is
+    return FakeSecret{session, QByteArray(), m_value, m_contentType};
+}
+
+void FakeItem::setSecret(const FakeSecret &secret)
+{
+    m_value = secret.value;
+    m_contentType = secret.contentType;
+    touch();
+}
+
+void FakeItem::touch()
+{
+    m_modified = now();
+    notifyPropertyChanged(u"Modified"_s, m_modified);
+    m_collection->notifyItemChanged(this);
+}
+
+void FakeItem::Delete()
+{
+    if (!acceptCall()) {
+        return;
+    }
+    if (isLocked()) {
+        sendError(s_errorIsLocked, u"The item %1 is locked"_s.arg(path()));
+        return;
+    }
+
+    sendReply({QVariant::fromValue(s_noPrompt)});
+    m_collection->removeItem(this);
+}
+
+void FakeItem::GetSecret(const QDBusObjectPath &session)
+{
+    if (!acceptCall()) {
+        return;
+    }
+    if (isLocked()) {
+        sendError(s_errorIsLocked, u"The item %1 is locked"_s.arg(path()));
+        return;
+    }
+    if (!m_service->hasSession(session)) {
+        sendError(s_errorNoSession, u"No such session %1"_s.arg(session.path()));
+        return;
+    }
+
+    sendReply({QVariant::fromValue(secret(session))});
+}
+
+void FakeItem::SetSecret(const FakeSecret &secret)
+{
+    if (!acceptCall()) {
+        return;
+    }
+    if (isLocked()) {
+        sendError(s_errorIsLocked, u"The item %1 is locked"_s.arg(path()));
+        return;
+    }
+    if (!m_service->hasSession(secret.session)) {
+        sendError(s_errorNoSession, u"No such session %1"_s.arg(secret.session.path()));
+        return;
+    }
+
+    setSecret(secret);
+    sendReply();
+}
+
+FakeSession::FakeSession(FakeService *service, const QString &path)
+    : FakeObject(service, path, service)
+{
+}
+
+FakeSession::~FakeSession()
+{
+}
+
+void FakeSession::Close()
+{
+    if (!acceptCall()) {
+        return;
+    }
+
+    sendReply();
+    m_service->removeObject(this);
+}
+
+FakePrompt::FakePrompt(FakeService *service, const QString &path, const std::function<QDBusVariant()> &complete)
+    : FakeObject(service, path, service)
+    , m_complete(complete)
+{
+}
+
+FakePrompt::~FakePrompt()
+{
+}
+
+void FakePrompt::Prompt(const QString &windowId)
+{
+    Q_UNUSED(windowId)
+    if (!acceptCall()) {
+        return;
+    }
+
+    // Completed only after the reply, as the user answers after the prompt shows
+    sendReply({}, [this]() {
+        Q_EMIT Completed(false, m_complete());
+        m_service->removeObject(this);
+    });
+}
+
+void FakePrompt::Dismiss()
+{
+    if (!acceptCall()) {
+        return;
+    }
+
+    sendReply({}, [this]() {
+        Q_EMIT Completed(true, QDBusVariant(QString()));
+        m_service->removeObject(this);
+    });
+}
+
+#include "moc_fakesecretobjects.cpp"
@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "fakesecretservice.h"
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusContext>
+#include <QDBusObjectPath>
+#include <QDBusVariant>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QVariantMap>
+#include <atomic>
+#include <functional>
+
+class FakeCollection;
+class FakeItem;
+class FakeService;
+
+// The Secret struct of the specification, (oayays)
+struct FakeSecret {
+    QDBusObjectPath session;
+    QByteArray parameters;
+    QByteArray value;
+    QString contentType;
+};
+Q_DECLARE_METATYPE(FakeSecret)
+
+QDBusArgument &operator<<(QDBusArgument &argument, const FakeSecret &secret);
+const QDBusArgument &operator>>(const QDBusArgument &argument, FakeSecret &secret);
+
+using FakeStringMap = QMap<QString, QString>;
+using FakeSecretMap = QMap<QDBusObjectPath, FakeSecret>;
+
+// Needed once before anything goes on the bus
+void registerFakeSecretTypes();
+
+/**
+ * Base of all the objects exported on the bus. The D-Bus methods are
+ * public slots named like in the specification: they call acceptCall()
+ * first, then answer with sendReply() or sendError(), which apply the
+ * latency of the options.
+ */
+class FakeObject : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+
+public:
+    FakeObject(FakeService *service, const QString &path, QObject *parent = nullptr);
+    ~FakeObject() override;
+
+    FakeService *service() const;
+    QString path() const;
+    QDBusObjectPath objectPath() const;
+
+protected:
+    // Marks the current call as answered later. False if it has to fail
+    // by injection, the error reply is already on its way then
+    bool acceptCall();
+    // then() runs once the reply has been sent
+    void sendReply(const QVariantList &arguments = QVariantList(), const std::function<void()> &then = {});
+    void sendError(const QString &name, const QString &text);
+
+    // Emit org.freedesktop.DBus.Properties.PropertiesChanged
+    void notifyPropertyChanged(const QString &property, const QVariant &value);
+    void notifyPropertyInvalidated(const QString &property);
+
+    FakeService *m_service;
+
+private:
+    QString m_path;
+};
+
+class FakeService : public FakeObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.Secret.Service")
+    Q_PROPERTY(QList<QDBusObjectPath> Collections READ collections)
+
+public:
+    explicit FakeService(const FakeSecretService::Options &options);
+    ~FakeService() override;
+
+    bool registerOnBus(QString *errorString);
+    void setOptions(const FakeSecretService::Options &options);
+    QDBusConnection connection() const;
+
+    // Also counts the call
+    bool shouldFail(const QString &member);
+    // Safe to read from any thread
+    quint64 callCount() const;
+    // After the latency of member. then() is skipped if context is gone
+    void sendLater(const QDBusMessage &message, const QString &member, QObject *context, const std::function<void()> &then);
+
+    void registerObject(FakeObject *object);
+    void unregisterObject(FakeObject *object);
+
+    QList<QDBusObjectPath> collections() const;
+    FakeCollection *findCollection(const QString &path) const;
+    FakeItem *findItem(const QString &path) const;
+    bool hasSession(const QDBusObjectPath &session) const;
+
+    FakeCollection *createCollection(const QString &label);
+    void removeCollection(FakeCollection *collection);
+    void notifyCollectionChanged(FakeCollection *collection);
+    void removeObject(FakeObject *object);
+
+public Q_SLOTS:
+    void OpenSession(const QString &algorithm, const QDBusVariant &input);
+    void CreateCollection(const QVariantMap &properties, const QString &alias);
+    void SearchItems(const FakeStringMap &attributes);
+    void Unlock(const QList<QDBusObjectPath> &objects);
+    void Lock(const QList<QDBusObjectPath> &objects);
+    void GetSecrets(const QList<QDBusObjectPath> &items, const QDBusObjectPath &session);
+    void ReadAlias(const QString &name);
+    void SetAlias(const QString &name, const QDBusObjectPath &collection);
+
+Q_SIGNALS:
+    void CollectionCreated(const QDBusObjectPath &collection);
+    void CollectionDeleted(const QDBusObjectPath &collection);
+    void CollectionChanged(const QDBusObjectPath &collection);
+
+private:
+    FakeCollection *collectionOf(const QString &path) const;
+
+    FakeSecretService::Options m_options;
+    const QString m_connectionName;
+    QDBusConnection m_connection;
+    QList<FakeCollection *> m_collections;
+    QSet<QString> m_sessions;
+    // Name to collection path
+    QHash<QString, QString> m_aliases;
+    quint64 m_lastObjectId = 0;
+    std::atomic<quint64> m_callCount = 0;
+};
+
+class FakeCollection : public FakeObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.Secret.Collection")
+    Q_PROPERTY(QList<QDBusObjectPath> Items READ items)
+    Q_PROPERTY(QString Label READ label WRITE setLabel)
+    Q_PROPERTY(bool Locked READ isLocked)
+    Q_PROPERTY(quint64 Created READ created)
+    Q_PROPERTY(quint64 Modified READ modified)
+
+public:
+    FakeCollection(FakeService *service, const QString &path, const QString &label);
+    ~FakeCollection() override;
+
+    QList<QDBusObjectPath> items() const;
+    QList<FakeItem *> itemObjects() const;
+    FakeItem *findItem(const QString &path) const;
+    QList<FakeItem *> search(const FakeStringMap &attributes) const;
+
+    QString label() const;
+    void setLabel(const QString &label);
+    bool isLocked() const;
+    void setLocked(bool locked);
+    quint64 created() const;
+    quint64 modified() const;
+
+    void removeItem(FakeItem *item);
+    void notifyItemChanged(FakeItem *item);
+
+public Q_SLOTS:
+    void Delete();
+    void SearchItems(const FakeStringMap &attributes);
+    void CreateItem(const QVariantMap &properties, const FakeSecret &secret, bool replace);
+
+Q_SIGNALS:
+    void ItemCreated(const QDBusObjectPath &item);
+    void ItemDeleted(const QDBusObjectPath &item);
+    void ItemChanged(const QDBusObjectPath &item);
+
+private:
+    void touch();
+
+    QList<FakeItem *> m_items;
+    QHash<QString, FakeItem *> m_itemsByPath;
+    QString m_label;
+    bool m_locked = false;
+    quint64 m_created;
+    quint64 m_modified;
+    quint64 m_lastItemId = 0;
+};
+
+class FakeItem : public FakeObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.Secret.Item")
+    Q_PROPERTY(bool Locked READ isLocked)
+    Q_PROPERTY(FakeStringMap Attributes READ attributes WRITE setAttributes)
+    Q_PROPERTY(QString Label READ label WRITE setLabel)
+    Q_PROPERTY(quint64 Created READ created)
+    Q_PROPERTY(quint64 Modified READ modified)
+
+public:
+    FakeItem(FakeCollection *collection, const QString &path, const QString &label, const FakeStringMap &attributes, const FakeSecret &secret);
+    ~FakeItem() override;
+
+    bool isLocked() const;
+    FakeStringMap attributes() const;
+    void setAttributes(const FakeStringMap &attributes);
+    QString label() const;
+    void setLabel(const QString &label);
+    quint64 created() const;
+    quint64 modified() const;
+
+    FakeSecret secret(const QDBusObjectPath &session) const;
+    void setSecret(const FakeSecret &secret);
+
+public Q_SLOTS:
+    void Delete();
+    void GetSecret(const QDBusObjectPath &session);
+    void SetSecret(const FakeSecret &secret);
+
+private:
+    void touch();
+
+    FakeCollection *m_collection;
+    FakeStringMap m_attributes;
+    QString m_label;
+    QByteArray m_value;
+    QString m_contentType;
+    quint64 m_created;
+    quint64 m_modified;
+};
+
+class FakeSession : public FakeObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.Secret.Session")
+
+public:
+    FakeSession(FakeService *service, const QString &path);
+    ~FakeSession() override;
+
+public Q_SLOTS:
+    void Close();
+};
+
+/**
+ * Completes by itself, as if the user had answered right away:
+ * the result comes from complete() at that moment
+ */
+class FakePrompt : public FakeObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.freedesktop.Secret.Prompt")
+
+public:
+    FakePrompt(FakeService *service, const QString &path, const std::function<QDBusVariant()> &complete);
+    ~FakePrompt() override;
+
+public Q_SLOTS:
+    void Prompt(const QString &windowId);
+    void Dismiss();
+
+Q_SIGNALS:
+    void Completed(bool dismissed, const QDBusVariant &result);
+
+private:
+    std::function<QDBusVariant()> m_complete;
+};
@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "fakesecretservice.h"
+#include "fakesecretobjects.h"
+
+FakeSecretService::FakeSecretService(const Options &options)
+    : m_options(options)
+{
+    m_thread.setObjectName(QStringLiteral("FakeSecretService"));
+}
+
+FakeSecretService::~FakeSecretService()
+{
+    stop();
+}
+
+bool FakeSecretService::start()
+{
+    if (m_service) {
+        return true;
+    }
+
+    registerFakeSecretTypes();
+    m_service = new FakeService(m_options);
+    m_service->moveToThread(&m_thread);
+    // Also after a failed start, the objects are deleted in their thread
+    QObject::connect(&m_thread, &QThread::finished, m_service, &QObject::deleteLater);
+    m_thread.start();
+
+    bool registered = false;
+    QMetaObject::invokeMethod(
+        m_service,
+        [this, &registered]() {
+            registered = m_service->registerOnBus(&m_errorString);
+        },
+        Qt::BlockingQueuedConnection);
+
+    if (!registered) {
+        stop();
+    }
+    return registered;
+}
+
+void FakeSecretService::stop()
+{
+    if (!m_service) {
+        return;
+    }
+
+    m_thread.quit();
+    m_thread.wait();
+    m_service = nullptr;
+}
+
+bool FakeSecretService::isRunning() const
+{
+    return m_service != nullptr;
+}
+
+void FakeSecretService::setOptions(const Options &options)
+{
+    m_options = options;
+    if (!m_service) {
+        return;
+    }
+    QMetaObject::invokeMethod(
+        m_service,
+        [this, options]() {
+            m_service->setOptions(options);
+        },
+        Qt::BlockingQueuedConnection);
+}
+
+FakeSecretService::Options FakeSecretService::options() const
+{
+    return m_options;
+}
+
+quint64 FakeSecretService::callCount() const
+{
+    return m_service ? m_service->callCount() : 0;
+}
+
+QString FakeSecretService::errorString() const
+{
+    return m_errorString;
+}
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <chrono>
+
+class FakeService;
+
+/**
+ * A stand-in for a Secret Service provider, which registers
+ * org.freedesktop.secrets on the session bus from a thread of this process.
+ * It implements the Service, Collection, Item, Session and Prompt
+ * interfaces, in memory and only with the plain algorithm, so it must only
+ * ever be started on a private bus.
+ * Every method call can be answered late or fail, to see how the
+ * application behaves with a slow or unreliable provider. Properties are
+ * read and written by QtDBus directly, without latency.
+ * Collections start unlocked; unlocking a locked one goes through a Prompt
+ * which completes by itself after the latency.
+ */
+class FakeSecretService
+{
+public:
+    struct Options {
+        // Added to the reply of every method call
+        std::chrono::milliseconds latency = std::chrono::milliseconds::zero();
+        // A random amount up to this is added to the latency of each call
+        std::chrono::milliseconds jitter = std::chrono::milliseconds::zero();
+        // By D-Bus member name, instead of latency
+        QHash<QString, std::chrono::milliseconds> methodLatencies;
+        // Chance from 0 to 1 for a call to fail with
+        // org.freedesktop.DBus.Error.Failed, without side effects
+        qreal failureRate = 0;
+        // If not empty only these members fail
+        QStringList failingMethods;
+        // Created at start, with the default alias. None if empty
+        QString defaultCollectionLabel = QStringLiteral("Login");
+    };
+
+    explicit FakeSecretService(const Options &options = Options());
+    ~FakeSecretService();
+    Q_DISABLE_COPY_MOVE(FakeSecretService)
+
+    // Connects to the session bus of DBUS_SESSION_BUS_ADDRESS. False if
+    // the bus can't be reached or the name is already taken
+    bool start();
+    void stop();
+    bool isRunning() const;
+
+    // Takes effect for the calls arriving from now on
+    void setOptions(const Options &options);
+    Options options() const;
+
+    // Method calls received since start(), property reads excluded
+    quint64 callCount() const;
+
+    QString errorString() const;
+
+private:
+    Options m_options;
+    QThread m_thread;
+    // Lives in m_thread
+    FakeService *m_service = nullptr;
+    QString m_errorString;
+};
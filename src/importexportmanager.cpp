@@ -2,193 +2,768 @@
 // SPDX-FileCopyrightText: 2026 Roshani Kumari <roshnikumarii098@gmail.com>
 
 #include "importexportmanager.h"
+#include "backupjournal.h"
+#include "binarybackup.h"
+#include "collectionsbackup.h"
+#include "csvreader.h"
+#include "csvwriter.h"
+#include "encrypteddevice.h"
+#include "keepsecret_debug.h"
+#include "kwalletfilereader.h"
+#include "tracing.h"
+#include "walletxmlreader.h"
+#include "walletxmlwriter.h"
 
-#include <QDomDocument>
-#include <QDomElement>
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QElapsedTimer>
 #include <QFile>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
+
+// Amount of items emitted at once while importing
+static constexpr int s_importChunkSize = 256;
+// How often the worker reports its progress, in items
+static constexpr int s_progressInterval = 64;
 
-ImportExportManager::ImportExportManager(QObject *parent)
+ImportExportManager::ImportExportManager(SecretServiceClient *secretServiceClient, QObject *parent)
     : QObject(parent)
+    , m_secretServiceClient(secretServiceClient)
+{
+}
+
+ImportExportManager::~ImportExportManager()
+{
+    if (m_thread) {
+        cancel();
+        m_thread->wait();
+    }
+}
+
+bool ImportExportManager::isRunning() const
+{
+    return m_thread != nullptr;
+}
+
+qreal ImportExportManager::progress() const
+{
+    return m_progress;
+}
+
+int ImportExportManager::itemsProcessed() const
+{
+    return m_itemsProcessed;
+}
+
+void ImportExportManager::cancel()
+{
+    if (!m_thread) {
+        return;
+    }
+
+    if (m_collectionsBackup) {
+        m_collectionsBackup->cancel();
+        m_collectionsBackup->deleteLater();
+        m_collectionsBackup = nullptr;
+    }
+
+    QMutexLocker locker(&m_backlogMutex);
+    m_cancelRequested = true;
+    m_backlogCondition.wakeAll();
+}
+
+void ImportExportManager::setImportBacklog(int pendingItems)
+{
+    QMutexLocker locker(&m_backlogMutex);
+    m_importBacklog = pendingItems;
+    m_backlogCondition.wakeAll();
+}
+
+bool ImportExportManager::startJob(std::function<void()> job)
+{
+    if (m_thread) {
+        Q_EMIT errorOccurred(QStringLiteral("An import or export is already in progress."));
+        return false;
+    }
+
+    m_cancelRequested = false;
+    m_importBacklog = 0;
+    m_chunksInFlight = 0;
+    m_progress = 0;
+    m_itemsProcessed = 0;
+
+    m_thread = QThread::create(std::move(job));
+    connect(m_thread, &QThread::finished, this, &ImportExportManager::finishJob);
+    m_thread->start(QThread::LowPriority);
+
+    Q_EMIT runningChanged();
+    Q_EMIT progressChanged();
+    return true;
+}
+
+void ImportExportManager::finishJob()
+{
+    // The worker may have given up before all the collections were read
+    if (m_collectionsBackup) {
+        m_collectionsBackup->cancel();
+        m_collectionsBackup->deleteLater();
+        m_collectionsBackup = nullptr;
+    }
+    m_backupSections.clear();
+
+    m_thread->deleteLater();
+    m_thread = nullptr;
+    Q_EMIT runningChanged();
+}
+
+void ImportExportManager::postProgress(qreal progress, int itemsProcessed)
+{
+    QMetaObject::invokeMethod(
+        this,
+        [this, progress, itemsProcessed]() {
+            m_progress = progress;
+            m_itemsProcessed = itemsProcessed;
+            Q_EMIT progressChanged();
+        },
+        Qt::QueuedConnection);
+}
+
+void ImportExportManager::postError(const QString &message)
 {
+    QMetaObject::invokeMethod(
+        this,
+        [this, message]() {
+            Q_EMIT errorOccurred(message);
+        },
+        Qt::QueuedConnection);
 }
 
 void ImportExportManager::exportToFile(const QString &filePath, const QString &walletName, const QVariantList &items)
 {
-    QDomDocument doc;
-    QDomElement root = doc.createElement(QStringLiteral("wallet"));
-    root.setAttribute(QStringLiteral("name"), walletName);
-    doc.appendChild(root);
+    startExport(filePath, walletName, items, [](QIODevice *device) {
+        return std::make_unique<WalletXmlWriter>(device);
+    });
+}
+
+void ImportExportManager::exportToBinaryFile(const QString &filePath, const QString &walletName, const QVariantList &items, bool compress)
+{
+    startExport(filePath, walletName, items, [compress](QIODevice *device) {
+        return std::make_unique<BinaryBackupWriter>(device, compress);
+    });
+}
+
+void ImportExportManager::exportToEncryptedFile(const QString &filePath, const QString &walletName, const QVariantList &items, const QString &passphrase)
+{
+    if (passphrase.isEmpty()) {
+        Q_EMIT errorOccurred(QStringLiteral("A passphrase is needed to encrypt the file."));
+        return;
+    }
+
+    startExport(
+        filePath,
+        walletName,
+        items,
+        [](QIODevice *device) {
+            return std::make_unique<BinaryBackupWriter>(device, true);
+        },
+        passphrase.toUtf8());
+}
+
+void ImportExportManager::startExport(const QString &filePath,
+                                      const QString &walletName,
+                                      const QVariantList &items,
+                                      const WriterFactory &writerFactory,
+                                      const QByteArray &passphrase)
+{
+    startJob([this, filePath, walletName, items, writerFactory, passphrase]() mutable {
+        bool done = false;
+        const WalletSource nextWallet = [&done, &walletName, &items](QString *name, QVariantList *wallet) {
+            if (done) {
+                return false;
+            }
+            done = true;
+            *name = walletName;
+            // runExport() releases the list once it's written
+            *wallet = std::move(items);
+            return true;
+        };
+        runExport(filePath, 1, nextWallet, writerFactory, passphrase);
+    });
+}
 
-    for (const QVariant &item : items) {
-        QVariantMap map = item.toMap();
-        QString label = map.value(QStringLiteral("label")).toString();
-        QByteArray secret = map.value(QStringLiteral("secret")).toByteArray();
-        QString contentType = map.value(QStringLiteral("contentType")).toString();
-        QVariantMap attributes = map.value(QStringLiteral("attributes")).toMap();
+void ImportExportManager::backupAllCollections(const QString &filePath, const QString &passphrase)
+{
+    auto *collectionsBackup = new CollectionsBackup(m_secretServiceClient, this);
+    const int collectionCount = collectionsBackup->collectionCount();
+    if (collectionCount == 0) {
+        delete collectionsBackup;
+        Q_EMIT errorOccurred(QStringLiteral("There are no unlocked wallets to back up."));
+        return;
+    }
 
-        QDomElement itemEl = doc.createElement(QStringLiteral("item"));
-        itemEl.setAttribute(QStringLiteral("label"), label);
-        itemEl.setAttribute(QStringLiteral("contentType"), contentType);
-        root.appendChild(itemEl);
+    const QByteArray passphraseData = passphrase.toUtf8();
+    const bool started = startJob([this, filePath, collectionCount, passphraseData]() {
+        runExport(
+            filePath,
+            collectionCount,
+            [this](QString *walletName, QVariantList *items) {
+                return nextBackupSection(walletName, items);
+            },
+            [](QIODevice *device) {
+                return std::make_unique<BinaryBackupWriter>(device, true);
+            },
+            passphraseData);
+    });
+    if (!started) {
+        delete collectionsBackup;
+        return;
+    }
 
-        // Secret as base64
-        QDomElement secretEl = doc.createElement(QStringLiteral("secret"));
-        secretEl.appendChild(doc.createTextNode(
-            QString::fromLatin1(secret.toBase64())));
-        itemEl.appendChild(secretEl);
+    m_backupSections.clear();
+    m_backupSectionsComplete = false;
+    m_collectionsBackup = collectionsBackup;
 
-        // All attributes
-        QDomElement attrsEl = doc.createElement(QStringLiteral("attributes"));
-        for (auto a = attributes.begin(); a != attributes.end(); ++a) {
-            QDomElement attr = doc.createElement(QStringLiteral("attribute"));
-            attr.setAttribute(QStringLiteral("name"), a.key());
-            attr.appendChild(doc.createTextNode(a.value().toString()));
-            attrsEl.appendChild(attr);
+    // The collections are read here, in the thread of libsecret, and written by the worker
+    connect(collectionsBackup, &CollectionsBackup::collectionRead, this, [this](const QString &walletName, const QVariantList &items) {
+        QMutexLocker locker(&m_backlogMutex);
+        m_backupSections.append({walletName, items});
+        m_backlogCondition.wakeAll();
+    });
+    connect(collectionsBackup, &CollectionsBackup::collectionFailed, this, [this](const QString &walletName, const QString &message) {
+        Q_EMIT errorOccurred(QStringLiteral("Cannot read the wallet %1: %2").arg(walletName, message));
+        // Better no backup than one silently missing a wallet
+        cancel();
+    });
+    connect(collectionsBackup, &CollectionsBackup::finished, this, [this, collectionsBackup]() {
+        if (m_collectionsBackup == collectionsBackup) {
+            m_collectionsBackup->deleteLater();
+            m_collectionsBackup = nullptr;
         }
-        itemEl.appendChild(attrsEl);
+        QMutexLocker locker(&m_backlogMutex);
+        m_backupSectionsComplete = true;
+        m_backlogCondition.wakeAll();
+    });
+
+    collectionsBackup->start();
+}
+
+bool ImportExportManager::nextBackupSection(QString *walletName, QVariantList *items)
+{
+    QMutexLocker locker(&m_backlogMutex);
+    while (m_backupSections.isEmpty() && !m_backupSectionsComplete && !m_cancelRequested) {
+        m_backlogCondition.wait(&m_backlogMutex);
+    }
+    if (m_cancelRequested || m_backupSections.isEmpty()) {
+        return false;
     }
 
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        Q_EMIT errorOccurred(QStringLiteral("Cannot open file for writing: ") + filePath);
+    BackupSection section = m_backupSections.takeFirst();
+    *walletName = section.walletName;
+    *items = std::move(section.items);
+    return true;
+}
+
+void ImportExportManager::runExport(const QString &filePath,
+                                    int walletCount,
+                                    const WalletSource &nextWallet,
+                                    const WriterFactory &writerFactory,
+                                    const QByteArray &passphrase)
+{
+    Tracing::Scope scope("ImportExportManager::runExport", "io");
+
+    // Written to a temporary file which replaces the destination only when complete
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        postError(QStringLiteral("Cannot open file for writing: ") + filePath);
         return;
     }
-    file.write(doc.toByteArray(2));
-    file.close();
-    Q_EMIT exportSucceeded(filePath);
+
+    QIODevice *device = &file;
+    std::unique_ptr<EncryptedDevice> encryptedDevice;
+    if (!passphrase.isEmpty()) {
+        encryptedDevice = std::make_unique<EncryptedDevice>(&file, passphrase);
+        if (!encryptedDevice->open(QIODevice::WriteOnly)) {
+            file.cancelWriting();
+            postError(encryptedDevice->errorString());
+            return;
+        }
+        device = encryptedDevice.get();
+    }
+
+    std::unique_ptr<ItemWriter> writer = writerFactory(device);
+
+    QString walletName;
+    QVariantList items;
+    int walletsWritten = 0;
+    int written = 0;
+    while (!m_cancelRequested && !writer->hasError() && nextWallet(&walletName, &items)) {
+        writer->beginWallet(walletName);
+        int walletItemsWritten = 0;
+        for (const QVariant &item : std::as_const(items)) {
+            if (m_cancelRequested || writer->hasError()) {
+                break;
+            }
+            writer->writeItem(item.toMap());
+            ++walletItemsWritten;
+            ++written;
+            if (written % s_progressInterval == 0) {
+                postProgress((walletsWritten + qreal(walletItemsWritten) / items.count()) / walletCount, written);
+            }
+        }
+        writer->endWallet();
+        ++walletsWritten;
+        // Don't keep the secrets of the wallets already written around
+        items.clear();
+    }
+    writer->finish();
+
+    bool encryptionFailed = false;
+    if (encryptedDevice) {
+        // Writes the last chunk
+        encryptedDevice->close();
+        encryptionFailed = encryptedDevice->hasError();
+    }
+
+    if (m_cancelRequested) {
+        file.cancelWriting();
+        QMetaObject::invokeMethod(this, &ImportExportManager::exportCancelled, Qt::QueuedConnection);
+        return;
+    }
+
+    if (encryptionFailed) {
+        file.cancelWriting();
+        postError(encryptedDevice->errorString());
+        return;
+    }
+
+    if (writer->hasError() || !file.commit()) {
+        postError(QStringLiteral("Cannot write file: ") + filePath);
+        return;
+    }
+
+    postProgress(1, written);
+    QMetaObject::invokeMethod(
+        this,
+        [this, filePath]() {
+            Q_EMIT exportSucceeded(filePath);
+        },
+        Qt::QueuedConnection);
 }
 
-void ImportExportManager::importFromFile(const QString &filePath)
+void ImportExportManager::importFromFile(const QString &filePath, const QString &passphrase)
 {
     QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         Q_EMIT errorOccurred(QStringLiteral("Cannot open file for reading: ") + filePath);
         return;
     }
 
-    QDomDocument doc;
-    auto result = doc.setContent(&file);
-    file.close();
-    if (!result) {
-        Q_EMIT errorOccurred(QStringLiteral("XML parse error: ") + result.errorMessage);
+    if (EncryptedDevice::isEncrypted(&file)) {
+        if (passphrase.isEmpty()) {
+            Q_EMIT passphraseRequired(filePath);
+            return;
+        }
+        // Encrypted files always contain a binary backup
+        startImport(
+            filePath,
+            [](QIODevice *device) {
+                return std::make_unique<BinaryBackupReader>(device);
+            },
+            passphrase.toUtf8());
         return;
     }
 
-    QDomElement root = doc.documentElement();
-    if (root.tagName().toLower() != QStringLiteral("wallet")) {
-        Q_EMIT errorOccurred(QStringLiteral("Not a valid KeepSecret XML file."));
+    startImport(filePath, [](QIODevice *device) -> std::unique_ptr<ItemReader> {
+        if (BinaryBackup::isBinaryBackup(device)) {
+            return std::make_unique<BinaryBackupReader>(device);
+        }
+        if (BackupJournal::isJournal(device)) {
+            return std::make_unique<BackupJournalReader>(device);
+        }
+        return std::make_unique<WalletXmlReader>(device, WalletXmlReader::KeepSecret);
+    });
+}
+
+void ImportExportManager::importFromKWalletXml(const QString &filePath)
+{
+    startImport(filePath, [](QIODevice *device) {
+        return std::make_unique<WalletXmlReader>(device, WalletXmlReader::KWallet);
+    });
+}
+
+static KConfigGroup incrementalBackupGroup(const QString &collectionPath)
+{
+    return KConfigGroup(KSharedConfig::openStateConfig(), QStringLiteral("IncrementalBackup")).group(collectionPath);
+}
+
+qint64 ImportExportManager::lastBackupPoint(const QString &collectionPath, const QString &journalPath) const
+{
+    const KConfigGroup group = incrementalBackupGroup(collectionPath);
+    if (group.readEntry(QStringLiteral("Journal"), QString()) != journalPath || !QFile::exists(journalPath)) {
+        return 0;
+    }
+    return group.readEntry(QStringLiteral("LastBackupPoint"), qint64(0));
+}
+
+QString ImportExportManager::lastJournalPath(const QString &collectionPath) const
+{
+    return incrementalBackupGroup(collectionPath).readEntry(QStringLiteral("Journal"), QString());
+}
+
+void ImportExportManager::backupIncrementally(const QString &journalPath,
+                                              const QString &collectionPath,
+                                              const QString &walletName,
+                                              const QVariantList &changedItems,
+                                              const QStringList &currentPaths,
+                                              qint64 modifiedSince,
+                                              qint64 backupPoint)
+{
+    const IncrementalBackup backup{journalPath, collectionPath, walletName, changedItems, currentPaths, modifiedSince, backupPoint};
+    startJob([this, backup]() {
+        runIncrementalBackup(backup);
+    });
+}
+
+void ImportExportManager::runIncrementalBackup(const IncrementalBackup &backup)
+{
+    QFile file(backup.journalPath);
+    if (!file.open(QIODevice::ReadWrite)) {
+        postError(QStringLiteral("Cannot open file for writing: ") + backup.journalPath);
         return;
     }
 
-    QVariantList items;
-    QDomNodeList itemNodes = root.elementsByTagName(QStringLiteral("item"));
-
-    for (int i = 0; i < itemNodes.count(); ++i) {
-        QDomElement e = itemNodes.at(i).toElement();
-        QVariantMap item;
-        item[QStringLiteral("label")]       = e.attribute(QStringLiteral("label"));
-        item[QStringLiteral("contentType")] = e.attribute(QStringLiteral("contentType"));
-
-        // Secret from base64
-        QString secretB64 = e.firstChildElement(QStringLiteral("secret")).text();
-        item[QStringLiteral("secret")] = QByteArray::fromBase64(secretB64.toLatin1());
-
-        // All attributes
-        QVariantMap attrs;
-        QDomElement attrsEl = e.firstChildElement(QStringLiteral("attributes"));
-        QDomNode attrChild = attrsEl.firstChild();
-        while (!attrChild.isNull()) {
-            QDomElement attr = attrChild.toElement();
-            if (attr.tagName().toLower() == QStringLiteral("attribute")) {
-                attrs[attr.attribute(QStringLiteral("name"))] = attr.text();
+    qint64 committedSize = 0;
+    QStringList deletedPaths;
+    if (file.size() > 0) {
+        BackupJournalReader reader(&file);
+        if (reader.hasError()) {
+            postError(reader.errorString());
+            return;
+        }
+        // Its live items would all look deleted from this wallet
+        if (reader.lastBackupPoint() != 0 && reader.walletName() != backup.walletName) {
+            postError(QStringLiteral("The journal belongs to another wallet: ") + backup.journalPath);
+            return;
+        }
+        // Only the items modified since the journal's last backup point were given:
+        // with any other point some changes would be missing
+        if (backup.modifiedSince != 0 && quint64(backup.modifiedSince) != reader.lastBackupPoint()) {
+            postError(QStringLiteral("The journal does not match the last backup of this wallet: ") + backup.journalPath);
+            return;
+        }
+        committedSize = reader.committedSize();
+
+        const QSet<QString> currentPaths(backup.currentPaths.constBegin(), backup.currentPaths.constEnd());
+        const QStringList livePaths = reader.livePaths();
+        for (const QString &dbusPath : livePaths) {
+            if (!currentPaths.contains(dbusPath)) {
+                deletedPaths << dbusPath;
             }
-            attrChild = attrChild.nextSibling();
         }
-        item[QStringLiteral("attributes")] = attrs;
-        items.append(item);
     }
 
-    Q_EMIT importSucceeded(items);
+    // Drop what an interrupted backup may have left after the last commit
+    if (!file.resize(committedSize) || !file.seek(committedSize)) {
+        postError(QStringLiteral("Cannot write file: ") + backup.journalPath);
+        return;
+    }
+
+    BackupJournalWriter writer(&file);
+    writer.beginSession(backup.backupPoint, backup.walletName);
+
+    const qsizetype total = qMax<qsizetype>(1, backup.changedItems.count() + deletedPaths.count());
+    int written = 0;
+    for (const QVariant &item : backup.changedItems) {
+        if (m_cancelRequested || writer.hasError()) {
+            break;
+        }
+        writer.writeItem(item.toMap());
+        ++written;
+        if (written % s_progressInterval == 0) {
+            postProgress(qreal(written) / total, written);
+        }
+    }
+    for (const QString &dbusPath : std::as_const(deletedPaths)) {
+        writer.writeTombstone(dbusPath);
+    }
+
+    if (m_cancelRequested) {
+        file.resize(committedSize);
+        QMetaObject::invokeMethod(this, &ImportExportManager::exportCancelled, Qt::QueuedConnection);
+        return;
+    }
+
+    writer.commit(backup.backupPoint);
+    if (writer.hasError() || !file.flush()) {
+        file.resize(committedSize);
+        postError(QStringLiteral("Cannot write file: ") + backup.journalPath);
+        return;
+    }
+    file.close();
+
+    postProgress(1, written);
+    const int deleted = deletedPaths.count();
+    QMetaObject::invokeMethod(
+        this,
+        [this, backup, written, deleted]() {
+            KConfigGroup group = incrementalBackupGroup(backup.collectionPath);
+            group.writeEntry(QStringLiteral("Journal"), backup.journalPath);
+            group.writeEntry(QStringLiteral("LastBackupPoint"), backup.backupPoint);
+            group.sync();
+            Q_EMIT incrementalBackupSucceeded(backup.journalPath, written, deleted);
+        },
+        Qt::QueuedConnection);
 }
 
-void ImportExportManager::importFromKWalletXml(const QString &filePath)
+void ImportExportManager::compactJournal(const QString &journalPath)
+{
+    startJob([this, journalPath]() {
+        runCompactJournal(journalPath);
+    });
+}
+
+void ImportExportManager::runCompactJournal(const QString &journalPath)
+{
+    QFile file(journalPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        postError(QStringLiteral("Cannot open file for reading: ") + journalPath);
+        return;
+    }
+
+    BackupJournalReader reader(&file);
+    if (reader.hasError()) {
+        postError(reader.errorString());
+        return;
+    }
+
+    QSaveFile compacted(journalPath);
+    if (!compacted.open(QIODevice::WriteOnly)) {
+        postError(QStringLiteral("Cannot open file for writing: ") + journalPath);
+        return;
+    }
+
+    // Records are copied as they are, without decoding them
+    BackupJournalWriter writer(&compacted);
+    writer.beginSession(reader.lastBackupPoint(), reader.walletName());
+
+    const QStringList livePaths = reader.livePaths();
+    int written = 0;
+    for (const QString &dbusPath : livePaths) {
+        if (m_cancelRequested || writer.hasError() || reader.hasError()) {
+            break;
+        }
+        QByteArray record = reader.rawItemRecord(dbusPath);
+        writer.writeRawItem(record);
+        record.fill(0);
+        ++written;
+        if (written % s_progressInterval == 0) {
+            postProgress(qreal(written) / livePaths.count(), written);
+        }
+    }
+    writer.commit(reader.lastBackupPoint());
+
+    if (m_cancelRequested) {
+        compacted.cancelWriting();
+        QMetaObject::invokeMethod(this, &ImportExportManager::exportCancelled, Qt::QueuedConnection);
+        return;
+    }
+
+    if (reader.hasError()) {
+        compacted.cancelWriting();
+        postError(reader.errorString());
+        return;
+    }
+
+    if (writer.hasError() || !compacted.commit()) {
+        postError(QStringLiteral("Cannot write file: ") + journalPath);
+        return;
+    }
+
+    postProgress(1, written);
+    QMetaObject::invokeMethod(
+        this,
+        [this, journalPath, written]() {
+            Q_EMIT journalCompacted(journalPath, written);
+        },
+        Qt::QueuedConnection);
+}
+
+QVariantList ImportExportManager::backupEntries(const QString &filePath)
 {
+    QVariantList entries;
+
     QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (!file.open(QIODevice::ReadOnly)) {
         Q_EMIT errorOccurred(QStringLiteral("Cannot open file for reading: ") + filePath);
-        return;
+        return entries;
     }
 
-    QDomDocument doc;
-    auto result = doc.setContent(&file);
-    file.close();
-    if (!result) {
-        Q_EMIT errorOccurred(QStringLiteral("XML parse error: ") + result.errorMessage);
+    BinaryBackupReader reader(&file);
+    if (!reader.hasIndex()) {
+        Q_EMIT errorOccurred(reader.hasError() ? reader.errorString() : QStringLiteral("Cannot read the backup index: ") + filePath);
+        return entries;
+    }
+
+    entries.reserve(reader.count());
+    for (int i = 0; i < reader.count(); ++i) {
+        entries.append(QVariantMap{{QStringLiteral("label"), reader.labelAt(i)}, {QStringLiteral("wallet"), reader.walletAt(i)}});
+    }
+    return entries;
+}
+
+QVariantMap ImportExportManager::backupEntry(const QString &filePath, int index)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        Q_EMIT errorOccurred(QStringLiteral("Cannot open file for reading: ") + filePath);
+        return QVariantMap();
+    }
+
+    BinaryBackupReader reader(&file);
+    const QVariantMap item = reader.itemAt(index);
+    if (reader.hasError()) {
+        Q_EMIT errorOccurred(reader.errorString());
+    }
+    return item;
+}
+
+void ImportExportManager::importFromKWalletFile(const QString &filePath, const QString &password)
+{
+    // Newer wallets keep the salt of their key next to them
+    QString saltFilePath = filePath;
+    if (saltFilePath.endsWith(QStringLiteral(".kwl"))) {
+        saltFilePath.chop(4);
+    }
+    saltFilePath += QStringLiteral(".salt");
+
+    const QByteArray passwordData = password.toUtf8();
+    startImport(filePath, [passwordData, saltFilePath](QIODevice *device) {
+        return std::make_unique<KWalletFileReader>(device, passwordData, saltFilePath);
+    });
+}
+
+void ImportExportManager::importFromCsv(const QString &filePath, const QVariantMap &mapping)
+{
+    const CsvColumnMapping columns = CsvColumnMapping::fromVariantMap(mapping);
+    startImport(filePath, [columns](QIODevice *device) {
+        return std::make_unique<CsvReader>(device, columns);
+    });
+}
+
+void ImportExportManager::exportToCsv(const QString &filePath, const QString &walletName, const QVariantList &items, const QVariantMap &mapping)
+{
+    CsvColumnMapping columns = CsvColumnMapping::fromVariantMap(mapping);
+    if (columns.isEmpty()) {
+        columns = CsvColumnMapping::chrome();
+    }
+    startExport(filePath, walletName, items, [columns](QIODevice *device) {
+        return std::make_unique<CsvWriter>(device, columns);
+    });
+}
+
+void ImportExportManager::startImport(const QString &filePath, const ReaderFactory &readerFactory, const QByteArray &passphrase)
+{
+    startJob([this, filePath, readerFactory, passphrase]() {
+        runImport(filePath, readerFactory, passphrase);
+    });
+}
+
+bool ImportExportManager::waitForBacklog()
+{
+    // Don't get too far ahead of the writes, so that memory stays bounded
+    QMutexLocker locker(&m_backlogMutex);
+    while (!m_cancelRequested && m_importBacklog + m_chunksInFlight * s_importChunkSize >= s_importChunkSize * 2) {
+        m_backlogCondition.wait(&m_backlogMutex);
+    }
+    return !m_cancelRequested;
+}
+
+void ImportExportManager::runImport(const QString &filePath, const ReaderFactory &readerFactory, const QByteArray &passphrase)
+{
+    Tracing::Scope scope("ImportExportManager::runImport", "io");
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        postError(QStringLiteral("Cannot open file for reading: ") + filePath);
         return;
     }
 
-    QDomElement root = doc.documentElement();
-    if (root.tagName().toLower() != QStringLiteral("wallet")) {
-        Q_EMIT errorOccurred(QStringLiteral("Not a valid KWallet XML file."));
+    QIODevice *device = &file;
+    std::unique_ptr<EncryptedDevice> encryptedDevice;
+    if (!passphrase.isEmpty()) {
+        encryptedDevice = std::make_unique<EncryptedDevice>(&file, passphrase);
+        if (!encryptedDevice->open(QIODevice::ReadOnly)) {
+            postError(encryptedDevice->errorString());
+            return;
+        }
+        device = encryptedDevice.get();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+
+    std::unique_ptr<ItemReader> reader = readerFactory(device);
+    const qint64 fileSize = qMax<qint64>(1, file.size());
+    int imported = 0;
+
+    const auto readerError = [&reader, &encryptedDevice]() {
+        // A wrong passphrase or a tampered file show up as a broken format
+        return encryptedDevice && encryptedDevice->hasError() ? encryptedDevice->errorString() : reader->errorString();
+    };
+    // Some readers already fail on the header
+    if (reader->hasError()) {
+        postError(readerError());
         return;
     }
 
-    QVariantList items;
-    QDomNodeList folders = root.elementsByTagName(QStringLiteral("folder"));
-
-    for (int i = 0; i < folders.count(); ++i) {
-        QDomElement folder = folders.at(i).toElement();
-        QString folderName = folder.attribute(QStringLiteral("name"));
-
-        QDomNode child = folder.firstChild();
-        while (!child.isNull()) {
-            QDomElement e = child.toElement();
-            QString tag = e.tagName().toLower();
-            QString ename = e.attribute(QStringLiteral("name"));
-
-            if (tag == QStringLiteral("password")) {
-                QVariantMap item;
-                item[QStringLiteral("label")]       = ename;
-                item[QStringLiteral("secret")]      = e.text().toUtf8();
-                item[QStringLiteral("contentType")] = QStringLiteral("text/plain");
-                QVariantMap attrs;
-                attrs[QStringLiteral("server")] = folderName;
-                item[QStringLiteral("attributes")] = attrs;
-                items.append(item);
-
-            } else if (tag == QStringLiteral("stream")) {
-                QVariantMap item;
-                item[QStringLiteral("label")]       = ename;
-                item[QStringLiteral("secret")]      = QByteArray::fromBase64(e.text().toLatin1());
-                item[QStringLiteral("contentType")] = QStringLiteral("application/octet-stream");
-                QVariantMap attrs;
-                attrs[QStringLiteral("server")] = folderName;
-                item[QStringLiteral("attributes")] = attrs;
-                items.append(item);
-
-            } else if (tag == QStringLiteral("map")) {
-                QVariantMap item;
-                item[QStringLiteral("label")]       = ename;
-                item[QStringLiteral("secret")]      = QByteArray();
-                item[QStringLiteral("contentType")] = QStringLiteral("text/plain");
-
-                QVariantMap attrs;
-                attrs[QStringLiteral("server")] = folderName;
-                QDomNode mapChild = e.firstChild();
-                while (!mapChild.isNull()) {
-                    QDomElement mapEntry = mapChild.toElement();
-                    if (mapEntry.tagName().toLower() == QStringLiteral("mapentry")) {
-                        attrs[mapEntry.attribute(QStringLiteral("name"))] = mapEntry.text();
-                    }
-                    mapChild = mapChild.nextSibling();
-                }
-                item[QStringLiteral("attributes")] = attrs;
-                items.append(item);
-            }
+    while (!reader->atEnd()) {
+        if (!waitForBacklog()) {
+            QMetaObject::invokeMethod(this, &ImportExportManager::importCancelled, Qt::QueuedConnection);
+            return;
+        }
+
+        const QVariantList items = reader->readItems(s_importChunkSize);
+        if (reader->hasError()) {
+            postError(readerError());
+            return;
+        }
+        if (items.isEmpty()) {
+            continue;
+        }
 
-            child = child.nextSibling();
+        imported += items.count();
+        {
+            QMutexLocker locker(&m_backlogMutex);
+            ++m_chunksInFlight;
         }
+        // Receivers start writing these while we go on parsing
+        QMetaObject::invokeMethod(
+            this,
+            [this, items]() {
+                {
+                    QMutexLocker locker(&m_backlogMutex);
+                    --m_chunksInFlight;
+                }
+                Q_EMIT itemsImported(items);
+            },
+            Qt::QueuedConnection);
+        postProgress(qreal(file.pos()) / fileSize, imported);
     }
 
-    Q_EMIT importSucceeded(items);
+    // Includes the time spent waiting for the writes
+    const qint64 elapsed = qMax<qint64>(1, timer.elapsed());
+    qCDebug(KEEPSECRET_LOG) << "Parsed" << imported << "items from" << filePath << "in" << elapsed << "ms,"
+                            << (file.size() / 1024.0 / 1024.0) / (elapsed / 1000.0) << "MB/s";
+
+    postProgress(1, imported);
+    QMetaObject::invokeMethod(
+        this,
+        [this, imported]() {
+            Q_EMIT importSucceeded(imported);
+        },
+        Qt::QueuedConnection);
 }
+
+#include "moc_importexportmanager.cpp"
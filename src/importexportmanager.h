@@ -2,23 +2,168 @@
 // SPDX-FileCopyrightText: 2026 Roshani Kumari <roshnikumariii098@gmail.com>
 
 #pragma once
+#include <QMutex>
 #include <QObject>
 #include <QString>
 #include <QVariantList>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <qqmlregistration.h>
 
+class QIODevice;
+class QThread;
+class CollectionsBackup;
+class ItemReader;
+class ItemWriter;
+class SecretServiceClient;
+
+/**
+ * Imports and exports run as jobs on a worker thread, one at a time.
+ * Signals are always emitted in the thread of the manager.
+ */
 class ImportExportManager : public QObject
 {
     Q_OBJECT
     QML_ELEMENT
     QML_UNCREATABLE("Cannot create elements of type ImportExportManager")
+
+    Q_PROPERTY(bool running READ isRunning NOTIFY runningChanged)
+    // From 0 to 1
+    Q_PROPERTY(qreal progress READ progress NOTIFY progressChanged)
+    Q_PROPERTY(int itemsProcessed READ itemsProcessed NOTIFY progressChanged)
+
 public:
-    explicit ImportExportManager(QObject *parent = nullptr);
+    explicit ImportExportManager(SecretServiceClient *secretServiceClient, QObject *parent = nullptr);
+    ~ImportExportManager() override;
+
+    // The export jobs write the given items as they are: with items from
+    // CollectionModel::exportItems() the secrets are the ones already loaded
+    // in the model, shared and not copied, only the list itself is extra
     Q_INVOKABLE void exportToFile(const QString &filePath, const QString &walletName, const QVariantList &items);
-    Q_INVOKABLE void importFromFile(const QString &filePath);
+    // Compact format with an index, see BinaryBackupWriter
+    Q_INVOKABLE void exportToBinaryFile(const QString &filePath, const QString &walletName, const QVariantList &items, bool compress = true);
+    // Compact format, encrypted with a key derived from the passphrase (see EncryptedDevice)
+    Q_INVOKABLE void exportToEncryptedFile(const QString &filePath, const QString &walletName, const QVariantList &items, const QString &passphrase);
+    // Backs up all the unlocked collections to a single binary backup, a section for each
+    // (see CollectionsBackup). With a passphrase the file is encrypted
+    Q_INVOKABLE void backupAllCollections(const QString &filePath, const QString &passphrase = QString());
+    // Imports are parsed incrementally: items are emitted in chunks with itemsImported().
+    // The XML, binary and encrypted formats are accepted: if the file is encrypted
+    // and no passphrase is given, passphraseRequired() is emitted instead
+    Q_INVOKABLE void importFromFile(const QString &filePath, const QString &passphrase = QString());
     Q_INVOKABLE void importFromKWalletXml(const QString &filePath);
+    // Reads a .kwl wallet directly, see KWalletFileReader. GPG wallets
+    // don't need the password, gpg-agent asks for it
+    Q_INVOKABLE void importFromKWalletFile(const QString &filePath, const QString &password);
+    // The mapping is in the format of CsvColumnMapping::fromVariantMap(),
+    // when empty it's detected from the header
+    Q_INVOKABLE void importFromCsv(const QString &filePath, const QVariantMap &mapping = QVariantMap());
+    Q_INVOKABLE void exportToCsv(const QString &filePath, const QString &walletName, const QVariantList &items, const QVariantMap &mapping = QVariantMap());
+
+    // Appends the items changed since the last backup of the collection to the journal
+    // (see BackupJournalWriter), plus tombstones for the items not in currentPaths anymore.
+    // changedItems, currentPaths and backupPoint come from CollectionModel::loadChangedItems(modifiedSince),
+    // where modifiedSince is lastBackupPoint(). Fails if the journal is of another wallet
+    Q_INVOKABLE void backupIncrementally(const QString &journalPath,
+                                         const QString &collectionPath,
+                                         const QString &walletName,
+                                         const QVariantList &changedItems,
+                                         const QStringList &currentPaths,
+                                         qint64 modifiedSince,
+                                         qint64 backupPoint);
+    // Zero if the collection was never backed up to this journal
+    Q_INVOKABLE qint64 lastBackupPoint(const QString &collectionPath, const QString &journalPath) const;
+    Q_INVOKABLE QString lastJournalPath(const QString &collectionPath) const;
+    // Rewrites the journal keeping only the latest version of the live items
+    Q_INVOKABLE void compactJournal(const QString &journalPath);
+
+    // Random access to binary backups, only the requested item gets decoded.
+    // backupEntries() returns maps with the keys label and wallet
+    Q_INVOKABLE QVariantList backupEntries(const QString &filePath);
+    Q_INVOKABLE QVariantMap backupEntry(const QString &filePath, int index);
+
+    // Stops the running job: an export leaves the destination file untouched,
+    // an import stops emitting items
+    Q_INVOKABLE void cancel();
+
+    bool isRunning() const;
+    qreal progress() const;
+    int itemsProcessed() const;
+
+    // How many of the emitted items are still waiting to be written:
+    // parsing pauses while this is too high
+    void setImportBacklog(int pendingItems);
+
 Q_SIGNALS:
     void exportSucceeded(const QString &filePath);
-    void importSucceeded(const QVariantList &items);
+    void itemsImported(const QVariantList &items);
+    void importSucceeded(int count);
+    void exportCancelled();
+    void importCancelled();
     void errorOccurred(const QString &message);
+    void passphraseRequired(const QString &filePath);
+    void incrementalBackupSucceeded(const QString &journalPath, int written, int deleted);
+    void journalCompacted(const QString &journalPath, int items);
+    void runningChanged();
+    void progressChanged();
+
+private:
+    using ReaderFactory = std::function<std::unique_ptr<ItemReader>(QIODevice *device)>;
+    using WriterFactory = std::function<std::unique_ptr<ItemWriter>(QIODevice *device)>;
+    // Called from the worker thread for every wallet to export, returns false after the last one
+    using WalletSource = std::function<bool(QString *walletName, QVariantList *items)>;
+
+    struct IncrementalBackup {
+        QString journalPath;
+        QString collectionPath;
+        QString walletName;
+        QVariantList changedItems;
+        QStringList currentPaths;
+        qint64 modifiedSince = 0;
+        qint64 backupPoint = 0;
+    };
+
+    bool startJob(std::function<void()> job);
+    void finishJob();
+
+    // A non empty passphrase encrypts or decrypts the file with an EncryptedDevice
+    void startImport(const QString &filePath, const ReaderFactory &readerFactory, const QByteArray &passphrase = QByteArray());
+    void startExport(const QString &filePath,
+                     const QString &walletName,
+                     const QVariantList &items,
+                     const WriterFactory &writerFactory,
+                     const QByteArray &passphrase = QByteArray());
+
+    // These are called from the worker thread
+    void runImport(const QString &filePath, const ReaderFactory &readerFactory, const QByteArray &passphrase);
+    void runExport(const QString &filePath, int walletCount, const WalletSource &nextWallet, const WriterFactory &writerFactory, const QByteArray &passphrase);
+    bool nextBackupSection(QString *walletName, QVariantList *items);
+    void runIncrementalBackup(const IncrementalBackup &backup);
+    void runCompactJournal(const QString &journalPath);
+    bool waitForBacklog();
+    void postProgress(qreal progress, int itemsProcessed);
+    void postError(const QString &message);
+
+    SecretServiceClient *const m_secretServiceClient;
+    QThread *m_thread = nullptr;
+    std::atomic_bool m_cancelRequested = false;
+
+    QMutex m_backlogMutex;
+    QWaitCondition m_backlogCondition;
+    int m_importBacklog = 0;
+    int m_chunksInFlight = 0;
+
+    // The collections read by m_collectionsBackup, waiting to be written
+    struct BackupSection {
+        QString walletName;
+        QVariantList items;
+    };
+    CollectionsBackup *m_collectionsBackup = nullptr;
+    QList<BackupSection> m_backupSections;
+    bool m_backupSectionsComplete = false;
+
+    qreal m_progress = 0;
+    int m_itemsProcessed = 0;
 };
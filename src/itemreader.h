@@ -0,0 +1,28 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include <QString>
+#include <QVariantList>
+
+/**
+ * Base for the importers of the various file formats.
+ * Items are returned as maps in the format of CollectionModel::exportItems()
+ */
+class ItemReader
+{
+public:
+    virtual ~ItemReader() = default;
+
+    // Returns up to maxItems items, an empty list once at the end or on error
+    virtual QVariantList readItems(int maxItems) = 0;
+
+    virtual bool atEnd() const = 0;
+    virtual QString errorString() const = 0;
+
+    bool hasError() const
+    {
+        return !errorString().isEmpty();
+    }
+};
@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include <QString>
+#include <QVariantMap>
+
+/**
+ * Base for the exporters of the various file formats.
+ * Items are maps in the format of CollectionModel::exportItems()
+ */
+class ItemWriter
+{
+public:
+    virtual ~ItemWriter() = default;
+
+    virtual void beginWallet(const QString &walletName) = 0;
+    virtual void writeItem(const QVariantMap &item) = 0;
+    virtual void endWallet() = 0;
+    // Called once after the last wallet, to write any trailing data
+    virtual void finish() = 0;
+
+    virtual bool hasError() const = 0;
+};
@@ -0,0 +1,374 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "kwalletfilereader.h"
+#include "encrypteddevice.h"
+#include "keepsecret_debug.h"
+#include "secretserviceclient.h"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QtEndian>
+
+#include <gcrypt.h>
+
+static constexpr char s_magic[] = "KWALLET\n\r\0\r\n";
+static constexpr qint64 s_magicSize = 12;
+static constexpr qint64 s_digestSize = 16;
+static constexpr qint64 s_blockSize = 8;
+static constexpr qint64 s_sha1Size = 20;
+static constexpr int s_sha1Iterations = 2000;
+static constexpr int s_pbkdf2Iterations = 50000;
+static constexpr qsizetype s_pbkdf2KeySize = 56;
+
+// The version bytes, as in kwalletbackend
+enum Cipher : quint8 {
+    BlowfishEcb = 0,
+    TripleDesCbc = 1,
+    Gpg = 2,
+    BlowfishCbc = 3,
+};
+enum Hash : quint8 {
+    Sha1 = 0,
+    Md5 = 1,
+    Pbkdf2Sha512 = 2,
+};
+enum EntryType : qint32 {
+    UnknownEntry = 0,
+    PasswordEntry,
+    StreamEntry,
+    MapEntry,
+};
+
+// KWallet's Blowfish reads blocks as host order words, while the standard
+// one reads them as big endian: this converts between the two on the
+// little endian machines the wallets were written on
+static void swapWords(QByteArray &data)
+{
+    for (qsizetype i = 0; i + 4 <= data.size(); i += 4) {
+        qToBigEndian<quint32>(qFromLittleEndian<quint32>(data.constData() + i), data.data() + i);
+    }
+}
+
+// SHA-1 applied 2000 times to up to 16 bytes of the password
+static QByteArray iteratedSha1(const QByteArray &password, qsizetype from, qsizetype length)
+{
+    QByteArray block = QCryptographicHash::hash(password.mid(from, length), QCryptographicHash::Sha1);
+    for (int i = 1; i < s_sha1Iterations; ++i) {
+        const QByteArray next = QCryptographicHash::hash(block, QCryptographicHash::Sha1);
+        block.fill(0);
+        block = next;
+    }
+    return block;
+}
+
+KWalletFileReader::KWalletFileReader(QIODevice *device, const QByteArray &password, const QString &saltFilePath)
+    : m_device(device)
+    , m_password(password)
+    , m_saltFilePath(saltFilePath)
+{
+    EncryptedDevice::initializeGcrypt();
+}
+
+KWalletFileReader::~KWalletFileReader()
+{
+    m_password.fill(0);
+    // The stream shares the data, release it first so that it's really wiped
+    m_stream.reset();
+    m_data.fill(0);
+}
+
+bool KWalletFileReader::isKWalletFile(QIODevice *device)
+{
+    return device->peek(s_magicSize) == QByteArray(s_magic, s_magicSize);
+}
+
+bool KWalletFileReader::atEnd() const
+{
+    return m_atEnd;
+}
+
+QString KWalletFileReader::errorString() const
+{
+    return m_error;
+}
+
+void KWalletFileReader::setError(const QString &message)
+{
+    m_error = message;
+    m_atEnd = true;
+}
+
+bool KWalletFileReader::decrypt()
+{
+    m_decrypted = true;
+
+    const QByteArray header = m_device->read(s_magicSize + 4);
+    if (header.size() != s_magicSize + 4 || !header.startsWith(QByteArray(s_magic, s_magicSize))) {
+        setError(QStringLiteral("Not a valid KWallet file."));
+        return false;
+    }
+
+    const quint8 major = header[s_magicSize];
+    const quint8 cipher = header[s_magicSize + 2];
+    const quint8 hash = header[s_magicSize + 3];
+    if (major != 0) {
+        setError(QStringLiteral("Unsupported KWallet file version."));
+        return false;
+    }
+
+    bool ok = false;
+    if (cipher == BlowfishEcb || cipher == BlowfishCbc) {
+        ok = decryptBlowfish(cipher, hash);
+    } else if (cipher == Gpg) {
+        ok = decryptGpg();
+    } else {
+        setError(QStringLiteral("Unsupported KWallet encryption."));
+    }
+    m_password.fill(0);
+
+    if (!ok) {
+        return false;
+    }
+
+    m_stream = std::make_unique<QDataStream>(m_data);
+    return true;
+}
+
+bool KWalletFileReader::deriveKey(quint8 hash, QByteArray *key)
+{
+    if (hash == Pbkdf2Sha512) {
+        QFile saltFile(m_saltFilePath);
+        if (!saltFile.open(QIODevice::ReadOnly)) {
+            setError(QStringLiteral("Cannot read the salt of the wallet: ") + m_saltFilePath);
+            return false;
+        }
+        const QByteArray salt = saltFile.readAll();
+
+        key->resize(s_pbkdf2KeySize);
+        const gcry_error_t error = gcry_kdf_derive(m_password.constData(),
+                                                   m_password.size(),
+                                                   GCRY_KDF_PBKDF2,
+                                                   GCRY_MD_SHA512,
+                                                   salt.constData(),
+                                                   salt.size(),
+                                                   s_pbkdf2Iterations,
+                                                   key->size(),
+                                                   key->data());
+        if (error) {
+            setError(QStringLiteral("Cannot derive the wallet key: ") + QString::fromUtf8(gcry_strerror(error)));
+            return false;
+        }
+        return true;
+    }
+
+    if (hash != Sha1) {
+        setError(QStringLiteral("Unsupported KWallet password hash."));
+        return false;
+    }
+
+    // The password is hashed in blocks of 16 bytes, up to four blocks,
+    // then the digests are joined into a key of at most 56 bytes
+    QList<QByteArray> blocks;
+    for (qsizetype from = 0; from == 0 || (from < m_password.size() && blocks.count() < 4); from += 16) {
+        const qsizetype length = blocks.count() == 3 ? m_password.size() - from : 16;
+        blocks << iteratedSha1(m_password, from, length);
+    }
+
+    key->clear();
+    const qsizetype take = blocks.count() == 4 ? 14 : s_sha1Size;
+    for (QByteArray &block : blocks) {
+        key->append(block.left(take));
+        block.fill(0);
+    }
+    key->truncate(s_pbkdf2KeySize);
+    return true;
+}
+
+bool KWalletFileReader::decryptBlowfish(quint8 cipher, quint8 hash)
+{
+    // Skip the digests of folder names and keys
+    QDataStream hashStream(m_device);
+    quint32 folders = 0;
+    hashStream >> folders;
+    for (quint32 i = 0; i < folders && hashStream.status() == QDataStream::Ok; ++i) {
+        hashStream.skipRawData(s_digestSize);
+        quint32 entries = 0;
+        hashStream >> entries;
+        hashStream.skipRawData(qint64(entries) * s_digestSize);
+    }
+    if (hashStream.status() != QDataStream::Ok) {
+        setError(QStringLiteral("The KWallet file is corrupted."));
+        return false;
+    }
+
+    QByteArray encrypted = m_device->readAll();
+    if (encrypted.size() < s_blockSize + 4 + s_sha1Size || encrypted.size() % s_blockSize != 0) {
+        setError(QStringLiteral("The KWallet file is corrupted."));
+        return false;
+    }
+
+    QByteArray key;
+    if (!deriveKey(hash, &key)) {
+        return false;
+    }
+
+    gcry_cipher_hd_t handle = nullptr;
+    gcry_error_t error = gcry_cipher_open(&handle, GCRY_CIPHER_BLOWFISH, GCRY_CIPHER_MODE_ECB, GCRY_CIPHER_SECURE);
+    if (!error) {
+        error = gcry_cipher_setkey(handle, key.constData(), key.size());
+    }
+    key.fill(0);
+
+    QByteArray decrypted = encrypted;
+    if (!error) {
+        swapWords(decrypted);
+        error = gcry_cipher_decrypt(handle, decrypted.data(), decrypted.size(), nullptr, 0);
+        swapWords(decrypted);
+    }
+    gcry_cipher_close(handle);
+
+    if (error) {
+        decrypted.fill(0);
+        setError(QStringLiteral("Cannot decrypt the wallet: ") + QString::fromUtf8(gcry_strerror(error)));
+        return false;
+    }
+
+    if (cipher == BlowfishCbc) {
+        // Chained with a zero initialization vector
+        for (qsizetype i = decrypted.size() - 1; i >= s_blockSize; --i) {
+            decrypted[i] = decrypted[i] ^ encrypted[i - s_blockSize];
+        }
+    }
+
+    // A random block, the size of the data, the data, then its SHA-1 at the very end
+    const quint32 size = qFromBigEndian<quint32>(decrypted.constData() + s_blockSize);
+    const QByteArray expected = decrypted.right(s_sha1Size);
+    if (size > quint32(decrypted.size() - s_blockSize - 4 - s_sha1Size)) {
+        decrypted.fill(0);
+        setError(QStringLiteral("Wrong password, or the KWallet file is corrupted."));
+        return false;
+    }
+
+    m_data = decrypted.mid(s_blockSize + 4, size);
+    decrypted.fill(0);
+
+    if (QCryptographicHash::hash(m_data, QCryptographicHash::Sha1) != expected) {
+        m_data.fill(0);
+        m_data.clear();
+        setError(QStringLiteral("Wrong password, or the KWallet file is corrupted."));
+        return false;
+    }
+    return true;
+}
+
+bool KWalletFileReader::decryptGpg()
+{
+    QProcess gpg;
+    gpg.start(QStringLiteral("gpg"), {QStringLiteral("--batch"), QStringLiteral("--quiet"), QStringLiteral("--decrypt")});
+    if (!gpg.waitForStarted()) {
+        setError(QStringLiteral("Cannot run gpg to decrypt the wallet."));
+        return false;
+    }
+
+    // The private key's passphrase is asked by gpg-agent
+    const QByteArray encrypted = m_device->readAll();
+    gpg.write(encrypted);
+    gpg.closeWriteChannel();
+
+    if (!gpg.waitForFinished(-1) || gpg.exitStatus() != QProcess::NormalExit || gpg.exitCode() != 0) {
+        qCWarning(KEEPSECRET_LOG) << "gpg failed:" << gpg.readAllStandardError();
+        setError(QStringLiteral("Cannot decrypt the wallet with gpg."));
+        return false;
+    }
+
+    QByteArray decrypted = gpg.readAllStandardOutput();
+    QDataStream stream(decrypted);
+    QString keyId;
+    QByteArray hashes;
+    stream >> keyId >> hashes >> m_data;
+    decrypted.fill(0);
+
+    if (stream.status() != QDataStream::Ok) {
+        m_data.fill(0);
+        m_data.clear();
+        setError(QStringLiteral("The KWallet file is corrupted."));
+        return false;
+    }
+    return true;
+}
+
+QVariantMap KWalletFileReader::readEntry(const QString &key, qint32 type, const QByteArray &value)
+{
+    QVariantMap item;
+    QVariantMap attributes;
+    attributes[QStringLiteral("server")] = m_currentFolder;
+    item[QStringLiteral("label")] = key;
+    item[QStringLiteral("folder")] = m_currentFolder;
+
+    QDataStream stream(value);
+    if (type == PasswordEntry) {
+        QString password;
+        stream >> password;
+        item[QStringLiteral("secret")] = password.toUtf8();
+        item[QStringLiteral("contentType")] = QStringLiteral("text/plain");
+        attributes[QStringLiteral("type")] = SecretServiceClient::typeToString(SecretServiceClient::PlainText);
+    } else if (type == MapEntry) {
+        QMap<QString, QString> map;
+        stream >> map;
+        QJsonObject object;
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+            object[it.key()] = it.value();
+        }
+        item[QStringLiteral("secret")] = QJsonDocument(object).toJson(QJsonDocument::Compact);
+        item[QStringLiteral("contentType")] = QStringLiteral("text/plain");
+        attributes[QStringLiteral("type")] = SecretServiceClient::typeToString(SecretServiceClient::Map);
+    } else {
+        item[QStringLiteral("secret")] = value;
+        item[QStringLiteral("contentType")] = QStringLiteral("application/octet-stream");
+        attributes[QStringLiteral("type")] = SecretServiceClient::typeToString(SecretServiceClient::Binary);
+    }
+
+    item[QStringLiteral("attributes")] = attributes;
+    return item;
+}
+
+QVariantList KWalletFileReader::readItems(int maxItems)
+{
+    QVariantList items;
+
+    if (m_atEnd || (!m_decrypted && !decrypt())) {
+        return items;
+    }
+
+    while (items.count() < maxItems) {
+        if (m_entriesLeft == 0) {
+            if (m_stream->atEnd()) {
+                m_atEnd = true;
+                break;
+            }
+            *m_stream >> m_currentFolder >> m_entriesLeft;
+        } else {
+            QString key;
+            qint32 type = UnknownEntry;
+            QByteArray value;
+            *m_stream >> key >> type >> value;
+            --m_entriesLeft;
+            if (m_stream->status() == QDataStream::Ok && type != UnknownEntry) {
+                items.append(readEntry(key, type, value));
+            }
+            value.fill(0);
+        }
+
+        if (m_stream->status() != QDataStream::Ok) {
+            setError(QStringLiteral("The KWallet file is corrupted."));
+            items.clear();
+            break;
+        }
+    }
+
+    return items;
+}
@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "itemreader.h"
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QString>
+#include <memory>
+
+class QIODevice;
+
+/**
+ * Reads the binary .kwl files of KWallet directly.
+ *
+ * header: "KWALLET\n\r\0\r\n", 4 version bytes: major, minor, cipher, hash
+ *
+ * Blowfish wallets continue with the digests of folders and keys, then the
+ * encrypted data: a random block, the size as quint32, the folders, and the
+ * SHA-1 of the folders. The key is derived from the password either with
+ * iterated SHA-1 or, for newer wallets, with PBKDF2-SHA512 and the salt
+ * stored next to the wallet in a .salt file.
+ *
+ * GPG wallets continue with an OpenPGP message, decrypted by gpg itself:
+ * the password is then asked by gpg-agent.
+ *
+ * The folders are serialized with QDataStream: for each, its name, the
+ * number of entries, and for each entry its key, type and value.
+ * The wallet has to be decrypted as a whole to verify it, after that the
+ * entries are decoded a chunk at a time.
+ */
+class KWalletFileReader : public ItemReader
+{
+public:
+    KWalletFileReader(QIODevice *device, const QByteArray &password, const QString &saltFilePath);
+    ~KWalletFileReader() override;
+
+    static bool isKWalletFile(QIODevice *device);
+
+    QVariantList readItems(int maxItems) override;
+    bool atEnd() const override;
+    QString errorString() const override;
+
+private:
+    bool decrypt();
+    bool decryptBlowfish(quint8 cipher, quint8 hash);
+    bool decryptGpg();
+    bool deriveKey(quint8 hash, QByteArray *key);
+    QVariantMap readEntry(const QString &key, qint32 type, const QByteArray &value);
+    void setError(const QString &message);
+
+    QIODevice *m_device;
+    QByteArray m_password;
+    QString m_saltFilePath;
+
+    // The decrypted folders
+    QByteArray m_data;
+    std::unique_ptr<QDataStream> m_stream;
+    QString m_currentFolder;
+    quint32 m_entriesLeft = 0;
+    bool m_decrypted = false;
+    QString m_error;
+    bool m_atEnd = false;
+};
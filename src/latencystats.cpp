@@ -0,0 +1,161 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "latencystats.h"
+#include "keepsecret_debug.h"
+#include "tracing.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <cmath>
+#include <memory>
+
+class LatencyStatsSingleton
+{
+public:
+    LatencyStatsSingleton();
+    std::unique_ptr<LatencyStats> latencyStats;
+};
+
+LatencyStatsSingleton::LatencyStatsSingleton()
+    : latencyStats(std::make_unique<LatencyStats>())
+{
+}
+
+Q_GLOBAL_STATIC(LatencyStatsSingleton, s_latencyStats)
+
+static qreal toMilliseconds(qint64 nsecs)
+{
+    return nsecs / 1000000.0;
+}
+
+void LatencyStats::Histogram::add(qint64 nsecs)
+{
+    nsecs = qMax<qint64>(1, nsecs);
+    const int bucket = std::floor(std::log2(qreal(nsecs)) * s_bucketsPerPowerOfTwo);
+    ++buckets[qBound(0, bucket, s_bucketCount - 1)];
+    ++count;
+    total += nsecs;
+    max = qMax(max, nsecs);
+}
+
+qint64 LatencyStats::Histogram::percentile(qreal fraction) const
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    const quint64 rank = qMax<quint64>(1, std::ceil(fraction * count));
+    quint64 seen = 0;
+    for (int i = 0; i < s_bucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            // The upper bound of the bucket, never more than what was really seen
+            const qint64 upperBound = std::exp2(qreal(i + 1) / s_bucketsPerPowerOfTwo);
+            return qMin(upperBound, max);
+        }
+    }
+    return max;
+}
+
+LatencyStats::LatencyStats(QObject *parent)
+    : QObject(parent)
+{
+}
+
+LatencyStats::~LatencyStats()
+{
+}
+
+LatencyStats *LatencyStats::instance()
+{
+    if (s_latencyStats.isDestroyed()) {
+        return nullptr;
+    }
+    return s_latencyStats->latencyStats.get();
+}
+
+void LatencyStats::record(const QString &operation, std::chrono::nanoseconds duration)
+{
+    m_histograms[operation].add(duration.count());
+}
+
+QVariantList LatencyStats::summary() const
+{
+    QStringList operations = m_histograms.keys();
+    operations.sort();
+
+    QVariantList result;
+    for (const QString &operation : std::as_const(operations)) {
+        const Histogram &histogram = m_histograms[operation];
+        QVariantMap entry;
+        entry[QStringLiteral("operation")] = operation;
+        entry[QStringLiteral("count")] = histogram.count;
+        entry[QStringLiteral("mean")] = toMilliseconds(histogram.total / qint64(histogram.count));
+        entry[QStringLiteral("p50")] = toMilliseconds(histogram.percentile(0.5));
+        entry[QStringLiteral("p95")] = toMilliseconds(histogram.percentile(0.95));
+        entry[QStringLiteral("p99")] = toMilliseconds(histogram.percentile(0.99));
+        entry[QStringLiteral("max")] = toMilliseconds(histogram.max);
+        result.append(entry);
+    }
+    return result;
+}
+
+void LatencyStats::reset()
+{
+    m_histograms.clear();
+}
+
+QJsonObject LatencyStats::toJson() const
+{
+    QJsonArray operations;
+    const QVariantList entries = summary();
+    for (const QVariant &entry : entries) {
+        operations.append(QJsonObject::fromVariantMap(entry.toMap()));
+    }
+
+    QJsonObject result;
+    result[QStringLiteral("unit")] = QStringLiteral("ms");
+    result[QStringLiteral("operations")] = operations;
+    return result;
+}
+
+bool LatencyStats::dumpJson(const QString &filePath) const
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KEEPSECRET_LOG) << "Cannot write the latency statistics to" << filePath;
+        return false;
+    }
+    file.write(QJsonDocument(toJson()).toJson());
+    return file.commit();
+}
+
+LatencyTimer::LatencyTimer(const char *operation)
+    : m_operation(operation)
+    , m_traceStart(Tracing::isEnabled() ? Tracing::now() : -1)
+{
+    m_timer.start();
+}
+
+LatencyTimer::~LatencyTimer()
+{
+    stop();
+}
+
+void LatencyTimer::stop()
+{
+    if (!m_timer.isValid()) {
+        return;
+    }
+    if (LatencyStats *stats = LatencyStats::instance()) {
+        stats->record(QString::fromLatin1(m_operation), std::chrono::nanoseconds(m_timer.nsecsElapsed()));
+    }
+    if (m_traceStart >= 0) {
+        Tracing::complete(m_operation, "libsecret", m_traceStart);
+    }
+    m_timer.invalidate();
+}
+
+#include "moc_latencystats.cpp"
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QObject>
+#include <QVariantList>
+#include <array>
+#include <chrono>
+#include <qqmlregistration.h>
+
+/**
+ * Latency histograms of the calls to the secret service, by operation name.
+ * Every operation of the StateTracker is recorded when it ends, with the
+ * name of its type; single libsecret calls are recorded with the name of
+ * the function.
+ * The buckets grow by a factor of 2^(1/4), so percentiles are accurate
+ * to about 20% with a fixed amount of memory per operation.
+ * Only to be used from the main thread.
+ */
+class LatencyStats : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Cannot create elements of type LatencyStats")
+
+public:
+    explicit LatencyStats(QObject *parent = nullptr);
+    ~LatencyStats() override;
+
+    // Null once the application is exiting
+    static LatencyStats *instance();
+
+    void record(const QString &operation, std::chrono::nanoseconds duration);
+
+    // A map for each operation with the keys operation, count, and
+    // mean, p50, p95, p99 and max in milliseconds, sorted by operation
+    Q_INVOKABLE QVariantList summary() const;
+    Q_INVOKABLE void reset();
+
+    QJsonObject toJson() const;
+    bool dumpJson(const QString &filePath) const;
+
+private:
+    struct Histogram {
+        static constexpr int s_bucketsPerPowerOfTwo = 4;
+        // Up to 2^40 ns, about 18 minutes
+        static constexpr int s_bucketCount = 40 * s_bucketsPerPowerOfTwo;
+
+        void add(qint64 nsecs);
+        qint64 percentile(qreal fraction) const;
+
+        std::array<quint32, s_bucketCount> buckets = {};
+        quint64 count = 0;
+        qint64 total = 0;
+        qint64 max = 0;
+    };
+
+    QHash<QString, Histogram> m_histograms;
+};
+
+/**
+ * Records in LatencyStats the time from its creation to stop(),
+ * or to its destruction if it wasn't stopped
+ */
+class LatencyTimer
+{
+public:
+    explicit LatencyTimer(const char *operation);
+    ~LatencyTimer();
+    Q_DISABLE_COPY_MOVE(LatencyTimer)
+
+    void stop();
+
+private:
+    const char *m_operation;
+    QElapsedTimer m_timer;
+    // For Tracing, negative when disabled
+    qint64 m_traceStart;
+};
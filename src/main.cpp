@@ -9,12 +9,18 @@
 #include <QApplication>
 #endif
 
+#include <QCommandLineParser>
+#include <QElapsedTimer>
 #include <QIcon>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 #include <QQuickStyle>
+#include <QQuickWindow>
 
 #include "app.h"
+#include "commandline.h"
+#include "latencystats.h"
+#include "tracing.h"
 #include "version-keepsecret.h"
 #include <KAboutData>
 #include <KCrash>
@@ -33,6 +39,15 @@ Q_DECL_EXPORT
 #endif
 int main(int argc, char *argv[])
 {
+    // For the time to the first frame
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
+    // Scripts get the commands without any window, or even a display
+    if (CommandLine::isRequested(argc, argv)) {
+        return CommandLine::run(argc, argv);
+    }
+
 #ifdef Q_OS_ANDROID
     QGuiApplication app(argc, argv);
     QQuickStyle::setStyle(QStringLiteral("org.kde.breeze"));
@@ -78,20 +93,69 @@ int main(int argc, char *argv[])
     KAboutData::setApplicationData(aboutData);
     QGuiApplication::setWindowIcon(QIcon::fromTheme(u"org.kde.keepsecret"_s));
 
+    QCommandLineParser parser;
+    const QCommandLineOption dumpLatencyOption(u"dump-latency"_s,
+                                               i18nc("@info:shell", "Write the latencies of the secret service calls to <file> as JSON on exit"),
+                                               i18nc("@info:shell value name", "file"));
+    parser.addOption(dumpLatencyOption);
+    const QCommandLineOption traceOption(u"trace"_s,
+                                         i18nc("@info:shell", "Write a timeline of the application to <file>, in the Chrome trace-event format"),
+                                         i18nc("@info:shell value name", "file"));
+    parser.addOption(traceOption);
+    // Handled by CommandLine::run(), listed here for --help
+    parser.addOptions(CommandLine::options());
+    aboutData.setupCommandLine(&parser);
+    parser.process(app);
+    aboutData.processCommandLine(&parser);
+
+    // Started as early as possible, to see the startup too
+    if (parser.isSet(traceOption)) {
+        Tracing::start(parser.value(traceOption));
+    } else if (qEnvironmentVariableIsSet("KEEPSECRET_TRACE")) {
+        Tracing::start(qEnvironmentVariable("KEEPSECRET_TRACE"));
+    }
+
+    if (parser.isSet(dumpLatencyOption)) {
+        const QString latencyFile = parser.value(dumpLatencyOption);
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, &app, [latencyFile]() {
+            LatencyStats::instance()->dumpJson(latencyFile);
+        });
+    }
+
     KCrash::initialize();
 
 #ifdef HAVE_KDBUSADDONS
     KDBusService service(KDBusService::Unique);
 #endif
 
+    const qint64 loadStart = Tracing::now();
     QQmlApplicationEngine engine;
     engine.rootContext()->setContextObject(new KLocalizedQmlContext(&engine));
     engine.loadFromModule("org.kde.keepsecret", u"Main");
+    Tracing::complete("Load Main.qml", "qml", loadStart);
 
     if (engine.rootObjects().isEmpty()) {
         qWarning() << " Error during loading main.qml";
         return -1;
     }
 
-    return app.exec();
+    // Emitted from the render thread, which may be another one
+    if (auto *window = qobject_cast<QQuickWindow *>(engine.rootObjects().constFirst())) {
+        QObject::connect(
+            window,
+            &QQuickWindow::frameSwapped,
+            &app,
+            [&app, startupTimer]() {
+                const auto elapsed = startupTimer.durationElapsed();
+                Tracing::instant("First frame", "qml");
+                QMetaObject::invokeMethod(&app, [elapsed]() {
+                    LatencyStats::instance()->record(QStringLiteral("Time to first frame"), elapsed);
+                });
+            },
+            static_cast<Qt::ConnectionType>(Qt::DirectConnection | Qt::SingleShotConnection));
+    }
+
+    const int result = app.exec();
+    Tracing::finish();
+    return result;
 }
@@ -0,0 +1,257 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "passwordgenerator.h"
+#include "keepsecret_debug.h"
+
+#include <QFile>
+#include <QRandomGenerator>
+#include <QSet>
+#include <QTextStream>
+
+#include <cmath>
+#include <limits>
+#include <utility>
+
+// Upper bound of the random pool, in 32 bit words
+static constexpr qsizetype s_maxPoolSize = 64 * 1024;
+
+static const char *s_classCharsets[PasswordGenerator::CharacterClassCount] = {"abcdefghijklmnopqrstuvwxyz",
+                                                                             "ABCDEFGHIJKLMNOPQRSTUVWXYZ",
+                                                                             "0123456789",
+                                                                             "!@#$%^&*()-_=+[]{}"};
+
+PasswordGenerator::Options PasswordGenerator::Options::fromVariantMap(const QVariantMap &map)
+{
+    Options options;
+
+    if (map.value(QStringLiteral("mode")).toString() == QStringLiteral("words")) {
+        options.mode = Words;
+    }
+    options.length = map.value(QStringLiteral("length"), options.length).toInt();
+
+    static const QString classKeys[CharacterClassCount] = {QStringLiteral("lower"),
+                                                           QStringLiteral("upper"),
+                                                           QStringLiteral("digits"),
+                                                           QStringLiteral("symbols")};
+    static const QString minimumKeys[CharacterClassCount] = {QStringLiteral("minLower"),
+                                                             QStringLiteral("minUpper"),
+                                                             QStringLiteral("minDigits"),
+                                                             QStringLiteral("minSymbols")};
+    for (int i = 0; i < CharacterClassCount; ++i) {
+        options.useClass[i] = map.value(classKeys[i], options.useClass[i]).toBool();
+        options.minimum[i] = map.value(minimumKeys[i], 0).toInt();
+    }
+
+    options.excludedCharacters = map.value(QStringLiteral("exclude")).toString();
+    options.separator = map.value(QStringLiteral("separator"), options.separator).toString();
+
+    if (map.contains(QStringLiteral("wordList"))) {
+        options.wordList = map.value(QStringLiteral("wordList")).toStringList();
+    } else if (map.contains(QStringLiteral("wordListFile"))) {
+        options.wordList = loadWordList(map.value(QStringLiteral("wordListFile")).toString());
+    }
+
+    return options;
+}
+
+PasswordGenerator::PasswordGenerator(const Options &options, QRandomGenerator *generator)
+    : m_options(options)
+    , m_generator(generator ? generator : QRandomGenerator::system())
+{
+    if (m_options.length <= 0) {
+        return;
+    }
+
+    if (m_options.mode == Words) {
+        // Duplicated words would make some words more likely than others
+        QSet<QString> seen;
+        for (const QString &word : std::as_const(m_options.wordList)) {
+            const QString trimmed = word.trimmed();
+            if (trimmed.isEmpty() || seen.contains(trimmed)) {
+                continue;
+            }
+            seen.insert(trimmed);
+            m_words << trimmed.toUtf8();
+        }
+        if (m_words.isEmpty()) {
+            return;
+        }
+        m_entropy = m_options.length * std::log2(double(m_words.count()));
+        m_valid = true;
+        return;
+    }
+
+    const QByteArray excluded = m_options.excludedCharacters.toLatin1();
+    int totalMinimum = 0;
+
+    for (int i = 0; i < CharacterClassCount; ++i) {
+        if (!m_options.useClass[i]) {
+            continue;
+        }
+        for (const char *c = s_classCharsets[i]; *c; ++c) {
+            if (!excluded.contains(*c)) {
+                m_classChars[i].append(*c);
+            }
+        }
+        m_charset.append(m_classChars[i]);
+
+        const int minimum = qMax(0, m_options.minimum[i]);
+        if (minimum > 0 && m_classChars[i].isEmpty()) {
+            return;
+        }
+        totalMinimum += minimum;
+    }
+
+    if (m_charset.isEmpty() || totalMinimum > m_options.length) {
+        return;
+    }
+
+    for (int i = 0; i < CharacterClassCount; ++i) {
+        if (m_options.useClass[i] && m_options.minimum[i] > 0) {
+            m_entropy += m_options.minimum[i] * std::log2(double(m_classChars[i].size()));
+        }
+    }
+    m_entropy += (m_options.length - totalMinimum) * std::log2(double(m_charset.size()));
+    m_valid = true;
+}
+
+PasswordGenerator::~PasswordGenerator()
+{
+    // Don't leave the random state around after it's been used for secrets
+    m_pool.fill(0);
+}
+
+bool PasswordGenerator::isValid() const
+{
+    return m_valid;
+}
+
+double PasswordGenerator::entropy() const
+{
+    return m_entropy;
+}
+
+void PasswordGenerator::refill()
+{
+    if (m_pool.size() < m_poolSize) {
+        m_pool.resize(m_poolSize);
+    }
+    m_generator->fillRange(m_pool.data(), m_pool.size());
+    m_poolPosition = 0;
+}
+
+quint32 PasswordGenerator::bounded(quint32 bound)
+{
+    Q_ASSERT(bound > 0);
+    // Largest multiple of bound representable in 32 bits: anything above it
+    // is rejected, otherwise the lower values would be more likely
+    const quint32 limit = std::numeric_limits<quint32>::max() - (std::numeric_limits<quint32>::max() % bound);
+
+    while (true) {
+        if (m_poolPosition >= m_pool.size()) {
+            refill();
+        }
+        const quint32 value = m_pool[m_poolPosition++];
+        if (value < limit) {
+            return value % bound;
+        }
+    }
+}
+
+QByteArray PasswordGenerator::generateOne()
+{
+    if (!m_valid) {
+        return QByteArray();
+    }
+
+    if (m_poolSize == 0) {
+        m_poolSize = qBound<qsizetype>(256, qsizetype(m_options.length) * 2, s_maxPoolSize);
+    }
+
+    if (m_options.mode == Words) {
+        QByteArray passphrase;
+        const QByteArray separator = m_options.separator.toUtf8();
+        for (int i = 0; i < m_options.length; ++i) {
+            if (i > 0) {
+                passphrase.append(separator);
+            }
+            passphrase.append(m_words[bounded(m_words.count())]);
+        }
+        return passphrase;
+    }
+
+    QByteArray password;
+    password.reserve(m_options.length);
+
+    // Required characters first, then shuffle them among the others
+    for (int i = 0; i < CharacterClassCount; ++i) {
+        if (!m_options.useClass[i]) {
+            continue;
+        }
+        for (int j = 0; j < m_options.minimum[i]; ++j) {
+            password.append(m_classChars[i].at(bounded(m_classChars[i].size())));
+        }
+    }
+    const bool needsShuffle = !password.isEmpty();
+
+    while (password.size() < m_options.length) {
+        password.append(m_charset.at(bounded(m_charset.size())));
+    }
+
+    if (needsShuffle) {
+        // Fisher-Yates
+        for (qsizetype i = password.size() - 1; i > 0; --i) {
+            std::swap(password[i], password[bounded(i + 1)]);
+        }
+    }
+
+    return password;
+}
+
+QList<PasswordGenerator::Result> PasswordGenerator::generate(int count)
+{
+    QList<Result> results;
+
+    if (!m_valid || count <= 0) {
+        return results;
+    }
+
+    // Size the pool for the whole batch (one draw per character plus the shuffle)
+    // so that big batches need only few calls to the system generator
+    m_poolSize = qBound<qsizetype>(256, qsizetype(count) * m_options.length * 2, s_maxPoolSize);
+
+    results.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        results.append({generateOne(), m_entropy});
+    }
+
+    return results;
+}
+
+QStringList PasswordGenerator::loadWordList(const QString &filePath)
+{
+    QStringList words;
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qCWarning(KEEPSECRET_LOG) << "Cannot open word list" << filePath;
+        return words;
+    }
+
+    QTextStream stream(&file);
+    QString line;
+    while (stream.readLineInto(&line)) {
+        const QString trimmed = line.trimmed();
+        if (trimmed.isEmpty() || trimmed.startsWith(QLatin1Char('#'))) {
+            continue;
+        }
+        // Diceware lists are in the form "11111\tword"
+        qsizetype wordStart = trimmed.size();
+        while (wordStart > 0 && !trimmed.at(wordStart - 1).isSpace()) {
+            --wordStart;
+        }
+        words << trimmed.mid(wordStart);
+    }
+
+    return words;
+}
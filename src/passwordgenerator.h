@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+
+class QRandomGenerator;
+
+/**
+ * Generates batches of passwords or passphrases.
+ * All the randomness for a batch is drawn from a single buffer which is
+ * refilled as needed, and every draw is rejection sampled, so no character
+ * or word is more likely than another regardless of the set size.
+ */
+class PasswordGenerator
+{
+public:
+    enum Mode {
+        Characters = 0,
+        Words
+    };
+
+    enum CharacterClass {
+        Lower = 0,
+        Upper,
+        Digits,
+        Symbols,
+        CharacterClassCount
+    };
+
+    struct Options {
+        Mode mode = Characters;
+        // Number of characters in Characters mode, number of words in Words mode
+        int length = 16;
+        bool useClass[CharacterClassCount] = {true, true, true, true};
+        // Minimum amount of characters of each class, only for Characters mode
+        int minimum[CharacterClassCount] = {0, 0, 0, 0};
+        // Characters that will never appear in the password, such as "lI1O0"
+        QString excludedCharacters;
+        QStringList wordList;
+        QString separator = QStringLiteral("-");
+
+        // Keys: mode ("characters" or "words"), length, lower, upper, digits, symbols,
+        // minLower, minUpper, minDigits, minSymbols, exclude, wordList, wordListFile, separator
+        static Options fromVariantMap(const QVariantMap &map);
+    };
+
+    struct Result {
+        QByteArray password;
+        // Estimated strength in bits
+        double entropy = 0;
+    };
+
+    explicit PasswordGenerator(const Options &options, QRandomGenerator *generator = nullptr);
+    ~PasswordGenerator();
+
+    // False if the options can't produce any password, such as an empty set of characters
+    bool isValid() const;
+
+    // Entropy in bits of every password produced with the current options.
+    // For the character mode this is a lower bound, as the spread given
+    // by shuffling the required characters isn't accounted for
+    double entropy() const;
+
+    QList<Result> generate(int count);
+    QByteArray generateOne();
+
+    // Reads one word per line, in diceware format the dice digits preceding the word are skipped
+    static QStringList loadWordList(const QString &filePath);
+
+private:
+    quint32 bounded(quint32 bound);
+    void refill();
+
+    Options m_options;
+    QByteArray m_classChars[CharacterClassCount];
+    QByteArray m_charset;
+    QList<QByteArray> m_words;
+    double m_entropy = 0;
+    bool m_valid = false;
+
+    QRandomGenerator *m_generator;
+    QList<quint32> m_pool;
+    qsizetype m_poolPosition = 0;
+    qsizetype m_poolSize = 0;
+};
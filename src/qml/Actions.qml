@@ -58,16 +58,46 @@ AC.ActionCollectionManager {
             text: i18nc("@action:inmenu", "Export…")
             icon.name: "document-export"
         }
+        AC.ActionData {
+            name: "backup-all-wallets"
+            text: i18nc("@action:inmenu", "Back Up All Wallets…")
+            icon.name: "document-save-all"
+        }
+        AC.ActionData {
+            name: "backup-incremental"
+            text: i18nc("@action:inmenu", "Incremental Backup…")
+            icon.name: "document-save"
+        }
+        AC.ActionData {
+            name: "compact-backup-journal"
+            text: i18nc("@action:inmenu", "Compact Backup Journal…")
+            icon.name: "archive-remove"
+        }
         AC.ActionData {
             name: "import-keepsecret"
             text: i18nc("@action:inmenu", "Import KeepSecret…")
             icon.name: "document-import"
         }
+        AC.ActionData {
+            name: "import-dry-run"
+            text: i18nc("@action:inmenu", "Check Import…")
+            icon.name: "document-preview"
+        }
+        AC.ActionData {
+            name: "import-csv"
+            text: i18nc("@action:inmenu", "Import CSV…")
+            icon.name: "document-import"
+        }
         AC.ActionData {
             name: "import-kwallet-xml"
             text: i18nc("@action:inmenu", "Import KWallet XML…")
             icon.name: "document-import"
         }
+        AC.ActionData {
+            name: "import-kwallet-file"
+            text: i18nc("@action:inmenu", "Import KWallet File…")
+            icon.name: "document-import"
+        }
     }
     AC.ActionCollection {
         name: "org.kde.keepsecret.item"
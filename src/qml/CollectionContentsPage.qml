@@ -13,12 +13,15 @@ import org.kde.keepsecret
 
 Kirigami.ScrollablePage {
     id: page
+    Component.onCompleted: App.tracePageLoaded("CollectionContentsPage")
 
     property alias currentEntry: view.currentIndex
     property var selectedIndices: []
     property int lastSelectedIndex: -1
     property int selectedCount: 0
     property bool selectionMode: false
+    // The file being imported is only compared with the wallet, nothing is written
+    property bool importDryRun: false
 
     title: App.collectionModel.collectionName
 
@@ -71,35 +74,14 @@ Kirigami.ScrollablePage {
                         : i18nc("@label", "Are you sure you want to delete the item “%1”?", singleLabel),
                     i18nc("@action:check", "I understand that the item(s) will be permanently deleted"),
                     () => {
-                        const sourceRows = indices
-                            .map(idx => view.model.mapToSource(view.model.index(idx, 0)).row)
-                            .sort((a, b) => b - a)
-
-                        let i = 0
-                        function handler(oldOps, newOps) {
-                            if ((oldOps & StateTracker.ItemDeleting) && !(newOps & StateTracker.ItemDeleting)) {
-                                deleteNext()
-                            }
-                        }
-                        function deleteNext() {
-                            if (i >= sourceRows.length) {
-                                App.stateTracker.operationsChanged.disconnect(handler)
-                                page.selectedIndices = []
-                                page.selectedCount = 0
-                                page.selectionMode = false 
-                                return
-                            }
-                            const dbusPath = App.collectionModel.dbusPathAt(sourceRows[i])
-                            i++
-                            if (!dbusPath) {
-                                deleteNext()
-                                return
-                            }
-                            App.secretItemForContextMenu.loadItemForDelete(App.collectionModel.collectionPath, dbusPath)
-                            App.secretItemForContextMenu.deleteItem()
-                        }
-                        App.stateTracker.operationsChanged.connect(handler)
-                        deleteNext()
+                        const dbusPaths = indices
+                            .map(idx => App.collectionModel.dbusPathAt(view.model.mapToSource(view.model.index(idx, 0)).row))
+                            .filter(path => path.length > 0)
+
+                        App.collectionModel.deleteItems(dbusPaths)
+                        page.selectedIndices = []
+                        page.selectedCount = 0
+                        page.selectionMode = false
                     }
                 );
             }
@@ -169,6 +151,35 @@ Kirigami.ScrollablePage {
             AC.ActionCollection.action: "export-wallet"
             onTriggered: exportDialog.open()
         },
+        Kirigami.Action {
+            displayHint: Kirigami.DisplayHint.AlwaysHide
+            enabled: App.stateTracker.status & StateTracker.ServiceConnected
+            visible: !page.selectionMode
+            AC.ActionCollection.collection: "org.kde.keepsecret.collection"
+            AC.ActionCollection.action: "backup-all-wallets"
+            onTriggered: backupAllDialog.open()
+        },
+        Kirigami.Action {
+            displayHint: Kirigami.DisplayHint.AlwaysHide
+            enabled: App.stateTracker.status & StateTracker.CollectionReady
+            visible: !page.selectionMode
+            AC.ActionCollection.collection: "org.kde.keepsecret.collection"
+            AC.ActionCollection.action: "backup-incremental"
+            onTriggered: {
+                const journalPath = App.importExportManager.lastJournalPath(App.collectionModel.collectionPath)
+                if (journalPath.length > 0) {
+                    journalDialog.selectedFile = "file://" + journalPath
+                }
+                journalDialog.open()
+            }
+        },
+        Kirigami.Action {
+            displayHint: Kirigami.DisplayHint.AlwaysHide
+            visible: !page.selectionMode
+            AC.ActionCollection.collection: "org.kde.keepsecret.collection"
+            AC.ActionCollection.action: "compact-backup-journal"
+            onTriggered: compactJournalDialog.open()
+        },
         Kirigami.Action {
             text: i18nc("@title:window Delete this wallet", "Delete Wallet")
             icon.name: "delete-symbolic"
@@ -192,16 +203,43 @@ Kirigami.ScrollablePage {
             icon.name: "document-import"
             displayHint: Kirigami.DisplayHint.AlwaysHide
             visible: !page.selectionMode
+            // New items are told apart from the existing ones, which must be loaded
+            enabled: App.stateTracker.status & StateTracker.CollectionReady
             Kirigami.Action {
                 AC.ActionCollection.collection: "org.kde.keepsecret.collection"
                 AC.ActionCollection.action: "import-keepsecret"
-                onTriggered: importDialog.open()
+                onTriggered: {
+                    page.importDryRun = false
+                    importDialog.open()
+                }
+            }
+            Kirigami.Action {
+                AC.ActionCollection.collection: "org.kde.keepsecret.collection"
+                AC.ActionCollection.action: "import-dry-run"
+                onTriggered: {
+                    page.importDryRun = true
+                    App.collectionModel.resetImportPlan()
+                    importDialog.open()
+                }
+            }
+            Kirigami.Action {
+                AC.ActionCollection.collection: "org.kde.keepsecret.collection"
+                AC.ActionCollection.action: "import-csv"
+                onTriggered: {
+                    page.importDryRun = false
+                    importCsvDialog.open()
+                }
             }
             Kirigami.Action {
                 AC.ActionCollection.collection: "org.kde.keepsecret.collection"
                 AC.ActionCollection.action: "import-kwallet-xml"
                 onTriggered: importKWalletDialog.open()
             }
+            Kirigami.Action {
+                AC.ActionCollection.collection: "org.kde.keepsecret.collection"
+                AC.ActionCollection.action: "import-kwallet-file"
+                onTriggered: importKWalletFileDialog.open()
+            }
         }
     ]
 
@@ -239,6 +277,25 @@ Kirigami.ScrollablePage {
         }
     }
 
+    footer: QQC.ToolBar {
+        // Reading App.importExportManager would create it
+        visible: App.importExportManagerCreated && App.importExportManager.running
+        contentItem: RowLayout {
+            QQC.ProgressBar {
+                Layout.fillWidth: true
+                value: App.importExportManagerCreated ? App.importExportManager.progress : 0
+            }
+            QQC.Label {
+                text: i18ncp("@info:progress", "%1 item", "%1 items", App.importExportManagerCreated ? App.importExportManager.itemsProcessed : 0)
+            }
+            QQC.Button {
+                text: i18nc("@action:button stop the running import or export", "Cancel")
+                icon.name: "dialog-cancel"
+                onClicked: App.importExportManager.cancel()
+            }
+        }
+    }
+
     QQC.Dialog {
         id: creationDialog
         modal: true
@@ -338,7 +395,7 @@ Kirigami.ScrollablePage {
         QQC.MenuItem {
             text: i18nc("@action:inmenu Copy this secret", "Copy Secret")
             icon.name: "edit-copy-symbolic"
-            enabled: App.secretItemForContextMenu.status !== SecretItemProxy.Locked
+            enabled: !App.secretItemForContextMenuCreated || App.secretItemForContextMenu.status !== SecretItemProxy.Locked
             onClicked: {
                 App.secretItemForContextMenu.loadItem(App.collectionModel.collectionPath, contextMenu.model.dbusPath)
                 App.secretItemForContextMenu.copySecret()
@@ -614,21 +671,83 @@ Kirigami.ScrollablePage {
         id: exportDialog
         title: i18nc("@title:window", "Export Wallet")
         fileMode: FileDialog.SaveFile
-        nameFilters: [i18nc("@label file type filter", "KeepSecret files (*.keepsecret)"), i18nc("@label file type filter", "All files (*)")]
+        nameFilters: [i18nc("@label file type filter", "KeepSecret files (*.keepsecret)"), i18nc("@label file type filter", "KeepSecret compact backups (*.ksbackup)"), i18nc("@label file type filter", "KeepSecret encrypted backups (*.ksencrypted)"), i18nc("@label file type filter", "CSV files (*.csv)"), i18nc("@label file type filter", "All files (*)")]
         onAccepted: {
-            App.importExportManager.exportToFile(
-                selectedFile.toString().replace("file://", ""),
-                App.collectionModel.collectionName,
-                App.collectionModel.exportItems()
-            )
+            const filePath = selectedFile.toString().replace("file://", "")
+            if (filePath.endsWith(".ksencrypted")) {
+                passphraseDialog.openForExport(filePath)
+            } else if (filePath.endsWith(".csv")) {
+                App.importExportManager.exportToCsv(
+                    filePath,
+                    App.collectionModel.collectionName,
+                    App.collectionModel.exportItems()
+                )
+            } else if (filePath.endsWith(".ksbackup")) {
+                App.importExportManager.exportToBinaryFile(
+                    filePath,
+                    App.collectionModel.collectionName,
+                    App.collectionModel.exportItems()
+                )
+            } else {
+                App.importExportManager.exportToFile(
+                    filePath,
+                    App.collectionModel.collectionName,
+                    App.collectionModel.exportItems()
+                )
+            }
+        }
+    }
+
+    FileDialog {
+        id: backupAllDialog
+        title: i18nc("@title:window", "Back Up All Wallets")
+        fileMode: FileDialog.SaveFile
+        nameFilters: [i18nc("@label file type filter", "KeepSecret compact backups (*.ksbackup)"), i18nc("@label file type filter", "KeepSecret encrypted backups (*.ksencrypted)")]
+        onAccepted: {
+            const filePath = selectedFile.toString().replace("file://", "")
+            if (filePath.endsWith(".ksencrypted")) {
+                passphraseDialog.openForBackupAll(filePath)
+            } else {
+                App.importExportManager.backupAllCollections(filePath)
+            }
+        }
+    }
+
+    FileDialog {
+        id: journalDialog
+        title: i18nc("@title:window", "Incremental Backup")
+        fileMode: FileDialog.SaveFile
+        // New backups are appended to an existing journal
+        options: FileDialog.DontConfirmOverwrite
+        nameFilters: [i18nc("@label file type filter", "KeepSecret backup journals (*.ksjournal)"), i18nc("@label file type filter", "All files (*)")]
+        // Set while the changed items are read
+        property var pending: null
+        onAccepted: {
+            const journalPath = selectedFile.toString().replace("file://", "")
+            const collectionPath = App.collectionModel.collectionPath
+            pending = {
+                journalPath: journalPath,
+                collectionPath: collectionPath,
+                walletName: App.collectionModel.collectionName,
+                modifiedSince: App.importExportManager.lastBackupPoint(collectionPath, journalPath)
+            }
+            App.collectionModel.loadChangedItems(pending.modifiedSince)
         }
     }
 
+    FileDialog {
+        id: compactJournalDialog
+        title: i18nc("@title:window", "Compact Backup Journal")
+        fileMode: FileDialog.OpenFile
+        nameFilters: [i18nc("@label file type filter", "KeepSecret backup journals (*.ksjournal)"), i18nc("@label file type filter", "All files (*)")]
+        onAccepted: App.importExportManager.compactJournal(selectedFile.toString().replace("file://", ""))
+    }
+
     FileDialog {
         id: importDialog
         title: i18nc("@title:window", "Import Wallet")
         fileMode: FileDialog.OpenFile
-        nameFilters: [i18nc("@label file type filter", "KeepSecret files (*.keepsecret)"), i18nc("@label file type filter", "All files (*)")]
+        nameFilters: [i18nc("@label file type filter", "KeepSecret files (*.keepsecret *.ksbackup *.ksencrypted *.ksjournal)"), i18nc("@label file type filter", "All files (*)")]
         onAccepted: {
             App.importExportManager.importFromFile(
                 selectedFile.toString().replace("file://", "")
@@ -636,6 +755,18 @@ Kirigami.ScrollablePage {
         }
     }
 
+    FileDialog {
+        id: importCsvDialog
+        title: i18nc("@title:window", "Import CSV")
+        fileMode: FileDialog.OpenFile
+        nameFilters: [i18nc("@label file type filter", "CSV files from browsers or KeePassXC (*.csv)"), i18nc("@label file type filter", "All files (*)")]
+        onAccepted: {
+            App.importExportManager.importFromCsv(
+                selectedFile.toString().replace("file://", "")
+            )
+        }
+    }
+
     FileDialog {
         id: importKWalletDialog
         title: i18nc("@title:window", "Import KWallet XML")
@@ -648,29 +779,160 @@ Kirigami.ScrollablePage {
         }
     }
 
-    Connections {
-        target: App.importExportManager
-        function onImportSucceeded(items) {
-            for (let i = 0; i < items.length; i++) {
-                let item = items[i]
-                let label = item["label"] || ""
-                let secret = item["secret"] || ""
-                let attrs = item["attributes"] || {}
-                let server = attrs["server"] || ""
-                let user = attrs["user"] || ""
-                App.secretItem.createItem(
-                    label,
-                    secret,
-                    user,
-                    server,
-                    App.collectionModel.collectionPath
+    FileDialog {
+        id: importKWalletFileDialog
+        title: i18nc("@title:window", "Import KWallet File")
+        fileMode: FileDialog.OpenFile
+        nameFilters: [i18nc("@label file type filter", "KWallet files (*.kwl)"), i18nc("@label file type filter", "All files (*)")]
+        onAccepted: passphraseDialog.openForKWallet(selectedFile.toString().replace("file://", ""))
+    }
+
+    QQC.Dialog {
+        id: passphraseDialog
+        property string filePath
+        // "export", "backupAll", "import" or "kwallet"
+        property string mode
+        readonly property bool exporting: mode === "export" || mode === "backupAll"
+        readonly property bool kwalletFile: mode === "kwallet"
+
+        function openForExport(path) {
+            filePath = path
+            mode = "export"
+            open()
+        }
+        function openForBackupAll(path) {
+            filePath = path
+            mode = "backupAll"
+            open()
+        }
+        function openForImport(path) {
+            filePath = path
+            mode = "import"
+            open()
+        }
+        function openForKWallet(path) {
+            filePath = path
+            mode = "kwallet"
+            open()
+        }
+        function checkOkEnabled() {
+            standardButton(QQC.Dialog.Ok).enabled = passphraseField.text.length > 0
+                && (!exporting || passphraseField.text === passphraseConfirmField.text)
+        }
+
+        parent: page.QQC.Overlay.overlay
+        anchors.centerIn: parent
+        modal: true
+        title: exporting ? i18nc("@title:window", "Encrypt Backup")
+            : kwalletFile ? i18nc("@title:window", "Open KWallet")
+            : i18nc("@title:window", "Decrypt Backup")
+        standardButtons: QQC.Dialog.Ok | QQC.Dialog.Cancel
+        Component.onCompleted: standardButton(QQC.Dialog.Ok).enabled = false
+
+        contentItem: ColumnLayout {
+            QQC.Label {
+                text: passphraseDialog.kwalletFile ? i18nc("@label:textbox", "Wallet password:") : i18nc("@label:textbox", "Passphrase:")
+            }
+            Kirigami.PasswordField {
+                id: passphraseField
+                Layout.fillWidth: true
+                onTextChanged: passphraseDialog.checkOkEnabled()
+            }
+            QQC.Label {
+                visible: passphraseDialog.exporting
+                text: i18nc("@label:textbox", "Repeat passphrase:")
+            }
+            Kirigami.PasswordField {
+                id: passphraseConfirmField
+                visible: passphraseDialog.exporting
+                Layout.fillWidth: true
+                onTextChanged: passphraseDialog.checkOkEnabled()
+            }
+        }
+
+        onAccepted: {
+            if (mode === "backupAll") {
+                App.importExportManager.backupAllCollections(filePath, passphraseField.text)
+            } else if (exporting) {
+                App.importExportManager.exportToEncryptedFile(
+                    filePath,
+                    App.collectionModel.collectionName,
+                    App.collectionModel.exportItems(),
+                    passphraseField.text
                 )
+            } else if (kwalletFile) {
+                App.importExportManager.importFromKWalletFile(filePath, passphraseField.text)
+            } else {
+                App.importExportManager.importFromFile(filePath, passphraseField.text)
+            }
+        }
+        onVisibleChanged: {
+            if (visible) {
+                passphraseField.forceActiveFocus()
+            } else {
+                passphraseField.text = ""
+                passphraseConfirmField.text = ""
             }
         }
+    }
+
+    Connections {
+        target: App.collectionModel
+        function onImportSummary(created, updated, skipped, failed) {
+            page.Window.window.showPassiveNotification(
+                i18nc("@info:status", "Import finished: %1 created, %2 updated, %3 skipped, %4 failed", created, updated, skipped, failed))
+        }
+        function onChangedItemsLoaded(collectionPath, items, dbusPaths, backupPoint) {
+            const backup = journalDialog.pending
+            if (!backup || backup.collectionPath !== collectionPath) {
+                return
+            }
+            journalDialog.pending = null
+            App.importExportManager.backupIncrementally(
+                backup.journalPath,
+                backup.collectionPath,
+                backup.walletName,
+                items,
+                dbusPaths,
+                backup.modifiedSince,
+                backupPoint
+            )
+        }
+    }
+
+    Connections {
+        target: App.importExportManagerCreated ? App.importExportManager : null
+        function onItemsImported(items) {
+            if (page.importDryRun) {
+                App.collectionModel.planImport(items)
+            } else {
+                App.collectionModel.importChunk(items)
+            }
+        }
+        function onImportSucceeded(count) {
+            if (!page.importDryRun) {
+                return
+            }
+            const plan = App.collectionModel.planImport([])
+            App.collectionModel.resetImportPlan()
+            const filePath = importDialog.selectedFile.toString().replace("file://", "")
+            page.Window.window.showPassiveNotification(
+                i18nc("@info:status", "%1 new, %2 changed and %3 identical items", plan.created, plan.updated, plan.skipped),
+                "long",
+                i18nc("@action:button", "Import"),
+                () => {
+                    page.importDryRun = false
+                    App.importExportManager.importFromFile(filePath)
+                })
+        }
+        function onPassphraseRequired(filePath) {
+            passphraseDialog.openForImport(filePath)
+        }
         function onExportSucceeded(filePath) {
             console.log("Export succeeded:", filePath)
         }
         function onErrorOccurred(message) {
+            App.collectionModel.resetImportPlan()
             page.Window.window.showErrorDialog(message)
         }
     }
@@ -11,10 +11,13 @@ import org.kde.keepsecret
 
 Kirigami.ScrollablePage {
     id: page
+    Component.onCompleted: App.tracePageLoaded("CollectionListPage")
     property int walletCount: App.collectionsModel.count
+    // The results of App.searchModel replace the wallets
+    readonly property bool searching: App.searchModel.query.length > 0
 
     property bool shouldShowWatermark:
-        !(pageStack && pageStack.wideMode) && walletCount > 1
+        !(pageStack && pageStack.wideMode) && walletCount > 1 && !searching
     Kirigami.Theme.colorSet: Kirigami.Theme.Window
     title: i18nc("@title:window List of wallets", "Wallets")
 
@@ -33,6 +36,17 @@ Kirigami.ScrollablePage {
         }
     ]
 
+    header: QQC.ToolBar {
+        contentItem: Kirigami.SearchField {
+            id: searchField
+            placeholderText: i18nc("@info:placeholder", "Search all wallets…")
+            // Every query goes to all the wallets
+            delaySearch: true
+            onAccepted: App.searchModel.query = text
+            Keys.onEscapePressed: text = ""
+        }
+    }
+
     onFocusChanged: {
         if (focus) {
             view.forceActiveFocus();
@@ -81,79 +95,132 @@ Kirigami.ScrollablePage {
 
     ListView {
         id: view
-        currentIndex: App.collectionsModel.currentIndex
+        currentIndex: page.searching ? -1 : App.collectionsModel.currentIndex
         keyNavigationEnabled: true
         activeFocusOnTab: true
-        model: App.collectionsModel
-        delegate: QQC.ItemDelegate {
-            id: delegate
-            required property var model
-            required property int index
+        model: page.searching ? App.searchModel : App.collectionsModel
+        delegate: page.searching ? searchResultDelegate : collectionDelegate
+        // Contiguous, the results are grouped by wallet
+        section.property: page.searching ? "collectionName" : ""
+        section.delegate: Kirigami.ListSectionHeader {
             width: view.width
-            icon.name: highlighted && !App.collectionModel.locked ? "wallet-open" : "wallet-closed"
-            text: model.display
-            highlighted: view.currentIndex == index
-            font.bold: App.secretService.defaultCollection === model.dbusPath
+            text: section
+            icon.name: "wallet-closed"
+        }
+        Component {
+            id: collectionDelegate
+            QQC.ItemDelegate {
+                id: delegate
+                required property var model
+                required property int index
+                width: view.width
+                icon.name: highlighted && !App.collectionModel.locked ? "wallet-open" : "wallet-closed"
+                text: model.display
+                highlighted: view.currentIndex == index
+                font.bold: App.secretService.defaultCollection === model.dbusPath
 
             
-            function click() {
-                if (contextMenu.visible) {
-                    return;
-                }
-                App.collectionModel.collectionPath = model.dbusPath;
-                App.secretItem.close();
-                view.forceActiveFocus();
-                if (!Kirigami.PageStack.pageStack.wideMode) {
-                    Kirigami.PageStack.pageStack.currentIndex = 1;
+                function click() {
+                    if (contextMenu.visible) {
+                        return;
+                    }
+                    App.collectionModel.collectionPath = model.dbusPath;
+                    App.secretItem.close();
+                    view.forceActiveFocus();
+                    if (!Kirigami.PageStack.pageStack.wideMode) {
+                        Kirigami.PageStack.pageStack.currentIndex = 1;
+                    }
                 }
-            }
 
-            onClicked: click()
-            Keys.onPressed: (event) => {
-                if (!view.activeFocus) {
-                    return;
-                }
-                if (event.key == Qt.Key_Enter || event.key == Qt.Key_Return) {
-                    delegate.click();
+                onClicked: click()
+                Keys.onPressed: (event) => {
+                    if (!view.activeFocus) {
+                        return;
+                    }
+                    if (event.key == Qt.Key_Enter || event.key == Qt.Key_Return) {
+                        delegate.click();
+                    }
                 }
-            }
 
-            TapHandler {
-                acceptedDevices: PointerDevice.Mouse | PointerDevice.TouchPad | PointerDevice.Stylus
-                acceptedButtons: Qt.RightButton
-                onPressedChanged: {
-                    if (pressed) {
+                TapHandler {
+                    acceptedDevices: PointerDevice.Mouse | PointerDevice.TouchPad | PointerDevice.Stylus
+                    acceptedButtons: Qt.RightButton
+                    onPressedChanged: {
+                        if (pressed) {
+                            contextMenu.model = model
+                            contextMenu.popup(delegate)
+                        }
+                    }
+                }
+                TapHandler {
+                    acceptedDevices: PointerDevice.TouchScreen
+                    onLongPressed: {
                         contextMenu.model = model
                         contextMenu.popup(delegate)
                     }
                 }
-            }
-            TapHandler {
-                acceptedDevices: PointerDevice.TouchScreen
-                onLongPressed: {
-                    contextMenu.model = model
-                    contextMenu.popup(delegate)
+
+                Kirigami.Icon {
+                    anchors {
+                        right: parent.right
+                        top: parent.top
+                        bottom: parent.bottom
+                        margins: Kirigami.Units.mediumSpacing
+                    }
+                    color: delegate.highlighted || delegate.down
+                            ? Kirigami.Theme.highlightedTextColor
+                            : (delegate.enabled ? Kirigami.Theme.textColor : Kirigami.Theme.disabledTextColor)
+                    width: Kirigami.Units.iconSizes.small
+                    visible: model.locked
+                    source: "object-locked-symbolic"
+                    TapHandler {
+                        onTapped: App.secretService.unlockCollection(model.dbusPath)
+                    }
                 }
             }
+        }
+        Component {
+            id: searchResultDelegate
+            QQC.ItemDelegate {
+                id: delegate
+                required property var model
+                width: view.width
+                text: model.display
 
-            Kirigami.Icon {
-                anchors {
-                    right: parent.right
-                    top: parent.top
-                    bottom: parent.bottom
-                    margins: Kirigami.Units.mediumSpacing
+                contentItem: RowLayout {
+                    spacing: Kirigami.Units.smallSpacing
+                    Kirigami.Icon {
+                        implicitWidth: Kirigami.Units.iconSizes.small
+                        implicitHeight: Kirigami.Units.iconSizes.small
+                        visible: delegate.model.locked
+                        source: "object-locked-symbolic"
+                    }
+                    QQC.Label {
+                        text: delegate.text
+                        Layout.fillWidth: true
+                        elide: Text.ElideRight
+                    }
+                    QQC.Label {
+                        text: delegate.model.folder
+                        opacity: 0.7
+                        elide: Text.ElideRight
+                        Layout.maximumWidth: delegate.width / 3
+                    }
                 }
-                color: delegate.highlighted || delegate.down
-                        ? Kirigami.Theme.highlightedTextColor
-                        : (delegate.enabled ? Kirigami.Theme.textColor : Kirigami.Theme.disabledTextColor)
-                width: Kirigami.Units.iconSizes.small
-                visible: model.locked
-                source: "object-locked-symbolic"
-                TapHandler {
-                    onTapped: App.secretService.unlockCollection(model.dbusPath)
+
+                // Opens the item in its own wallet
+                onClicked: {
+                    App.collectionModel.collectionPath = model.collectionPath;
+                    App.secretItem.loadItem(model.collectionPath, model.dbusPath);
                 }
             }
         }
+        Kirigami.PlaceholderMessage {
+            anchors.centerIn: parent
+            visible: page.searching && view.count === 0 && !App.searchModel.searching
+            icon.name: "search-symbolic"
+            text: i18nc("@info:status", "No search results")
+        }
         Image {
             anchors {
                 right: parent.right
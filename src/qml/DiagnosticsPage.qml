@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+import QtQuick
+import QtQuick.Controls as QQC
+import QtQuick.Layouts
+import org.kde.kirigami as Kirigami
+import org.kde.keepsecret
+
+// Hidden page with the latencies of the calls to the secret service, opened with Ctrl+Alt+Shift+D
+Kirigami.ScrollablePage {
+    id: page
+    Component.onCompleted: App.tracePageLoaded("DiagnosticsPage")
+    title: i18nc("@title:window", "Diagnostics")
+
+    actions: [
+        Kirigami.Action {
+            text: i18nc("@action:button", "Reset")
+            icon.name: "edit-clear-history"
+            onTriggered: {
+                App.latencyStats.reset()
+                listView.model = App.latencyStats.summary()
+            }
+        }
+    ]
+
+    Timer {
+        running: page.visible
+        repeat: true
+        triggeredOnStart: true
+        interval: 1000
+        onTriggered: listView.model = App.latencyStats.summary()
+    }
+
+    ListView {
+        id: listView
+
+        header: QQC.ItemDelegate {
+            width: ListView.view.width
+            contentItem: RowLayout {
+                QQC.Label {
+                    Layout.fillWidth: true
+                    font.bold: true
+                    text: i18nc("@title:column", "Operation")
+                }
+                Repeater {
+                    model: [i18nc("@title:column", "Count"), i18nc("@title:column 50th percentile", "p50"), i18nc("@title:column 95th percentile", "p95"), i18nc("@title:column 99th percentile", "p99"), i18nc("@title:column", "Max")]
+                    QQC.Label {
+                        Layout.preferredWidth: Kirigami.Units.gridUnit * 4
+                        horizontalAlignment: Text.AlignRight
+                        font.bold: true
+                        text: modelData
+                    }
+                }
+            }
+        }
+
+        delegate: QQC.ItemDelegate {
+            required property var modelData
+            width: ListView.view.width
+            contentItem: RowLayout {
+                QQC.Label {
+                    Layout.fillWidth: true
+                    elide: Text.ElideRight
+                    text: modelData.operation
+                }
+                Repeater {
+                    model: [modelData.count.toString(),
+                            i18nc("@item:intable milliseconds", "%1 ms", modelData.p50.toFixed(1)),
+                            i18nc("@item:intable milliseconds", "%1 ms", modelData.p95.toFixed(1)),
+                            i18nc("@item:intable milliseconds", "%1 ms", modelData.p99.toFixed(1)),
+                            i18nc("@item:intable milliseconds", "%1 ms", modelData.max.toFixed(1))]
+                    QQC.Label {
+                        Layout.preferredWidth: Kirigami.Units.gridUnit * 4
+                        horizontalAlignment: Text.AlignRight
+                        text: modelData
+                    }
+                }
+            }
+        }
+
+        Kirigami.PlaceholderMessage {
+            anchors.centerIn: parent
+            width: parent.width - Kirigami.Units.gridUnit * 4
+            visible: listView.count === 0
+            text: i18nc("@info:placeholder", "No calls to the secret service yet")
+        }
+    }
+}
@@ -11,6 +11,7 @@ import org.kde.keepsecret
 
 Kirigami.ScrollablePage {
     id: page
+    Component.onCompleted: App.tracePageLoaded("EntryPage")
 
     title: QQC.ApplicationWindow.window.pageStack.wideMode ? "" : App.secretItem.label
 
@@ -93,6 +94,14 @@ Kirigami.ScrollablePage {
             text: i18nc("@info clipboard auto-clear countdown", "Password copied. Clipboard will be cleared in %1 seconds.", clipboardSecondsRemaining)
         
             property int clipboardSecondsRemaining: 0
+
+            // Only for the visible countdown, clearing is done by ClipboardManager
+            Timer {
+                interval: 1000
+                repeat: true
+                running: clipboardMessage.visible && clipboardMessage.clipboardSecondsRemaining > 0
+                onTriggered: clipboardMessage.clipboardSecondsRemaining--
+            }
         }
 
         Connections {
@@ -28,6 +28,11 @@ Kirigami.ApplicationWindow {
         id: actions
         pageRow: root.pageStack
     }
+    // Not in any menu, for debugging performance issues
+    Shortcut {
+        sequence: "Ctrl+Alt+Shift+D"
+        onActivated: root.pageStack.pushDialogLayer("qrc:/qt/qml/org/kde/keepsecret/qml/DiagnosticsPage.qml")
+    }
 
     readonly property real minimumSidebarWidth: pageStack.defaultColumnWidth / 2
     readonly property real maximumSidebarWidth: (width - pageStack.defaultColumnWidth) / 2
@@ -52,15 +57,15 @@ Kirigami.ApplicationWindow {
         states: [
             State {
                 name: "multiWalletWithEntry"
-                when: !shouldHideSidebar && itemOpen && collectionListLoader.item !== null
+                when: !shouldHideSidebar && itemOpen && collectionListLoader.item !== null && entryPageLoader.item !== null
                 PropertyChanges {
                     target: root
-                    desiredPages: [collectionListLoader.item, collectionContentsPage, entryPage]
+                    desiredPages: [collectionListLoader.item, collectionContentsPage, entryPageLoader.item]
                 }
             },
             State {
                 name: "multiWallet"
-                when: !shouldHideSidebar && !itemOpen && collectionListLoader.item !== null
+                when: !shouldHideSidebar && (!itemOpen || entryPageLoader.item === null) && collectionListLoader.item !== null
                 PropertyChanges {
                     target: root
                     desiredPages: [collectionListLoader.item, collectionContentsPage]
@@ -68,15 +73,15 @@ Kirigami.ApplicationWindow {
             },
             State {
                 name: "singleWalletWithEntry"
-                when: shouldHideSidebar && itemOpen
+                when: shouldHideSidebar && itemOpen && entryPageLoader.item !== null
                 PropertyChanges {
                     target: root
-                    desiredPages: [collectionContentsPage, entryPage]
+                    desiredPages: [collectionContentsPage, entryPageLoader.item]
                 }
             },
             State {
                 name: "singleWallet"
-                when: shouldHideSidebar && !itemOpen
+                when: shouldHideSidebar && (!itemOpen || entryPageLoader.item === null)
                 PropertyChanges {
                     target: root
                     desiredPages: [collectionContentsPage]
@@ -339,7 +344,7 @@ Kirigami.ApplicationWindow {
             id: loadingIndicatorTimer
             interval: Kirigami.Units.humanMoment
             onTriggered: {
-                if (App.stateTracker.operations !== StateTracker.OperationNone) {
+                if (App.stateTracker.busy) {
                     loadingPopup.open()
                 }
             }
@@ -371,19 +376,29 @@ Kirigami.ApplicationWindow {
             let sidebarW = (!shouldHideSidebar && collectionListLoader.item && collectionListLoader.item.width > 0) 
             ? collectionListLoader.item.width 
             : (!shouldHideSidebar ? minimumSidebarWidth : 0)
-            let entryW = itemOpen ? entryPage.Kirigami.ColumnView.preferredWidth : 0
+            let entryW = itemOpen && entryPageLoader.item ? entryPageLoader.item.Kirigami.ColumnView.preferredWidth : 0
             return sidebarW + entryW
         }
     }
 
-    EntryPage {
-        id: entryPage
-        Kirigami.ColumnView.minimumWidth: minimumSidebarWidth
-        Kirigami.ColumnView.maximumWidth: root.width - (root.walletCount > 1 && collectionListLoader.item ? collectionListLoader.item.width : 0) - root.pageStack.defaultColumnWidth
+    Component {
+        id: entryPageComponent
+        EntryPage {
+            Kirigami.ColumnView.minimumWidth: minimumSidebarWidth
+            Kirigami.ColumnView.maximumWidth: root.width - (root.walletCount > 1 && collectionListLoader.item ? collectionListLoader.item.width : 0) - root.pageStack.defaultColumnWidth
 
-        // An arbitrary big width by default
-        Kirigami.ColumnView.preferredWidth: Kirigami.Units.gridUnit * 30
-        Kirigami.ColumnView.interactiveResizeEnabled: true
-        Kirigami.ColumnView.fillWidth: false
+            // An arbitrary big width by default
+            Kirigami.ColumnView.preferredWidth: Kirigami.Units.gridUnit * 30
+            Kirigami.ColumnView.interactiveResizeEnabled: true
+            Kirigami.ColumnView.fillWidth: false
+        }
+    }
+    // Not needed for the first frame: created in the background right
+    // after it, or right away once an item gets opened
+    Loader {
+        id: entryPageLoader
+        active: true
+        asynchronous: !root.itemOpen
+        sourceComponent: entryPageComponent
     }
 }
@@ -0,0 +1,382 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "searchmodel.h"
+#include "keepsecret_debug.h"
+#include "latencystats.h"
+#include "statetracker.h"
+
+#include <KLocalizedString>
+#include <QPointer>
+#include <algorithm>
+#include <optional>
+
+SearchModel::SearchModel(SecretServiceClient *secretServiceClient, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_secretServiceClient(secretServiceClient)
+{
+    connect(StateTracker::instance(), &StateTracker::serviceConnectedChanged, this, [this](bool connected) {
+        if (connected) {
+            refresh();
+        } else {
+            m_canceller.cancel();
+            beginResetModel();
+            m_entries.clear();
+            m_collections.clear();
+            endResetModel();
+            setPendingCollections(0);
+            Q_EMIT countChanged();
+        }
+    });
+
+    connect(m_secretServiceClient, &SecretServiceClient::collectionDeleted, this, [this](const QDBusObjectPath &path) {
+        removeCollection(path.path());
+    });
+
+    // Whether the items are locked changes with their collection
+    auto refreshCollection = [this](const QDBusObjectPath &path) {
+        for (const SecretServiceClient::CollectionEntry &entry : std::as_const(m_collections)) {
+            if (entry.dbusPath == path.path()) {
+                refresh();
+                return;
+            }
+        }
+    };
+    connect(m_secretServiceClient, &SecretServiceClient::collectionLocked, this, refreshCollection);
+    connect(m_secretServiceClient, &SecretServiceClient::collectionUnlocked, this, refreshCollection);
+}
+
+SearchModel::~SearchModel()
+{
+}
+
+QString SearchModel::query() const
+{
+    return m_query;
+}
+
+void SearchModel::setQuery(const QString &query)
+{
+    if (query == m_query) {
+        return;
+    }
+
+    QVariantMap attributes;
+    QStringList labelWords;
+    for (const QString &word : query.split(u' ', Qt::SkipEmptyParts)) {
+        const int separator = word.indexOf(u'=');
+        if (separator > 0) {
+            attributes.insert(word.left(separator), word.mid(separator + 1));
+        } else {
+            labelWords.append(word);
+        }
+    }
+
+    m_query = query;
+    Q_EMIT queryChanged();
+    start(attributes, labelWords.join(u' '));
+}
+
+void SearchModel::search(const QVariantMap &attributes, const QString &label)
+{
+    QStringList words;
+    for (auto it = attributes.constBegin(); it != attributes.constEnd(); ++it) {
+        words.append(it.key() + u'=' + it.value().toString());
+    }
+    if (!label.isEmpty()) {
+        words.append(label);
+    }
+
+    const QString query = words.join(u' ');
+    if (query != m_query) {
+        m_query = query;
+        Q_EMIT queryChanged();
+    }
+    start(attributes, label);
+}
+
+void SearchModel::start(const QVariantMap &attributes, const QString &label)
+{
+    // Whatever is still running is for the previous query
+    m_canceller.cancel();
+
+    m_attributes = attributes;
+    m_label = label;
+
+    beginResetModel();
+    m_entries.clear();
+    m_collections.clear();
+    endResetModel();
+    Q_EMIT countChanged();
+
+    refresh();
+}
+
+void SearchModel::clear()
+{
+    setQuery(QString());
+}
+
+struct CollectionSearchRequest {
+    QPointer<SearchModel> model;
+    SecretCollectionPtr collection;
+    int collectionIndex;
+    GHashTablePtr attributes;
+    GCancellablePtr cancellable;
+    SecretServiceClient::RequestSlot slot;
+    // Started with the request, not counting the time in the queue
+    std::optional<LatencyTimer> latency;
+};
+
+static void onCollectionSearched(GObject *source, GAsyncResult *result, gpointer data)
+{
+    std::unique_ptr<CollectionSearchRequest> request(static_cast<CollectionSearchRequest *>(data));
+    GError *error = nullptr;
+    QString message;
+
+    GListPtr list = GListPtr(secret_collection_search_finish(SECRET_COLLECTION(source), result, &error));
+    request->latency.reset();
+
+    // The list owns a reference to each item
+    QList<SecretItemPtr> items;
+    for (GList *l = list.get(); l != nullptr; l = l->next) {
+        items.append(SecretItemPtr(SECRET_ITEM(l->data)));
+    }
+
+    if (SecretServiceClient::wasCancelled(&error) || !request->model) {
+        g_clear_error(&error);
+        return;
+    }
+
+    const bool success = SecretServiceClient::wasErrorFree(&error, message);
+    request->model->collectionSearched(request->collectionIndex, items, success, message);
+}
+
+void SearchModel::refresh()
+{
+    m_canceller.cancel();
+
+    if ((m_attributes.isEmpty() && m_label.isEmpty()) || !StateTracker::instance()->isServiceConnected()) {
+        setPendingCollections(0);
+        return;
+    }
+
+    // The results of each collection are replaced when it answers,
+    // unless the collections themselves changed
+    const QList<SecretServiceClient::CollectionEntry> collections = m_secretServiceClient->listCollections();
+    bool sameCollections = collections.size() == m_collections.size();
+    for (int i = 0; sameCollections && i < collections.size(); ++i) {
+        sameCollections = collections[i].dbusPath == m_collections[i].dbusPath;
+    }
+    if (!sameCollections) {
+        beginResetModel();
+        m_entries.clear();
+        m_collections = collections;
+        endResetModel();
+        Q_EMIT countChanged();
+    }
+
+    // Shared by all the requests
+    GHashTablePtr attributes = GHashTablePtr(g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free));
+    for (auto it = m_attributes.constBegin(); it != m_attributes.constEnd(); ++it) {
+        g_hash_table_insert(attributes.get(), g_strdup(it.key().toUtf8().constData()), g_strdup(it.value().toString().toUtf8().constData()));
+    }
+
+    int pending = 0;
+    for (int i = 0; i < m_collections.size(); ++i) {
+        SecretCollectionPtr collection = SecretCollectionPtr(m_secretServiceClient->retrieveCollection(m_collections[i].dbusPath));
+        if (!collection) {
+            continue;
+        }
+
+        auto *request = new CollectionSearchRequest{this,
+                                                    std::move(collection),
+                                                    i,
+                                                    GHashTablePtr(g_hash_table_ref(attributes.get())),
+                                                    m_canceller.ref()};
+        // All the collections at once, as far as the request limit allows
+        m_secretServiceClient->scheduleRequest(SecretServiceClient::InteractivePriority, [request](SecretServiceClient::RequestSlot slot) {
+            request->slot = std::move(slot);
+            request->latency.emplace("secret_collection_search");
+            // Locked items are found too, without unlocking them
+            secret_collection_search(request->collection.get(),
+                                     nullptr,
+                                     request->attributes.get(),
+                                     SECRET_SEARCH_ALL,
+                                     request->cancellable.get(),
+                                     onCollectionSearched,
+                                     request);
+        });
+        ++pending;
+    }
+    setPendingCollections(pending);
+}
+
+bool SearchModel::isSearching() const
+{
+    return m_pendingCollections > 0;
+}
+
+void SearchModel::collectionSearched(int collectionIndex, const QList<SecretItemPtr> &items, bool success, const QString &message)
+{
+    setPendingCollections(m_pendingCollections - 1);
+
+    if (!success) {
+        // The other collections still have their results
+        qCWarning(KEEPSECRET_LOG) << "Cannot search" << m_collections.value(collectionIndex).dbusPath << message;
+        return;
+    }
+
+    QList<Entry> found;
+    for (const SecretItemPtr &item : items) {
+        Entry entry;
+        entry.label = QString::fromUtf8(secret_item_get_label(item.get()));
+        if (!entry.label.contains(m_label, Qt::CaseInsensitive)) {
+            continue;
+        }
+        entry.dbusPath = QString::fromUtf8(g_dbus_proxy_get_object_path(G_DBUS_PROXY(item.get())));
+        entry.locked = secret_item_get_locked(item.get());
+        entry.collectionIndex = collectionIndex;
+
+        GHashTablePtr attributes = GHashTablePtr(secret_item_get_attributes(item.get()));
+        if (attributes) {
+            GHashTableIter iter;
+            gpointer key, value;
+            g_hash_table_iter_init(&iter, attributes.get());
+            while (g_hash_table_iter_next(&iter, &key, &value)) {
+                entry.attributes.insert(QString::fromUtf8(static_cast<gchar *>(key)), QString::fromUtf8(static_cast<gchar *>(value)));
+            }
+        }
+
+        // Like in CollectionModel
+        entry.folder = entry.attributes.value(QStringLiteral("server")).toString();
+        if (entry.folder.isEmpty()) {
+            entry.folder = entry.attributes.value(QStringLiteral("service")).toString();
+        }
+        if (entry.folder.isEmpty()) {
+            entry.folder = i18nc("@info Other type of secret", "Other");
+        }
+
+        found.append(entry);
+    }
+
+    std::sort(found.begin(), found.end(), [](const Entry &a, const Entry &b) {
+        const int folder = a.folder.compare(b.folder, Qt::CaseInsensitive);
+        return folder != 0 ? folder < 0 : a.label.compare(b.label, Qt::CaseInsensitive) < 0;
+    });
+
+    // The rows are ordered by collection, the ones of this collection are from a refresh
+    auto byCollection = [](const Entry &entry, int index) {
+        return entry.collectionIndex < index;
+    };
+    const int first = std::lower_bound(m_entries.cbegin(), m_entries.cend(), collectionIndex, byCollection) - m_entries.cbegin();
+    int last = first;
+    while (last < m_entries.size() && m_entries[last].collectionIndex == collectionIndex) {
+        ++last;
+    }
+
+    if (last > first) {
+        beginRemoveRows(QModelIndex(), first, last - 1);
+        m_entries.remove(first, last - first);
+        endRemoveRows();
+    }
+
+    if (!found.isEmpty()) {
+        beginInsertRows(QModelIndex(), first, first + found.size() - 1);
+        m_entries = m_entries.first(first) + found + m_entries.sliced(first);
+        endInsertRows();
+    }
+
+    if (last > first || !found.isEmpty()) {
+        Q_EMIT countChanged();
+    }
+}
+
+void SearchModel::removeCollection(const QString &collectionPath)
+{
+    const auto it = std::find_if(m_collections.cbegin(), m_collections.cend(), [&collectionPath](const SecretServiceClient::CollectionEntry &entry) {
+        return entry.dbusPath == collectionPath;
+    });
+    if (it == m_collections.cend()) {
+        return;
+    }
+
+    const int collectionIndex = it - m_collections.cbegin();
+    int first = 0;
+    while (first < m_entries.size() && m_entries[first].collectionIndex < collectionIndex) {
+        ++first;
+    }
+    int last = first;
+    while (last < m_entries.size() && m_entries[last].collectionIndex == collectionIndex) {
+        ++last;
+    }
+    if (last == first) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), first, last - 1);
+    m_entries.remove(first, last - first);
+    endRemoveRows();
+    Q_EMIT countChanged();
+}
+
+void SearchModel::setPendingCollections(int pending)
+{
+    const bool wasSearching = isSearching();
+    m_pendingCollections = pending;
+    if (wasSearching != isSearching()) {
+        Q_EMIT searchingChanged();
+    }
+}
+
+QHash<int, QByteArray> SearchModel::roleNames() const
+{
+    QHash<int, QByteArray> roleNames = QAbstractListModel::roleNames();
+    roleNames[FolderRole] = "folder";
+    roleNames[DbusPathRole] = "dbusPath";
+    roleNames[CollectionPathRole] = "collectionPath";
+    roleNames[CollectionNameRole] = "collectionName";
+    roleNames[LockedRole] = "locked";
+    roleNames[AttributesRole] = "attributes";
+
+    return roleNames;
+}
+
+int SearchModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+
+    return m_entries.count();
+}
+
+QVariant SearchModel::data(const QModelIndex &index, int role) const
+{
+    if (!checkIndex(index, QAbstractItemModel::CheckIndexOption::IndexIsValid)) {
+        return {};
+    }
+
+    const Entry &entry = m_entries[index.row()];
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return entry.label;
+    case FolderRole:
+        return entry.folder;
+    case DbusPathRole:
+        return entry.dbusPath;
+    case CollectionPathRole:
+        return m_collections.value(entry.collectionIndex).dbusPath;
+    case CollectionNameRole:
+        return m_collections.value(entry.collectionIndex).name;
+    case LockedRole:
+        return entry.locked;
+    case AttributesRole:
+        return entry.attributes;
+    }
+
+    return {};
+}
+
+#include "moc_searchmodel.cpp"
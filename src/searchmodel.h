@@ -0,0 +1,93 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "secretserviceclient.h"
+#include <QAbstractListModel>
+#include <qqmlregistration.h>
+
+/**
+ * The items of all the collections matching a query, without opening them.
+ * Every collection is searched with its own request, all of them at once,
+ * and the results are added as each collection answers: they are grouped
+ * by collection in the order of SecretServiceClient::listCollections(),
+ * sorted by folder and label within it.
+ * Locked collections are searched too, without unlocking them.
+ */
+class SearchModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Cannot create elements of type SearchModel")
+
+    // Words like attribute=value must all be attributes of the items, the
+    // rest must be in their label, ignoring case
+    Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged)
+    // True until all the collections have answered
+    Q_PROPERTY(bool searching READ isSearching NOTIFY searchingChanged)
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Roles {
+        FolderRole = Qt::UserRole + 1,
+        DbusPathRole,
+        CollectionPathRole,
+        CollectionNameRole,
+        LockedRole,
+        AttributesRole
+    };
+    Q_ENUM(Roles)
+
+    explicit SearchModel(SecretServiceClient *secretServiceClient, QObject *parent = nullptr);
+    ~SearchModel() override;
+
+    QString query() const;
+    void setQuery(const QString &query);
+
+    // Like setQuery(), also for values with spaces. With empty attributes
+    // and label nothing is searched
+    void search(const QVariantMap &attributes, const QString &label);
+    // Searches again with the same query, the results stay until the new ones are there
+    Q_INVOKABLE void refresh();
+    Q_INVOKABLE void clear();
+
+    bool isSearching() const;
+
+    // For the static libsecret handlers
+    void collectionSearched(int collectionIndex, const QList<SecretItemPtr> &items, bool success, const QString &message);
+
+    QHash<int, QByteArray> roleNames() const override;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+Q_SIGNALS:
+    void queryChanged();
+    void searchingChanged();
+    void countChanged();
+
+private:
+    struct Entry {
+        QString label;
+        QString dbusPath;
+        QString folder;
+        QVariantMap attributes;
+        bool locked = false;
+        // In m_collections
+        int collectionIndex = 0;
+    };
+
+    void start(const QVariantMap &attributes, const QString &label);
+    void removeCollection(const QString &collectionPath);
+    void setPendingCollections(int pending);
+
+    SecretServiceClient *const m_secretServiceClient;
+    RequestCanceller m_canceller;
+    QString m_query;
+    QVariantMap m_attributes;
+    QString m_label;
+    // The ones searched, by their order in the results
+    QList<SecretServiceClient::CollectionEntry> m_collections;
+    QList<Entry> m_entries;
+    int m_pendingCollections = 0;
+};
@@ -2,19 +2,42 @@
 // SPDX-FileCopyrightText: 2025 Marco Martin <notmart@gmail.com>
 
 #include "secretitemproxy.h"
+#include "clipboardmanager.h"
 #include "keepsecret_debug.h"
+#include "latencystats.h"
+#include "passwordgenerator.h"
 #include "secretserviceclient.h"
 #include "statetracker.h"
 
 #include <KLocalizedString>
-#include <QClipboard>
-#include<QRandomGenerator>
-#include <QGuiApplication>
-#include <QMimeData> 
-#include <QCoreApplication>
+#include <QPointer>
+#include <optional>
 
 using namespace std::literals::chrono_literals;
 
+// Data of the callbacks of the requests on the item: it may wait in the
+// queue of the SecretServiceClient, so it keeps its own reference to the item.
+// Ends the operation and frees the request slot when deleted
+struct ItemRequest {
+    QPointer<SecretItemProxy> proxy;
+    SecretItemPtr item;
+    StateTracker::OperationHandle operation;
+    GCancellablePtr cancellable;
+    SecretServiceClient::RequestSlot slot;
+    // Started with the libsecret call, not counting the time in the queue
+    std::optional<LatencyTimer> latency;
+    // Only for the requests which write them
+    SecretCollectionPtr collection;
+    QByteArray label;
+    GHashTablePtr attributes;
+    SecretValuePtr secretValue;
+};
+
+static SecretItemPtr refItem(SecretItem *item)
+{
+    return SecretItemPtr(item ? SECRET_ITEM(g_object_ref(item)) : nullptr);
+}
+
 SecretItemProxy::SecretItemProxy(SecretServiceClient *secretServiceClient, QObject *parent)
     : QObject(parent)
     , m_secretServiceClient(secretServiceClient)
@@ -39,25 +62,18 @@ SecretItemProxy::SecretItemProxy(SecretServiceClient *secretServiceClient, QObje
                     Q_EMIT itemLoaded();
                 }
             });
-            m_clipboardTimer = new QTimer(this);
-            m_clipboardTimer->setInterval(std::chrono::seconds(1));
-            connect(m_clipboardTimer, &QTimer::timeout, this, [this]() {
-                m_clipboardSecondsRemaining--;
-                if (m_clipboardSecondsRemaining <= 0) {
-                    m_clipboardTimer->stop();
-                    clearClipboard();
-                } else {
-                Q_EMIT clipboardWillClear(m_clipboardSecondsRemaining);
-                }
-            });
 
-            connect(qApp, &QCoreApplication::aboutToQuit, this, [this]() {
-                clearClipboard();
-            });
+    connect(ClipboardManager::instance(), &ClipboardManager::cleared, this, [this](const QByteArray &token) {
+        if (token == m_clipboardToken) {
+            m_clipboardToken.clear();
+            Q_EMIT clipboardCleared();
+        }
+    });
 }
 
 SecretItemProxy::~SecretItemProxy()
 {
+    // The pending requests are cancelled by the cancellers
 }
 
 QDateTime SecretItemProxy::creationTime() const
@@ -165,14 +181,8 @@ void SecretItemProxy::setAttribute(const QString &key, const QString &value)
 
 void SecretItemProxy::copySecret()
 {
-    auto *mimeData = new QMimeData();
-    mimeData->setText(QString::fromUtf8(m_secretValue));
-    mimeData->setData(QStringLiteral("x-kde-passwordManagerHint"), QByteArrayLiteral("secret"));
-    qApp->clipboard()->setMimeData(mimeData);
-
-    m_clipboardSecondsRemaining = m_clipboardClearTimeout.count();
-    Q_EMIT clipboardWillClear(m_clipboardSecondsRemaining);
-    m_clipboardTimer->start();
+    m_clipboardToken = ClipboardManager::instance()->copy(QString::fromUtf8(m_secretValue), m_clipboardClearTimeout);
+    Q_EMIT clipboardWillClear(m_clipboardClearTimeout.count());
 }
 
 std::chrono::seconds SecretItemProxy::clipboardClearTimeout() const
@@ -189,43 +199,36 @@ void SecretItemProxy::setClipboardClearTimeout(std::chrono::seconds seconds)
     Q_EMIT clipboardClearTimeoutChanged();
 }
 
-void SecretItemProxy::clearClipboard()
+QByteArray SecretItemProxy::generatePassword(int length, bool includeLower, bool includeUpper, bool includeDigits, bool includeSymbols) const
 {
-    if (qApp->clipboard()->text() == QString::fromUtf8(m_secretValue)) {
-        qApp->clipboard()->setText(QString());
-    }
-    m_clipboardTimer->stop();
-    Q_EMIT clipboardCleared();
+    PasswordGenerator::Options options;
+    options.length = length;
+    options.useClass[PasswordGenerator::Lower] = includeLower;
+    options.useClass[PasswordGenerator::Upper] = includeUpper;
+    options.useClass[PasswordGenerator::Digits] = includeDigits;
+    options.useClass[PasswordGenerator::Symbols] = includeSymbols;
+
+    PasswordGenerator generator(options);
+    return generator.generateOne();
 }
 
-QByteArray SecretItemProxy::generatePassword(int length, bool includeLower, bool includeUpper, bool includeDigits, bool includeSymbols) const
+QVariantList SecretItemProxy::generatePasswords(int count, const QVariantMap &options) const
 {
-    QString charset;
-    if (includeLower) {
-        charset += QStringLiteral("abcdefghijklmnopqrstuvwxyz");
-    }
-    if (includeUpper) {
-        charset += QStringLiteral("ABCDEFGHIJKLMNOPQRSTUVWXYZ");
-    }
-    if (includeDigits) {
-        charset += QStringLiteral("0123456789");
-    }
-    if (includeSymbols) {
-        charset += QStringLiteral("!@#$%^&*()-_=+[]{}");
-    }
+    QVariantList passwords;
+    PasswordGenerator generator(PasswordGenerator::Options::fromVariantMap(options));
 
-    if (charset.isEmpty() || length <= 0) {
-        return QByteArray();
+    if (!generator.isValid()) {
+        qCWarning(KEEPSECRET_LOG) << "Invalid password generator options" << options.keys();
+        return passwords;
     }
 
-    QByteArray password;
-    password.reserve(length);
-    for (int i = 0; i < length; ++i) {
-        int index = QRandomGenerator::global()->bounded(charset.length());
-        password.append(charset.at(index).toLatin1());
+    const QList<PasswordGenerator::Result> results = generator.generate(count);
+    passwords.reserve(results.count());
+    for (const PasswordGenerator::Result &result : results) {
+        passwords.append(QVariantMap{{QStringLiteral("password"), result.password}, {QStringLiteral("entropy"), result.entropy}});
     }
 
-    return password;
+    return passwords;
 }
 
 SecretServiceClient::Type SecretItemProxy::type() const
@@ -233,17 +236,24 @@ SecretServiceClient::Type SecretItemProxy::type() const
     return m_type;
 }
 
-static void onLoadSecretFinish(GObject *source, GAsyncResult *result, gpointer inst)
+static void onLoadSecretFinish(GObject *source, GAsyncResult *result, gpointer data)
 {
+    std::unique_ptr<ItemRequest> request(static_cast<ItemRequest *>(data));
     GError *error = nullptr;
-    SecretItemProxy *proxy = (SecretItemProxy *)inst;
+    SecretItemProxy *proxy = request->proxy;
 
     secret_item_load_secret_finish((SecretItem *)source, result, &error);
+    request->latency.reset();
 
     QString message;
 
+    if (SecretServiceClient::wasCancelled(&error) || !proxy) {
+        g_clear_error(&error);
+        return;
+    }
+
     if (SecretServiceClient::wasErrorFree(&error, message)) {
-        SecretValuePtr secretValue = SecretValuePtr(secret_item_get_secret(proxy->secretItem()));
+        SecretValuePtr secretValue = SecretValuePtr(secret_item_get_secret(request->item.get()));
 
         if (secretValue) {
             if (proxy->type() == SecretServiceClient::Binary) {
@@ -266,24 +276,27 @@ static void onLoadSecretFinish(GObject *source, GAsyncResult *result, gpointer i
     } else {
         StateTracker::instance()->setError(StateTracker::ItemLoadSecretError, message);
     }
-    StateTracker::instance()->clearOperation(StateTracker::ItemLoadingSecret);
 }
 
-static void onItemCreateFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onItemCreateFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
     Q_UNUSED(source);
-    Q_UNUSED(inst);
+    std::unique_ptr<ItemRequest> request(static_cast<ItemRequest *>(data));
     GError *error = nullptr;
     QString message;
 
     secret_item_create_finish(result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
     } else {
         StateTracker::instance()->setError(StateTracker::ItemCreationError, message);
     }
-    StateTracker::instance()->clearOperation(StateTracker::ItemCreating);
 }
 
 void SecretItemProxy::createItem(const QString &label,
@@ -301,7 +314,7 @@ void SecretItemProxy::createItem(const QString &label,
     // TODO: make it a paramenter?
     const SecretServiceClient::Type type = SecretServiceClient::PlainText;
 
-    SecretCollection *collection = m_secretServiceClient->retrieveCollection(collectionPath);
+    SecretCollectionPtr collection(m_secretServiceClient->retrieveCollection(collectionPath));
 
     QByteArray data;
     if (type == SecretServiceClient::Base64) {
@@ -330,17 +343,25 @@ void SecretItemProxy::createItem(const QString &label,
     g_hash_table_insert(attributes.get(), g_strdup("type"), g_strdup(m_secretServiceClient->typeToString(type).toUtf8().constData()));
     g_hash_table_insert(attributes.get(), g_strdup("server"), g_strdup(server.toUtf8().constData()));
 
-    secret_item_create(collection,
-                       m_secretServiceClient->qtKeychainSchema(),
-                       attributes.get(),
-                       label.toUtf8().constData(),
-                       secretValue.get(),
-                       SECRET_ITEM_CREATE_REPLACE,
-                       nullptr,
-                       onItemCreateFinished,
-                       this);
-
-    StateTracker::instance()->setOperation(StateTracker::ItemCreating);
+    auto *request = new ItemRequest{this, {}, StateTracker::instance()->beginOperation(StateTracker::ItemCreating), m_canceller.ref()};
+    request->collection = std::move(collection);
+    request->label = label.toUtf8();
+    request->attributes = std::move(attributes);
+    request->secretValue = std::move(secretValue);
+
+    m_secretServiceClient->scheduleRequest(SecretServiceClient::InteractivePriority, [request](SecretServiceClient::RequestSlot slot) {
+        request->slot = std::move(slot);
+        request->latency.emplace("secret_item_create");
+        secret_item_create(request->collection.get(),
+                           SecretServiceClient::qtKeychainSchema(),
+                           request->attributes.get(),
+                           request->label.constData(),
+                           request->secretValue.get(),
+                           SECRET_ITEM_CREATE_REPLACE,
+                           request->cancellable.get(),
+                           onItemCreateFinished,
+                           request);
+    });
 }
 
 void SecretItemProxy::loadItem(const QString &collectionPath, const QString &itemPath)
@@ -356,6 +377,9 @@ void SecretItemProxy::loadItem(const QString &collectionPath, const QString &ite
         return;
     }
 
+    // The secret of the previous item is not needed anymore
+    m_readCanceller.cancel();
+
     bool ok;
 
     m_secretItem = m_secretServiceClient->retrieveItem(itemPath, collectionPath, &ok);
@@ -400,8 +424,15 @@ void SecretItemProxy::loadItem(const QString &collectionPath, const QString &ite
         if (StateTracker::instance()->status() & StateTracker::ItemLocked) {
             unlock();
         } else {
-            StateTracker::instance()->setOperation(StateTracker::ItemLoadingSecret);
-            secret_item_load_secret(m_secretItem.get(), nullptr, onLoadSecretFinish, this);
+            auto *request = new ItemRequest{this,
+                                            refItem(m_secretItem.get()),
+                                            StateTracker::instance()->beginOperation(StateTracker::ItemLoadingSecret),
+                                            m_readCanceller.ref()};
+            m_secretServiceClient->scheduleRequest(SecretServiceClient::InteractivePriority, [request](SecretServiceClient::RequestSlot slot) {
+                request->slot = std::move(slot);
+                request->latency.emplace("secret_item_load_secret");
+                secret_item_load_secret(request->item.get(), request->cancellable.get(), onLoadSecretFinish, request);
+            });
         }
 
         StateTracker::instance()->clearError();
@@ -453,13 +484,18 @@ void SecretItemProxy::loadItemForDelete(const QString &collectionPath, const QSt
     }
 }
 
-static void onItemUnlockFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onItemUnlockFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
-    Q_UNUSED(inst);
+    std::unique_ptr<ItemRequest> request(static_cast<ItemRequest *>(data));
     GError *error = nullptr;
     QString message;
 
     secret_service_unlock_finish((SecretService *)source, result, nullptr, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
@@ -467,7 +503,7 @@ static void onItemUnlockFinished(GObject *source, GAsyncResult *result, gpointer
         StateTracker::instance()->setError(StateTracker::ItemUnlockError, message);
     }
 
-    StateTracker::instance()->clearOperation(StateTracker::ItemUnlocking);
+    request->operation.end();
     StateTracker::instance()->setStatus(StateTracker::instance()->status() & (~StateTracker::State::ItemLocked) | StateTracker::State::ItemReady);
 }
 
@@ -477,55 +513,83 @@ void SecretItemProxy::unlock()
         return;
     }
 
-    StateTracker::instance()->setOperation(StateTracker::ItemUnlocking);
-    secret_service_unlock(m_secretServiceClient->service(), g_list_append(nullptr, m_secretItem.get()), nullptr, onItemUnlockFinished, this);
+    auto *request =
+        new ItemRequest{this, refItem(m_secretItem.get()), StateTracker::instance()->beginOperation(StateTracker::ItemUnlocking), m_readCanceller.ref()};
+    SecretServiceClient *client = m_secretServiceClient;
+    client->scheduleRequest(SecretServiceClient::InteractivePriority, [client, request](SecretServiceClient::RequestSlot slot) {
+        request->slot = std::move(slot);
+        request->latency.emplace("secret_service_unlock");
+        GListPtr items = GListPtr(g_list_append(nullptr, request->item.get()));
+        secret_service_unlock(client->service(), items.get(), request->cancellable.get(), onItemUnlockFinished, request);
+    });
 }
 
-static void onSetLabelFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onSetLabelFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
-    Q_UNUSED(inst);
+    std::unique_ptr<ItemRequest> request(static_cast<ItemRequest *>(data));
     GError *error = nullptr;
     QString message;
 
     secret_item_set_label_finish((SecretItem *)source, result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
-        StateTracker::instance()->clearOperation(StateTracker::ItemSavingLabel);
     } else {
         StateTracker::instance()->setError(StateTracker::ItemSaveError, message);
+        // Still not saved
+        request->operation.end();
+        StateTracker::instance()->setState(StateTracker::ItemNeedsSave);
     }
 }
 
-static void onSetAttributesFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onSetAttributesFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
-    Q_UNUSED(inst);
+    std::unique_ptr<ItemRequest> request(static_cast<ItemRequest *>(data));
     GError *error = nullptr;
     QString message;
 
     secret_item_set_attributes_finish((SecretItem *)source, result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
-        StateTracker::instance()->clearOperation(StateTracker::ItemSavingAttributes);
     } else {
         StateTracker::instance()->setError(StateTracker::ItemSaveError, message);
+        // Still not saved
+        request->operation.end();
+        StateTracker::instance()->setState(StateTracker::ItemNeedsSave);
     }
 }
 
-static void onSetSecretFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onSetSecretFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
-    Q_UNUSED(inst);
+    std::unique_ptr<ItemRequest> request(static_cast<ItemRequest *>(data));
     GError *error = nullptr;
     QString message;
 
     secret_item_set_secret_finish((SecretItem *)source, result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
-        StateTracker::instance()->clearOperation(StateTracker::ItemSavingSecret);
     } else {
         StateTracker::instance()->setError(StateTracker::ItemSaveError, message);
+        // Still not saved
+        request->operation.end();
+        StateTracker::instance()->setState(StateTracker::ItemNeedsSave);
     }
 }
 
@@ -535,12 +599,18 @@ void SecretItemProxy::save()
         return;
     }
 
-    secret_item_set_label(m_secretItem.get(), m_label.toUtf8().data(), nullptr, onSetLabelFinished, this);
-    StateTracker::instance()->setOperation(StateTracker::ItemSavingLabel);
+    auto *labelRequest =
+        new ItemRequest{this, refItem(m_secretItem.get()), StateTracker::instance()->beginOperation(StateTracker::ItemSavingLabel), m_canceller.ref()};
+    labelRequest->label = m_label.toUtf8();
+    m_secretServiceClient->scheduleRequest(SecretServiceClient::InteractivePriority, [labelRequest](SecretServiceClient::RequestSlot slot) {
+        labelRequest->slot = std::move(slot);
+        labelRequest->latency.emplace("secret_item_set_label");
+        secret_item_set_label(labelRequest->item.get(), labelRequest->label.constData(), labelRequest->cancellable.get(), onSetLabelFinished, labelRequest);
+    });
 
     // Only attributes of type org.qt.keychain can be saved
     if (m_attributes.contains(QStringLiteral("xdg:schema")) && m_attributes[QStringLiteral("xdg:schema")] == QStringLiteral("org.qt.keychain")) {
-        GHashTable *attributes = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+        GHashTablePtr attributes = GHashTablePtr(g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free));
         for (auto it = m_attributes.constBegin(); it != m_attributes.constEnd(); ++it) {
             QByteArray keyBytes = it.key().toUtf8();
             gchar *key = g_strdup(keyBytes.constData());
@@ -548,11 +618,24 @@ void SecretItemProxy::save()
             QByteArray valueBytes = it.value().toString().toUtf8();
             gchar *value = g_strdup(valueBytes.constData());
 
-            g_hash_table_insert(attributes, key, value);
+            g_hash_table_insert(attributes.get(), key, value);
         }
 
-        secret_item_set_attributes(m_secretItem.get(), SecretServiceClient::qtKeychainSchema(), attributes, nullptr, onSetAttributesFinished, this);
-        StateTracker::instance()->setOperation(StateTracker::ItemSavingAttributes);
+        auto *attributesRequest = new ItemRequest{this,
+                                                  refItem(m_secretItem.get()),
+                                                  StateTracker::instance()->beginOperation(StateTracker::ItemSavingAttributes),
+                                                  m_canceller.ref()};
+        attributesRequest->attributes = std::move(attributes);
+        m_secretServiceClient->scheduleRequest(SecretServiceClient::InteractivePriority, [attributesRequest](SecretServiceClient::RequestSlot slot) {
+            attributesRequest->slot = std::move(slot);
+            attributesRequest->latency.emplace("secret_item_set_attributes");
+            secret_item_set_attributes(attributesRequest->item.get(),
+                                       SecretServiceClient::qtKeychainSchema(),
+                                       attributesRequest->attributes.get(),
+                                       attributesRequest->cancellable.get(),
+                                       onSetAttributesFinished,
+                                       attributesRequest);
+        });
 
         SecretValuePtr secretValue;
         if (m_type == SecretServiceClient::Base64) {
@@ -563,8 +646,16 @@ void SecretItemProxy::save()
 
         // Saving binary secrets not supported yet
         if (m_type != SecretServiceClient::Binary) {
-            secret_item_set_secret(m_secretItem.get(), secretValue.get(), nullptr, onSetSecretFinished, this);
-            StateTracker::instance()->setOperation(StateTracker::ItemSavingSecret);
+            auto *secretRequest = new ItemRequest{this,
+                                                  refItem(m_secretItem.get()),
+                                                  StateTracker::instance()->beginOperation(StateTracker::ItemSavingSecret),
+                                                  m_canceller.ref()};
+            secretRequest->secretValue = std::move(secretValue);
+            m_secretServiceClient->scheduleRequest(SecretServiceClient::InteractivePriority, [secretRequest](SecretServiceClient::RequestSlot slot) {
+                secretRequest->slot = std::move(slot);
+                secretRequest->latency.emplace("secret_item_set_secret");
+                secret_item_set_secret(secretRequest->item.get(), secretRequest->secretValue.get(), secretRequest->cancellable.get(), onSetSecretFinished, secretRequest);
+            });
         }
     }
 }
@@ -591,6 +682,7 @@ void SecretItemProxy::close()
     m_folder = QString();
     m_attributes.clear();
 
+    m_readCanceller.cancel();
     m_secretItem.reset();
 
     Q_EMIT creationTimeChanged(m_creationTime);
@@ -607,21 +699,27 @@ void SecretItemProxy::close()
                                         & ~(StateTracker::ItemReady | StateTracker::ItemLocked | StateTracker::ItemNeedsSave));
 }
 
-static void onDeleteFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onDeleteFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
+    std::unique_ptr<ItemRequest> request(static_cast<ItemRequest *>(data));
     GError *error = nullptr;
     QString message;
-    SecretItemProxy *proxy = (SecretItemProxy *)inst;
 
     secret_item_delete_finish((SecretItem *)source, result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
     } else {
         StateTracker::instance()->setError(StateTracker::ItemDeleteError, message);
     }
-    proxy->close();
-    StateTracker::instance()->clearOperation(StateTracker::ItemDeleting);
+    if (request->proxy) {
+        request->proxy->close();
+    }
 }
 
 void SecretItemProxy::deleteItem()
@@ -630,8 +728,13 @@ void SecretItemProxy::deleteItem()
         return;
     }
 
-    StateTracker::instance()->setOperation(StateTracker::ItemDeleting);
-    secret_item_delete(m_secretItem.get(), nullptr, onDeleteFinished, this);
+    auto *request =
+        new ItemRequest{this, refItem(m_secretItem.get()), StateTracker::instance()->beginOperation(StateTracker::ItemDeleting), m_canceller.ref()};
+    m_secretServiceClient->scheduleRequest(SecretServiceClient::InteractivePriority, [request](SecretServiceClient::RequestSlot slot) {
+        request->slot = std::move(slot);
+        request->latency.emplace("secret_item_delete");
+        secret_item_delete(request->item.get(), request->cancellable.get(), onDeleteFinished, request);
+    });
 }
 
 SecretItem *SecretItemProxy::secretItem() const
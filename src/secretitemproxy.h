@@ -5,7 +5,6 @@
 
 #include "secretserviceclient.h"
 #include <QDateTime>
-#include <QTimer>
 #include <QObject>
 #include <qqmlregistration.h>
 #include <chrono>
@@ -56,6 +55,9 @@ public:
     std::chrono::seconds clipboardClearTimeout() const;
     void setClipboardClearTimeout(std::chrono::seconds seconds);
     Q_INVOKABLE QByteArray generatePassword(int length, bool includeLower, bool includeUpper, bool includeDigits, bool includeSymbols) const;
+    // Generates count passwords at once, see PasswordGenerator::Options::fromVariantMap for the options.
+    // Each entry of the returned list is a map with "password" and "entropy" (in bits)
+    Q_INVOKABLE QVariantList generatePasswords(int count, const QVariantMap &options) const;
 
     SecretServiceClient::Type type() const;
 
@@ -92,7 +94,6 @@ Q_SIGNALS:
     void clipboardCleared();
 
 private:
-    void clearClipboard();
     QString m_dbusPath;
     QString m_collectionPath;
     SecretServiceClient::Type m_type = SecretServiceClient::Unknown;
@@ -104,10 +105,14 @@ private:
     QString m_label;
     QByteArray m_secretValue;
     QVariantMap m_attributes;
-    QTimer *m_clipboardTimer = nullptr;
     std::chrono::seconds m_clipboardClearTimeout = std::chrono::seconds(30);
-    int m_clipboardSecondsRemaining = 0;
+    // Identifies our last copy in ClipboardManager
+    QByteArray m_clipboardToken;
 
     SecretItemPtr m_secretItem;
     SecretServiceClient *const m_secretServiceClient;
+    // Loading the secret and unlocking, cancelled when another item is loaded or on close()
+    RequestCanceller m_readCanceller;
+    // Creating, saving and deleting, cancelled only with the proxy
+    RequestCanceller m_canceller;
 };
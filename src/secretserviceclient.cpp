@@ -6,7 +6,9 @@
 
 #include "secretserviceclient.h"
 #include "keepsecret_debug.h"
+#include "latencystats.h"
 #include "statetracker.h"
+#include "tracing.h"
 
 #include <KConfig>
 #include <KLocalizedString>
@@ -16,6 +18,72 @@
 #include <QDBusServiceWatcher>
 #include <QTimer>
 #include <memory>
+#include <optional>
+#include <utility>
+
+// How many requests of each priority can be in flight at once
+static constexpr std::array<int, SecretServiceClient::RequestPriorityCount> s_requestSlots = {
+    4, // InteractivePriority
+    8, // BackgroundPriority
+};
+// While requests of the user are in flight fewer background ones are started,
+// so that the provider doesn't have many of them to go through first
+static constexpr int s_backgroundSlotsWhileInteractive = 2;
+
+SecretServiceClient::RequestSlot::RequestSlot(SecretServiceClient *client, RequestPriority priority)
+    : m_client(client)
+    , m_priority(priority)
+{
+}
+
+SecretServiceClient::RequestSlot::RequestSlot(RequestSlot &&other) noexcept
+    : m_client(std::exchange(other.m_client, nullptr))
+    , m_priority(other.m_priority)
+{
+}
+
+SecretServiceClient::RequestSlot &SecretServiceClient::RequestSlot::operator=(RequestSlot &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_client = std::exchange(other.m_client, nullptr);
+        m_priority = other.m_priority;
+    }
+    return *this;
+}
+
+SecretServiceClient::RequestSlot::~RequestSlot()
+{
+    release();
+}
+
+void SecretServiceClient::RequestSlot::release()
+{
+    if (m_client) {
+        std::exchange(m_client, nullptr)->releaseRequestSlot(m_priority);
+    }
+}
+
+RequestCanceller::RequestCanceller()
+    : m_cancellable(g_cancellable_new())
+{
+}
+
+RequestCanceller::~RequestCanceller()
+{
+    g_cancellable_cancel(m_cancellable.get());
+}
+
+GCancellablePtr RequestCanceller::ref() const
+{
+    return GCancellablePtr(G_CANCELLABLE(g_object_ref(m_cancellable.get())));
+}
+
+void RequestCanceller::cancel()
+{
+    g_cancellable_cancel(m_cancellable.get());
+    m_cancellable.reset(g_cancellable_new());
+}
 
 SecretServiceClient::SecretServiceClient(QObject *parent)
     : QObject(parent)
@@ -87,6 +155,55 @@ bool SecretServiceClient::wasErrorFree(GError **error, QString &message)
     return false;
 }
 
+bool SecretServiceClient::wasCancelled(GError **error)
+{
+    if (!g_error_matches(*error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+        return false;
+    }
+    g_clear_error(error);
+    return true;
+}
+
+void SecretServiceClient::scheduleRequest(RequestPriority priority, const RequestStarter &start)
+{
+    m_queuedRequests[priority].append(start);
+    startQueuedRequests();
+}
+
+void SecretServiceClient::releaseRequestSlot(RequestPriority priority)
+{
+    --m_requestsInFlight[priority];
+    startQueuedRequests();
+}
+
+void SecretServiceClient::startQueuedRequests()
+{
+    // A request may be started and release its slot right away: the loop below picks up from there
+    if (m_startingRequests) {
+        return;
+    }
+    m_startingRequests = true;
+
+    for (int priority = InteractivePriority; priority < RequestPriorityCount; ++priority) {
+        QList<RequestStarter> &queue = m_queuedRequests[priority];
+        int slots = s_requestSlots[priority];
+        if (priority == BackgroundPriority && m_requestsInFlight[InteractivePriority] > 0) {
+            slots = s_backgroundSlotsWhileInteractive;
+        }
+        while (!queue.isEmpty() && m_requestsInFlight[priority] < slots) {
+            const RequestStarter start = queue.takeFirst();
+            ++m_requestsInFlight[priority];
+            start(RequestSlot(this, RequestPriority(priority)));
+        }
+        // Lower priorities wait until nothing more urgent is queued
+        if (!queue.isEmpty()) {
+            break;
+        }
+    }
+
+    m_startingRequests = false;
+}
+
 QString SecretServiceClient::typeToString(SecretServiceClient::Type type)
 {
     // Similar to QtKeychain implementation: adds the "map" datatype
@@ -179,14 +296,44 @@ SecretItemPtr SecretServiceClient::retrieveItem(const QString &itemPath, const Q
     return nullptr;
 }
 
-static void onServiceGetFinished(GObject *source, GAsyncResult *result, gpointer inst)
+// Data of the callbacks of the requests on the service and its collections:
+// ends the operation and frees the request slot when deleted
+struct ClientRequest {
+    SecretServiceClient *client;
+    StateTracker::OperationHandle operation;
+    GCancellablePtr cancellable;
+    SecretCollectionPtr collection;
+    SecretServiceClient::RequestSlot slot;
+    // Started with the libsecret call, not counting the time in the queue
+    std::optional<LatencyTimer> latency;
+};
+
+// False if the request was cancelled while waiting for its slot, as the
+// service it was for may be gone: the request is deleted right away
+static bool startClientRequest(ClientRequest *request, SecretServiceClient::RequestSlot slot)
+{
+    if (g_cancellable_is_cancelled(request->cancellable.get())) {
+        delete request;
+        return false;
+    }
+    request->slot = std::move(slot);
+    return true;
+}
+
+static void onServiceGetFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
     Q_UNUSED(source);
+    std::unique_ptr<ClientRequest> request(static_cast<ClientRequest *>(data));
     GError *error = nullptr;
     QString message;
-    SecretServiceClient *client = (SecretServiceClient *)inst;
+    SecretServiceClient *client = request->client;
 
     SecretService *service = secret_service_get_finish(result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
@@ -202,7 +349,6 @@ void SecretServiceClient::attemptConnectionFinished(SecretService *service)
     m_service.reset(service);
     if (service) {
         StateTracker::instance()->setState(StateTracker::ServiceConnected);
-        StateTracker::instance()->clearOperation(StateTracker::ServiceConnecting);
         readDefaultCollection();
     } else {
         // Use setStatus as it will reset any other state
@@ -216,12 +362,13 @@ void SecretServiceClient::attemptConnection()
         return;
     }
 
-    StateTracker::instance()->setOperation(StateTracker::ServiceConnecting);
+    auto *request = new ClientRequest{this, StateTracker::instance()->beginOperation(StateTracker::ServiceConnecting), m_canceller.ref()};
 
     // Since glib/libsecret doesn't have something like QFlags, this line
     // will always do a warning
+    request->latency.emplace("secret_service_get");
     // clang-format off
-    secret_service_get(static_cast<SecretServiceFlags>(SECRET_SERVICE_OPEN_SESSION | SECRET_SERVICE_LOAD_COLLECTIONS), nullptr, onServiceGetFinished, this); // NOLINT
+    secret_service_get(static_cast<SecretServiceFlags>(SECRET_SERVICE_OPEN_SESSION | SECRET_SERVICE_LOAD_COLLECTIONS), request->cancellable.get(), onServiceGetFinished, request); // NOLINT
     // clang-format on
 }
 
@@ -229,10 +376,13 @@ void SecretServiceClient::onServiceOwnerChanged(const QString &serviceName, cons
 {
     Q_UNUSED(serviceName);
     Q_UNUSED(oldOwner);
+    Tracing::instant("NameOwnerChanged", "dbus");
 
     bool available = !newOwner.isEmpty();
 
     StateTracker::instance()->setStatus(StateTracker::ServiceDisconnected);
+    // Nothing pending on the old service is relevant anymore
+    m_canceller.cancel();
     m_service.reset();
 
     qCWarning(KEEPSECRET_LOG) << "Secret Service availability changed:" << (available ? "Available" : "Unavailable");
@@ -248,6 +398,7 @@ void SecretServiceClient::onServiceOwnerChanged(const QString &serviceName, cons
 
 void SecretServiceClient::onCollectionCreated(const QDBusObjectPath &path)
 {
+    Tracing::instant("CollectionCreated", "dbus");
     const QString label = collectionLabelForPath(path);
     if (label.isEmpty()) {
         return;
@@ -263,6 +414,7 @@ void SecretServiceClient::onCollectionCreated(const QDBusObjectPath &path)
 
 void SecretServiceClient::onCollectionDeleted(const QDBusObjectPath &path)
 {
+    Tracing::instant("CollectionDeleted", "dbus");
     Q_UNUSED(path);
     if (!StateTracker::instance()->isServiceConnected()) {
         return;
@@ -276,6 +428,7 @@ void SecretServiceClient::onPropertiesChanged(const QString &interface, const QV
 {
     Q_UNUSED(changedProperties);
     Q_UNUSED(invalidatedProperties)
+    Tracing::instant("PropertiesChanged", "dbus");
 
     if (interface == QStringLiteral("org.freedesktop.Secret.Service")) {
         readDefaultCollection();
@@ -344,20 +497,26 @@ void SecretServiceClient::readDefaultCollection()
     });
 }
 
-static void onSetDefaultCollectionFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onSetDefaultCollectionFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
+    std::unique_ptr<ClientRequest> request(static_cast<ClientRequest *>(data));
     GError *error = nullptr;
     QString message;
-    SecretServiceClient *client = (SecretServiceClient *)inst;
+    SecretServiceClient *client = request->client;
 
     secret_service_set_alias_finish((SecretService *)source, result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
     } else {
         StateTracker::instance()->setError(StateTracker::CollectionWriteDefaultError, message);
     }
-    StateTracker::instance()->clearOperation(StateTracker::CollectionWritingDefault);
+    request->operation.end();
     client->readDefaultCollection();
 }
 
@@ -367,10 +526,17 @@ void SecretServiceClient::setDefaultCollection(const QString &collectionPath)
         return;
     }
 
-    SecretCollection *collection = retrieveCollection(collectionPath);
-
-    StateTracker::instance()->setOperation(StateTracker::CollectionWritingDefault);
-    secret_service_set_alias(m_service.get(), "default", collection, nullptr, onSetDefaultCollectionFinished, this);
+    auto *request = new ClientRequest{this,
+                                      StateTracker::instance()->beginOperation(StateTracker::CollectionWritingDefault),
+                                      m_canceller.ref(),
+                                      SecretCollectionPtr(retrieveCollection(collectionPath))};
+    scheduleRequest(InteractivePriority, [this, request](RequestSlot slot) {
+        if (!startClientRequest(request, std::move(slot))) {
+            return;
+        }
+        request->latency.emplace("secret_service_set_alias");
+        secret_service_set_alias(m_service.get(), "default", request->collection.get(), request->cancellable.get(), onSetDefaultCollectionFinished, request);
+    });
 }
 
 QList<SecretServiceClient::CollectionEntry> SecretServiceClient::listCollections()
@@ -405,13 +571,19 @@ QList<SecretServiceClient::CollectionEntry> SecretServiceClient::listCollections
     return collections;
 }
 
-static void onLoadCollectionsFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onLoadCollectionsFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
+    std::unique_ptr<ClientRequest> request(static_cast<ClientRequest *>(data));
     GError *error = nullptr;
     QString message;
-    SecretServiceClient *client = (SecretServiceClient *)inst;
+    SecretServiceClient *client = request->client;
 
     secret_service_load_collections_finish((SecretService *)source, result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
@@ -419,7 +591,7 @@ static void onLoadCollectionsFinished(GObject *source, GAsyncResult *result, gpo
         StateTracker::instance()->setError(StateTracker::ServiceLoadCollectionsError, message);
     }
 
-    StateTracker::instance()->clearOperation(StateTracker::ServiceLoadingCollections);
+    request->operation.end();
     Q_EMIT client->collectionListDirty();
 }
 
@@ -429,18 +601,30 @@ void SecretServiceClient::loadCollections()
         return;
     }
 
-    StateTracker::instance()->setOperation(StateTracker::ServiceLoadingCollections);
-    secret_service_load_collections(m_service.get(), nullptr, onLoadCollectionsFinished, this);
+    auto *request = new ClientRequest{this, StateTracker::instance()->beginOperation(StateTracker::ServiceLoadingCollections), m_canceller.ref()};
+    scheduleRequest(InteractivePriority, [this, request](RequestSlot slot) {
+        if (!startClientRequest(request, std::move(slot))) {
+            return;
+        }
+        request->latency.emplace("secret_service_load_collections");
+        secret_service_load_collections(m_service.get(), request->cancellable.get(), onLoadCollectionsFinished, request);
+    });
 }
 
-static void onLockCollectionFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onLockCollectionFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
+    std::unique_ptr<ClientRequest> request(static_cast<ClientRequest *>(data));
     GError *error = nullptr;
     QString message;
-    SecretServiceClient *client = (SecretServiceClient *)inst;
+    SecretServiceClient *client = request->client;
     GList *locked = nullptr;
 
     secret_service_lock_finish((SecretService *)source, result, &locked, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     QString path;
     // FIXME: can there me more than one unlocked at once?
@@ -451,7 +635,7 @@ static void onLockCollectionFinished(GObject *source, GAsyncResult *result, gpoi
     }
     g_list_free(locked);
 
-    StateTracker::instance()->clearOperation(StateTracker::CollectionLocking);
+    request->operation.end();
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
         client->loadCollections();
@@ -475,18 +659,32 @@ void SecretServiceClient::lockCollection(const QString &collectionPath)
         return;
     }
 
-    StateTracker::instance()->setOperation(StateTracker::CollectionLocking);
-    secret_service_lock(m_service.get(), g_list_append(nullptr, collection.get()), nullptr, onLockCollectionFinished, this);
+    auto *request =
+        new ClientRequest{this, StateTracker::instance()->beginOperation(StateTracker::CollectionLocking), m_canceller.ref(), std::move(collection)};
+    scheduleRequest(InteractivePriority, [this, request](RequestSlot slot) {
+        if (!startClientRequest(request, std::move(slot))) {
+            return;
+        }
+        request->latency.emplace("secret_service_lock");
+        GListPtr collections = GListPtr(g_list_append(nullptr, request->collection.get()));
+        secret_service_lock(m_service.get(), collections.get(), request->cancellable.get(), onLockCollectionFinished, request);
+    });
 }
 
-static void onUnlockCollectionFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onUnlockCollectionFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
+    std::unique_ptr<ClientRequest> request(static_cast<ClientRequest *>(data));
     GError *error = nullptr;
     QString message;
-    SecretServiceClient *client = (SecretServiceClient *)inst;
+    SecretServiceClient *client = request->client;
     GList *unlocked = nullptr;
 
     secret_service_unlock_finish((SecretService *)source, result, &unlocked, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     QString path;
     // FIXME: can there me more than one unlocked at once?
@@ -497,7 +695,7 @@ static void onUnlockCollectionFinished(GObject *source, GAsyncResult *result, gp
     }
     g_list_free(unlocked);
 
-    StateTracker::instance()->clearOperation(StateTracker::CollectionUnlocking);
+    request->operation.end();
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
         client->loadCollections();
@@ -521,25 +719,39 @@ void SecretServiceClient::unlockCollection(const QString &collectionPath)
         return;
     }
 
-    StateTracker::instance()->setOperation(StateTracker::CollectionUnlocking);
-    secret_service_unlock(m_service.get(), g_list_append(nullptr, collection.get()), nullptr, onUnlockCollectionFinished, this);
+    auto *request =
+        new ClientRequest{this, StateTracker::instance()->beginOperation(StateTracker::CollectionUnlocking), m_canceller.ref(), std::move(collection)};
+    scheduleRequest(InteractivePriority, [this, request](RequestSlot slot) {
+        if (!startClientRequest(request, std::move(slot))) {
+            return;
+        }
+        request->latency.emplace("secret_service_unlock");
+        GListPtr collections = GListPtr(g_list_append(nullptr, request->collection.get()));
+        secret_service_unlock(m_service.get(), collections.get(), request->cancellable.get(), onUnlockCollectionFinished, request);
+    });
 }
 
-static void onCreateCollectionFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onCreateCollectionFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
     Q_UNUSED(source);
+    std::unique_ptr<ClientRequest> request(static_cast<ClientRequest *>(data));
     GError *error = nullptr;
     QString message;
-    SecretServiceClient *client = (SecretServiceClient *)inst;
+    SecretServiceClient *client = request->client;
 
     secret_collection_create_finish(result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
     } else {
         StateTracker::instance()->setError(StateTracker::CollectionCreationError, message);
     }
-    StateTracker::instance()->clearOperation(StateTracker::CollectionCreating);
+    request->operation.end();
     client->readDefaultCollection();
     client->loadCollections();
 }
@@ -550,30 +762,42 @@ void SecretServiceClient::createCollection(const QString &collectionName)
         return;
     }
 
-    StateTracker::instance()->setOperation(StateTracker::CollectionCreating);
-    secret_collection_create(m_service.get(),
-                             collectionName.toUtf8().data(),
-                             nullptr,
-                             SECRET_COLLECTION_CREATE_NONE,
-                             nullptr,
-                             onCreateCollectionFinished,
-                             this);
+    auto *request = new ClientRequest{this, StateTracker::instance()->beginOperation(StateTracker::CollectionCreating), m_canceller.ref()};
+    scheduleRequest(InteractivePriority, [this, request, collectionName](RequestSlot slot) {
+        if (!startClientRequest(request, std::move(slot))) {
+            return;
+        }
+        request->latency.emplace("secret_collection_create");
+        secret_collection_create(m_service.get(),
+                                 collectionName.toUtf8().data(),
+                                 nullptr,
+                                 SECRET_COLLECTION_CREATE_NONE,
+                                 request->cancellable.get(),
+                                 onCreateCollectionFinished,
+                                 request);
+    });
 }
 
-static void onDeleteCollectionFinished(GObject *source, GAsyncResult *result, gpointer inst)
+static void onDeleteCollectionFinished(GObject *source, GAsyncResult *result, gpointer data)
 {
+    std::unique_ptr<ClientRequest> request(static_cast<ClientRequest *>(data));
     GError *error = nullptr;
     QString message;
-    SecretServiceClient *client = (SecretServiceClient *)inst;
+    SecretServiceClient *client = request->client;
 
     secret_collection_delete_finish((SecretCollection *)source, result, &error);
+    request->latency.reset();
+
+    if (SecretServiceClient::wasCancelled(&error)) {
+        return;
+    }
 
     if (SecretServiceClient::wasErrorFree(&error, message)) {
         StateTracker::instance()->clearError();
     } else {
         StateTracker::instance()->setError(StateTracker::CollectionDeleteError, message);
     }
-    StateTracker::instance()->clearOperation(StateTracker::CollectionDeleting);
+    request->operation.end();
     client->readDefaultCollection();
 }
 
@@ -583,10 +807,20 @@ void SecretServiceClient::deleteCollection(const QString &collectionPath)
         return;
     }
 
-    SecretCollection *collection = retrieveCollection(collectionPath);
+    SecretCollectionPtr collection(retrieveCollection(collectionPath));
+    if (!collection) {
+        return;
+    }
 
-    StateTracker::instance()->setOperation(StateTracker::CollectionDeleting);
-    secret_collection_delete(collection, nullptr, onDeleteCollectionFinished, this);
+    auto *request =
+        new ClientRequest{this, StateTracker::instance()->beginOperation(StateTracker::CollectionDeleting), m_canceller.ref(), std::move(collection)};
+    scheduleRequest(InteractivePriority, [request](RequestSlot slot) {
+        if (!startClientRequest(request, std::move(slot))) {
+            return;
+        }
+        request->latency.emplace("secret_collection_delete");
+        secret_collection_delete(request->collection.get(), request->cancellable.get(), onDeleteCollectionFinished, request);
+    });
 }
 
 #include <moc_secretserviceclient.cpp>
@@ -8,8 +8,11 @@
 
 #include <QDBusObjectPath>
 #include <QObject>
+#include <QPointer>
 #include <QQmlEngine>
 
+#include <array>
+#include <functional>
 #include <libsecret/secret.h>
 #include <memory>
 
@@ -61,6 +64,26 @@ using SecretItemPtr = GObjectPtr<SecretItem>;
 using GHashTablePtr = std::unique_ptr<GHashTable, GHashTableDeleter>;
 using GListPtr = std::unique_ptr<GList, GListDeleter>;
 using SecretValuePtr = std::unique_ptr<SecretValue, SecretValueDeleter>;
+using GCancellablePtr = GObjectPtr<GCancellable>;
+
+/**
+ * The cancellable of all the requests of an object, which cancels them when
+ * destroyed or on cancel(). Requests keep their own reference with ref(), as
+ * they may outlive it; the requests made after cancel() get a new cancellable.
+ */
+class RequestCanceller
+{
+public:
+    RequestCanceller();
+    ~RequestCanceller();
+    Q_DISABLE_COPY_MOVE(RequestCanceller)
+
+    GCancellablePtr ref() const;
+    void cancel();
+
+private:
+    GCancellablePtr m_cancellable;
+};
 
 class SecretServiceClient : public QObject
 {
@@ -86,11 +109,54 @@ public:
         bool locked;
     };
 
+    enum RequestPriority {
+        // Started by the user, who waits for them
+        InteractivePriority = 0,
+        // Bulk work: imports, deleting many items, backups
+        BackgroundPriority,
+        RequestPriorityCount
+    };
+    Q_ENUM(RequestPriority)
+
+    /**
+     * A request slot taken by scheduleRequest(), freed when the slot is destroyed:
+     * keep it until the request is done, usually in the data of its callback.
+     */
+    class RequestSlot
+    {
+    public:
+        RequestSlot() = default;
+        RequestSlot(RequestSlot &&other) noexcept;
+        RequestSlot &operator=(RequestSlot &&other) noexcept;
+        ~RequestSlot();
+
+        void release();
+
+    private:
+        friend class SecretServiceClient;
+        RequestSlot(SecretServiceClient *client, RequestPriority priority);
+
+        QPointer<SecretServiceClient> m_client;
+        RequestPriority m_priority = InteractivePriority;
+    };
+    using RequestStarter = std::function<void(RequestSlot slot)>;
+
     explicit SecretServiceClient(QObject *parent = nullptr);
 
     static const SecretSchema *qtKeychainSchema(void);
 
     static bool wasErrorFree(GError **error, QString &message);
+    // If the request was cancelled, frees the error: whoever made the request
+    // may be gone, so the callback should return without touching anything
+    static bool wasCancelled(GError **error);
+
+    // Calls start once a slot of the given priority is free, right away if possible.
+    // Each priority has a limited amount of requests in flight, and interactive
+    // requests are always started before the background ones waiting.
+    // While interactive requests are in flight only a couple of background
+    // ones are started, so that a request of the user never has to wait
+    // behind a long row of them at the provider
+    void scheduleRequest(RequestPriority priority, const RequestStarter &start);
 
     SecretService *service() const;
 
@@ -145,9 +211,18 @@ protected Q_SLOTS:
     void onPropertiesChanged(const QString &interface, const QVariantMap &changedProperties, const QStringList &invalidatedProperties);
 
 private:
+    void releaseRequestSlot(RequestPriority priority);
+    void startQueuedRequests();
+
+    std::array<QList<RequestStarter>, RequestPriorityCount> m_queuedRequests;
+    std::array<int, RequestPriorityCount> m_requestsInFlight = {};
+    bool m_startingRequests = false;
+
     SecretServicePtr m_service;
     QString m_serviceBusName;
     QDBusServiceWatcher *m_serviceWatcher;
+    // Cancelled when the service goes away
+    RequestCanceller m_canceller;
 
     QString m_defaultCollection;
 };
@@ -3,10 +3,15 @@
 
 #include "statetracker.h"
 #include "keepsecret_debug.h"
+#include "latencystats.h"
+#include "tracing.h"
 
 #include <KLocalizedString>
+#include <QDateTime>
+#include <QMetaEnum>
 #include <cstdlib>
 #include <memory>
+#include <utility>
 
 class StateTrackerSingleton
 {
@@ -72,13 +77,103 @@ bool StateTracker::isServiceConnected() const
     return m_status & ServiceConnected;
 }
 
+StateTracker::OperationHandle::OperationHandle(quint64 id)
+    : m_id(id)
+{
+}
+
+StateTracker::OperationHandle::OperationHandle(OperationHandle &&other) noexcept
+    : m_id(std::exchange(other.m_id, 0))
+{
+}
+
+StateTracker::OperationHandle &StateTracker::OperationHandle::operator=(OperationHandle &&other) noexcept
+{
+    if (this != &other) {
+        end();
+        m_id = std::exchange(other.m_id, 0);
+    }
+    return *this;
+}
+
+StateTracker::OperationHandle::~OperationHandle()
+{
+    end();
+}
+
+quint64 StateTracker::OperationHandle::id() const
+{
+    return m_id;
+}
+
+bool StateTracker::OperationHandle::isRunning() const
+{
+    return m_id != 0;
+}
+
+void StateTracker::OperationHandle::end()
+{
+    // Handles may outlive the tracker at exit
+    if (m_id != 0 && !s_stateTracker.isDestroyed()) {
+        StateTracker::instance()->endOperation(m_id);
+    }
+    m_id = 0;
+}
+
 StateTracker::Operations StateTracker::operations() const
 {
     return m_operations;
 }
 
-void StateTracker::setOperations(StateTracker::Operations operations)
+bool StateTracker::isBusy() const
+{
+    return !m_runningOperations.isEmpty();
+}
+
+StateTracker::OperationHandle StateTracker::beginOperation(StateTracker::Operation operation)
+{
+    return OperationHandle(startOperation(operation));
+}
+
+QList<StateTracker::RunningOperation> StateTracker::runningOperations() const
+{
+    return m_runningOperations;
+}
+
+quint64 StateTracker::startOperation(StateTracker::Operation operation)
 {
+    const quint64 id = m_nextOperationId++;
+    QElapsedTimer timer;
+    timer.start();
+    m_runningOperations.append({id, operation, QDateTime::currentMSecsSinceEpoch(), timer});
+    Tracing::asyncBegin(QMetaEnum::fromType<Operation>().valueToKey(operation), "libsecret", id);
+    updateOperations();
+    return id;
+}
+
+void StateTracker::endOperation(quint64 id)
+{
+    for (auto it = m_runningOperations.begin(); it != m_runningOperations.end(); ++it) {
+        if (it->id == id) {
+            const char *name = QMetaEnum::fromType<Operation>().valueToKey(it->type);
+            Tracing::asyncEnd(name, "libsecret", id);
+            if (LatencyStats *stats = LatencyStats::instance()) {
+                stats->record(QString::fromLatin1(name), std::chrono::nanoseconds(it->timer.nsecsElapsed()));
+            }
+            m_runningOperations.erase(it);
+            updateOperations();
+            return;
+        }
+    }
+}
+
+void StateTracker::updateOperations()
+{
+    Operations operations = OperationNone;
+    for (const RunningOperation &operation : std::as_const(m_runningOperations)) {
+        operations |= operation.type;
+    }
+
     if (operations == m_operations) {
         return;
     }
@@ -98,20 +193,17 @@ void StateTracker::setOperations(StateTracker::Operations operations)
 
 void StateTracker::setOperation(StateTracker::Operation operation)
 {
-    setOperations(m_operations | operation);
+    startOperation(operation);
 }
 
 void StateTracker::clearOperation(StateTracker::Operation operation)
 {
-    // Keep the Loading or Saving flags if we still have another load/save operation
-    Operations result = m_operations & ~operation;
-    if (result & (ItemSavingLabel | ItemSavingSecret | ItemSavingAttributes)) {
-        result |= ItemSaving;
-    }
-    if (result & (ItemLoadingSecret | ItemUnlocking)) {
-        result |= ItemLoading;
+    for (const RunningOperation &running : std::as_const(m_runningOperations)) {
+        if (running.type == operation) {
+            endOperation(running.id);
+            return;
+        }
     }
-    setOperations(result);
 }
 
 QString StateTracker::operationsReadableName() const
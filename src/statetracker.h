@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <QElapsedTimer>
+#include <QList>
 #include <QObject>
 #include <qqmlregistration.h>
 
@@ -14,6 +16,8 @@ class StateTracker : public QObject
 
     Q_PROPERTY(Status status READ status NOTIFY statusChanged)
     Q_PROPERTY(Operations operations READ operations NOTIFY operationsChanged)
+    // True while any operation is running
+    Q_PROPERTY(bool busy READ isBusy NOTIFY operationsChanged)
     Q_PROPERTY(QString operationsReadableName READ operationsReadableName NOTIFY operationsReadableNameChanged)
     Q_PROPERTY(Error error READ error NOTIFY errorChanged)
     Q_PROPERTY(QString errorMessage READ errorMessage NOTIFY errorChanged)
@@ -90,6 +94,39 @@ public:
     };
     Q_ENUM(Error);
 
+    struct RunningOperation {
+        quint64 id;
+        Operation type;
+        // Milliseconds since the epoch
+        qint64 startedAt;
+        // For LatencyStats
+        QElapsedTimer timer;
+    };
+
+    /**
+     * A running operation, ended when the handle is destroyed or end() is called.
+     * Any number of operations, of the same type too, can run at once: their type
+     * is in operations() until the last of them has ended.
+     * Handles can be moved, for instance in the data of an async libsecret call.
+     */
+    class OperationHandle
+    {
+    public:
+        OperationHandle() = default;
+        OperationHandle(OperationHandle &&other) noexcept;
+        OperationHandle &operator=(OperationHandle &&other) noexcept;
+        ~OperationHandle();
+
+        quint64 id() const;
+        bool isRunning() const;
+        void end();
+
+    private:
+        friend class StateTracker;
+        explicit OperationHandle(quint64 id);
+        quint64 m_id = 0;
+    };
+
     explicit StateTracker(QObject *parent = nullptr);
     ~StateTracker() override;
 
@@ -103,7 +140,11 @@ public:
     bool isServiceConnected() const;
 
     Operations operations() const;
-    void setOperations(Operations operations);
+    bool isBusy() const;
+    [[nodiscard]] OperationHandle beginOperation(Operation operation);
+    QList<RunningOperation> runningOperations() const;
+    // Without a handle: every setOperation() has to be matched by a clearOperation(),
+    // which ends the oldest running operation of that type
     void setOperation(Operation operation);
     void clearOperation(Operation operation);
     QString operationsReadableName() const;
@@ -121,8 +162,15 @@ Q_SIGNALS:
     void errorChanged(Error error, const QString &errorMessage);
 
 private:
+    quint64 startOperation(Operation operation);
+    void endOperation(quint64 id);
+    void updateOperations();
+
     Status m_status = ServiceDisconnected;
+    // Union of the types of m_runningOperations
     Operations m_operations = OperationNone;
+    QList<RunningOperation> m_runningOperations;
+    quint64 m_nextOperationId = 1;
     Error m_error = NoError;
     QString m_errorMessage;
 };
@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "tracing.h"
+#include "keepsecret_debug.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
+#include <array>
+#include <list>
+#include <memory>
+
+namespace Tracing
+{
+namespace Private
+{
+std::atomic_bool enabled = false;
+}
+
+namespace
+{
+// Events are stored in chunks which are never moved: the thread owning
+// the buffer publishes each event by increasing count, finish() reads
+// only up to count, so neither side ever needs a lock
+struct Chunk {
+    static constexpr int s_size = 4096;
+    std::array<Private::Event, s_size> events;
+    std::atomic_int count = 0;
+    std::atomic<Chunk *> next = nullptr;
+};
+
+struct ThreadBuffer {
+    ThreadBuffer(quint64 threadId, const QString &threadName)
+        : threadId(threadId)
+        , threadName(threadName)
+        , head(std::make_unique<Chunk>())
+        , tail(head.get())
+    {
+    }
+    ~ThreadBuffer()
+    {
+        Chunk *chunk = head.release();
+        while (chunk) {
+            Chunk *next = chunk->next.load();
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    void append(const Private::Event &event)
+    {
+        int count = tail->count.load(std::memory_order_relaxed);
+        if (count == Chunk::s_size) {
+            Chunk *chunk = new Chunk;
+            tail->next.store(chunk, std::memory_order_release);
+            tail = chunk;
+            count = 0;
+        }
+        tail->events[count] = event;
+        tail->count.store(count + 1, std::memory_order_release);
+    }
+
+    const quint64 threadId;
+    const QString threadName;
+    std::unique_ptr<Chunk> head;
+    // Only used by the owning thread
+    Chunk *tail;
+};
+
+struct TraceState {
+    QElapsedTimer clock;
+    QString filePath;
+
+    // Only to register new threads and intern names, not for the events
+    QMutex mutex;
+    // Never freed before the end of the program, threads may still be running in finish()
+    std::list<ThreadBuffer> buffers;
+    QSet<QByteArray> names;
+    quint64 nextThreadId = 1;
+};
+
+TraceState &state()
+{
+    static TraceState s_state;
+    return s_state;
+}
+
+ThreadBuffer *registerThread()
+{
+    TraceState &trace = state();
+    QMutexLocker locker(&trace.mutex);
+
+    QString name = QThread::currentThread()->objectName();
+    if (name.isEmpty()) {
+        name = QThread::isMainThread() ? QStringLiteral("Main thread") : QStringLiteral("Worker thread");
+    }
+    trace.buffers.emplace_back(trace.nextThreadId++, name);
+    return &trace.buffers.back();
+}
+}
+
+void Private::record(const Event &event)
+{
+    thread_local ThreadBuffer *buffer = registerThread();
+    buffer->append(event);
+}
+
+void start(const QString &filePath)
+{
+    TraceState &trace = state();
+    trace.filePath = filePath;
+    trace.clock.start();
+    Private::enabled = true;
+    qCDebug(KEEPSECRET_LOG) << "Tracing to" << filePath;
+}
+
+qint64 now()
+{
+    return state().clock.nsecsElapsed();
+}
+
+const char *intern(const QString &name)
+{
+    TraceState &trace = state();
+    QMutexLocker locker(&trace.mutex);
+    auto it = trace.names.insert(name.toUtf8());
+    // The data of the byte array stays in place when the set grows
+    return it->constData();
+}
+
+void finish()
+{
+    if (!isEnabled()) {
+        return;
+    }
+    Private::enabled = false;
+
+    TraceState &trace = state();
+    QMutexLocker locker(&trace.mutex);
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    // Timestamps are in microseconds
+    const auto micros = [](qint64 nsecs) {
+        return nsecs / 1000.0;
+    };
+
+    QJsonArray events;
+    for (const ThreadBuffer &buffer : trace.buffers) {
+        events.append(QJsonObject{
+            {QStringLiteral("name"), QStringLiteral("thread_name")},
+            {QStringLiteral("ph"), QStringLiteral("M")},
+            {QStringLiteral("pid"), pid},
+            {QStringLiteral("tid"), qint64(buffer.threadId)},
+            {QStringLiteral("args"), QJsonObject{{QStringLiteral("name"), buffer.threadName}}},
+        });
+
+        for (const Chunk *chunk = buffer.head.get(); chunk; chunk = chunk->next.load(std::memory_order_acquire)) {
+            const int count = chunk->count.load(std::memory_order_acquire);
+            for (int i = 0; i < count; ++i) {
+                const Private::Event &event = chunk->events[i];
+                QJsonObject object{
+                    {QStringLiteral("name"), QString::fromUtf8(event.name)},
+                    {QStringLiteral("cat"), QString::fromUtf8(event.category)},
+                    {QStringLiteral("ph"), QString(QLatin1Char(event.phase))},
+                    {QStringLiteral("ts"), micros(event.timestamp)},
+                    {QStringLiteral("pid"), pid},
+                    {QStringLiteral("tid"), qint64(buffer.threadId)},
+                };
+                if (event.phase == 'X') {
+                    object[QStringLiteral("dur")] = micros(event.duration);
+                } else if (event.phase == 'i') {
+                    object[QStringLiteral("s")] = QStringLiteral("t");
+                } else {
+                    object[QStringLiteral("id")] = QString::number(event.id);
+                }
+                events.append(object);
+            }
+        }
+    }
+
+    QSaveFile file(trace.filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(KEEPSECRET_LOG) << "Cannot write the trace to" << trace.filePath;
+        return;
+    }
+    const QJsonObject document{
+        {QStringLiteral("traceEvents"), events},
+        {QStringLiteral("displayTimeUnit"), QStringLiteral("ms")},
+    };
+    file.write(QJsonDocument(document).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qCWarning(KEEPSECRET_LOG) << "Cannot write the trace to" << trace.filePath;
+    }
+}
+}
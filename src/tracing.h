@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include <QString>
+#include <atomic>
+
+/**
+ * Timeline of what the application does, written as Chrome trace-event JSON
+ * which can be opened in Perfetto or chrome://tracing.
+ *
+ * Disabled unless start() is called, which happens with the --trace command
+ * line option or the KEEPSECRET_TRACE environment variable: when disabled,
+ * every call is an inlined check of a flag.
+ * Events are appended to a buffer of the calling thread without locking,
+ * and collected by finish(). Names and categories have to stay valid until
+ * then: use string literals, or intern() for anything else.
+ */
+namespace Tracing
+{
+namespace Private
+{
+extern std::atomic_bool enabled;
+
+struct Event {
+    const char *name;
+    const char *category;
+    // 'X' complete, 'i' instant, 'b' and 'e' async begin and end
+    char phase;
+    // Nanoseconds since start()
+    qint64 timestamp;
+    qint64 duration;
+    quint64 id;
+};
+
+void record(const Event &event);
+}
+
+// The trace is written to filePath by finish()
+void start(const QString &filePath);
+void finish();
+
+inline bool isEnabled()
+{
+    return Private::enabled.load(std::memory_order_relaxed);
+}
+
+// Nanoseconds since start()
+qint64 now();
+
+// A copy of the name which stays valid until the end of the program
+const char *intern(const QString &name);
+
+inline void instant(const char *name, const char *category)
+{
+    if (isEnabled()) {
+        Private::record({name, category, 'i', now(), 0, 0});
+    }
+}
+
+// Something which started at startTimestamp and ended now
+inline void complete(const char *name, const char *category, qint64 startTimestamp)
+{
+    if (isEnabled()) {
+        Private::record({name, category, 'X', startTimestamp, now() - startTimestamp, 0});
+    }
+}
+
+// For requests ending in a callback, the id pairs begin and end
+inline void asyncBegin(const char *name, const char *category, quint64 id)
+{
+    if (isEnabled()) {
+        Private::record({name, category, 'b', now(), 0, id});
+    }
+}
+
+inline void asyncEnd(const char *name, const char *category, quint64 id)
+{
+    if (isEnabled()) {
+        Private::record({name, category, 'e', now(), 0, id});
+    }
+}
+
+// A complete event lasting until the end of the scope
+class Scope
+{
+public:
+    Scope(const char *name, const char *category)
+        : m_name(name)
+        , m_category(category)
+        , m_start(isEnabled() ? now() : -1)
+    {
+    }
+    ~Scope()
+    {
+        if (m_start >= 0) {
+            complete(m_name, m_category, m_start);
+        }
+    }
+    Q_DISABLE_COPY_MOVE(Scope)
+
+private:
+    const char *m_name;
+    const char *m_category;
+    qint64 m_start;
+};
+}
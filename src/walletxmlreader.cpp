@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "walletxmlreader.h"
+
+static bool isElement(QStringView name, QStringView expected)
+{
+    return name.compare(expected, Qt::CaseInsensitive) == 0;
+}
+
+WalletXmlReader::WalletXmlReader(QIODevice *device, Format format)
+    : m_reader(device)
+    , m_format(format)
+{
+}
+
+bool WalletXmlReader::atEnd() const
+{
+    return m_atEnd;
+}
+
+QString WalletXmlReader::errorString() const
+{
+    return m_error;
+}
+
+bool WalletXmlReader::readRoot()
+{
+    if (!m_reader.readNextStartElement() || !isElement(m_reader.name(), u"wallet")) {
+        if (m_reader.hasError()) {
+            m_error = QStringLiteral("XML parse error: ") + m_reader.errorString();
+        } else if (m_format == KWallet) {
+            m_error = QStringLiteral("Not a valid KWallet XML file.");
+        } else {
+            m_error = QStringLiteral("Not a valid KeepSecret XML file.");
+        }
+        m_atEnd = true;
+        return false;
+    }
+
+    m_rootRead = true;
+    return true;
+}
+
+QVariantList WalletXmlReader::readItems(int maxItems)
+{
+    QVariantList items;
+
+    if (m_atEnd || (!m_rootRead && !readRoot())) {
+        return items;
+    }
+
+    while (items.count() < maxItems && !m_reader.atEnd()) {
+        const QXmlStreamReader::TokenType token = m_reader.readNext();
+
+        if (token == QXmlStreamReader::EndElement && m_format == KWallet && isElement(m_reader.name(), u"folder")) {
+            m_currentFolder.clear();
+            continue;
+        }
+        if (token != QXmlStreamReader::StartElement) {
+            continue;
+        }
+
+        const QStringView name = m_reader.name();
+        if (m_format == KeepSecret) {
+            if (isElement(name, u"item")) {
+                items.append(readKeepSecretItem());
+            }
+        } else if (isElement(name, u"folder")) {
+            m_currentFolder = m_reader.attributes().value(QStringLiteral("name")).toString();
+        } else if (isElement(name, u"password") || isElement(name, u"stream") || isElement(name, u"map")) {
+            items.append(readKWalletEntry(name.toString().toLower()));
+        }
+    }
+
+    if (m_reader.hasError()) {
+        m_error = QStringLiteral("XML parse error: ") + m_reader.errorString();
+        m_atEnd = true;
+    } else if (m_reader.atEnd()) {
+        m_atEnd = true;
+    }
+
+    return items;
+}
+
+QVariantMap WalletXmlReader::readKeepSecretItem()
+{
+    QVariantMap item;
+    const QXmlStreamAttributes itemAttributes = m_reader.attributes();
+    item[QStringLiteral("label")] = itemAttributes.value(QStringLiteral("label")).toString();
+    item[QStringLiteral("contentType")] = itemAttributes.value(QStringLiteral("contentType")).toString();
+    item[QStringLiteral("secret")] = QByteArray();
+
+    QVariantMap attributes;
+
+    while (m_reader.readNextStartElement()) {
+        if (isElement(m_reader.name(), u"secret")) {
+            // Secret as base64
+            item[QStringLiteral("secret")] = QByteArray::fromBase64(m_reader.readElementText().toLatin1());
+        } else if (isElement(m_reader.name(), u"attributes")) {
+            while (m_reader.readNextStartElement()) {
+                if (isElement(m_reader.name(), u"attribute")) {
+                    const QString name = m_reader.attributes().value(QStringLiteral("name")).toString();
+                    attributes[name] = m_reader.readElementText();
+                } else {
+                    m_reader.skipCurrentElement();
+                }
+            }
+        } else {
+            m_reader.skipCurrentElement();
+        }
+    }
+
+    item[QStringLiteral("attributes")] = attributes;
+    return item;
+}
+
+QVariantMap WalletXmlReader::readKWalletEntry(const QString &tag)
+{
+    QVariantMap item;
+    QVariantMap attributes;
+    attributes[QStringLiteral("server")] = m_currentFolder;
+    item[QStringLiteral("label")] = m_reader.attributes().value(QStringLiteral("name")).toString();
+
+    if (tag == QStringLiteral("password")) {
+        item[QStringLiteral("secret")] = m_reader.readElementText().toUtf8();
+        item[QStringLiteral("contentType")] = QStringLiteral("text/plain");
+    } else if (tag == QStringLiteral("stream")) {
+        item[QStringLiteral("secret")] = QByteArray::fromBase64(m_reader.readElementText().toLatin1());
+        item[QStringLiteral("contentType")] = QStringLiteral("application/octet-stream");
+    } else {
+        item[QStringLiteral("secret")] = QByteArray();
+        item[QStringLiteral("contentType")] = QStringLiteral("text/plain");
+        while (m_reader.readNextStartElement()) {
+            if (isElement(m_reader.name(), u"mapentry")) {
+                const QString name = m_reader.attributes().value(QStringLiteral("name")).toString();
+                attributes[name] = m_reader.readElementText();
+            } else {
+                m_reader.skipCurrentElement();
+            }
+        }
+    }
+
+    item[QStringLiteral("attributes")] = attributes;
+    return item;
+}
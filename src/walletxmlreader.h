@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "itemreader.h"
+
+#include <QXmlStreamReader>
+
+class QIODevice;
+
+/**
+ * Pull parser for the KeepSecret XML format (see WalletXmlWriter)
+ * and for the XML exported by KWalletManager.
+ * Items are read in chunks, so a whole file is never in memory at once.
+ */
+class WalletXmlReader : public ItemReader
+{
+public:
+    enum Format {
+        KeepSecret = 0,
+        KWallet
+    };
+
+    WalletXmlReader(QIODevice *device, Format format);
+
+    QVariantList readItems(int maxItems) override;
+    bool atEnd() const override;
+    QString errorString() const override;
+
+private:
+    bool readRoot();
+    QVariantMap readKeepSecretItem();
+    QVariantMap readKWalletEntry(const QString &tag);
+
+    QXmlStreamReader m_reader;
+    Format m_format;
+    QString m_currentFolder;
+    QString m_error;
+    bool m_rootRead = false;
+    bool m_atEnd = false;
+};
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "walletxmlwriter.h"
+
+WalletXmlWriter::WalletXmlWriter(QIODevice *device)
+    : m_writer(device)
+{
+    m_writer.setAutoFormatting(true);
+    m_writer.setAutoFormattingIndent(2);
+}
+
+void WalletXmlWriter::beginWallet(const QString &walletName)
+{
+    m_writer.writeStartElement(QStringLiteral("wallet"));
+    m_writer.writeAttribute(QStringLiteral("name"), walletName);
+}
+
+void WalletXmlWriter::writeItem(const QVariantMap &item)
+{
+    m_writer.writeStartElement(QStringLiteral("item"));
+    m_writer.writeAttribute(QStringLiteral("label"), item.value(QStringLiteral("label")).toString());
+    m_writer.writeAttribute(QStringLiteral("contentType"), item.value(QStringLiteral("contentType")).toString());
+
+    m_writer.writeTextElement(QStringLiteral("secret"), QString::fromLatin1(item.value(QStringLiteral("secret")).toByteArray().toBase64()));
+
+    m_writer.writeStartElement(QStringLiteral("attributes"));
+    const QVariantMap attributes = item.value(QStringLiteral("attributes")).toMap();
+    for (auto it = attributes.constBegin(); it != attributes.constEnd(); ++it) {
+        m_writer.writeStartElement(QStringLiteral("attribute"));
+        m_writer.writeAttribute(QStringLiteral("name"), it.key());
+        m_writer.writeCharacters(it.value().toString());
+        m_writer.writeEndElement();
+    }
+    m_writer.writeEndElement(); // attributes
+
+    m_writer.writeEndElement(); // item
+}
+
+void WalletXmlWriter::endWallet()
+{
+    m_writer.writeEndElement();
+}
+
+void WalletXmlWriter::finish()
+{
+    m_writer.writeEndDocument();
+}
+
+bool WalletXmlWriter::hasError() const
+{
+    return m_writer.hasError();
+}
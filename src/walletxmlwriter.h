@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#pragma once
+
+#include "itemwriter.h"
+
+#include <QXmlStreamWriter>
+
+class QIODevice;
+
+/**
+ * Writes wallets in the KeepSecret XML format one item at a time,
+ * without building a document of the whole wallet.
+ *
+ * <wallet name="...">
+ *   <item label="..." contentType="...">
+ *     <secret>base64 encoded secret</secret>
+ *     <attributes>
+ *       <attribute name="...">value</attribute>
+ *     </attributes>
+ *   </item>
+ * </wallet>
+ */
+class WalletXmlWriter : public ItemWriter
+{
+public:
+    explicit WalletXmlWriter(QIODevice *device);
+
+    void beginWallet(const QString &walletName) override;
+    void writeItem(const QVariantMap &item) override;
+    void endWallet() override;
+    void finish() override;
+
+    bool hasError() const override;
+
+private:
+    QXmlStreamWriter m_writer;
+};
@@ -0,0 +1,180 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "passwordgenerator.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QTest>
+
+#include <cmath>
+
+using namespace Qt::Literals::StringLiterals;
+
+static constexpr int s_batchSize = 100000;
+
+/**
+ * Checks that PasswordGenerator fills a large batch in well under a second,
+ * and that with a fixed seed its output is spread evenly over the allowed
+ * characters and words.
+ */
+class PasswordGeneratorTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testBatchTime();
+    void testEntropy_data();
+    void testEntropy();
+    void testCharacterDistribution();
+    void testMinimumAndExcluded();
+    void testWordDistribution();
+};
+
+void PasswordGeneratorTest::testBatchTime()
+{
+    // The defaults, as SecretItemProxy::generatePasswords() gets them from QML
+    PasswordGenerator generator(PasswordGenerator::Options::fromVariantMap({}));
+    QVERIFY(generator.isValid());
+
+    QElapsedTimer timer;
+    timer.start();
+    const QList<PasswordGenerator::Result> results = generator.generate(s_batchSize);
+    const qint64 elapsed = timer.elapsed();
+
+    QCOMPARE(results.count(), s_batchSize);
+    QCOMPARE(results.first().password.size(), 16);
+    QVERIFY2(elapsed < 1000, qPrintable(u"%1 passwords took %2 ms"_s.arg(s_batchSize).arg(elapsed)));
+}
+
+void PasswordGeneratorTest::testEntropy_data()
+{
+    QTest::addColumn<QVariantMap>("options");
+    QTest::addColumn<double>("entropy");
+
+    QTest::newRow("defaults") << QVariantMap() << 16 * std::log2(80.0);
+    QTest::newRow("digits") << QVariantMap{{u"lower"_s, false}, {u"upper"_s, false}, {u"symbols"_s, false}, {u"length"_s, 6}} << 6 * std::log2(10.0);
+    QTest::newRow("excluded") << QVariantMap{{u"upper"_s, false}, {u"digits"_s, false}, {u"symbols"_s, false}, {u"exclude"_s, u"lo"_s}}
+                              << 16 * std::log2(24.0);
+    QTest::newRow("minimum") << QVariantMap{{u"minDigits"_s, 2}} << 2 * std::log2(10.0) + 14 * std::log2(80.0);
+    QTest::newRow("words") << QVariantMap{{u"mode"_s, u"words"_s}, {u"length"_s, 4}, {u"wordList"_s, QStringList{u"a"_s, u"b"_s, u"a"_s, u"c"_s, u"d"_s}}}
+                           << 4 * std::log2(4.0);
+}
+
+void PasswordGeneratorTest::testEntropy()
+{
+    QFETCH(QVariantMap, options);
+    QFETCH(double, entropy);
+
+    PasswordGenerator generator(PasswordGenerator::Options::fromVariantMap(options));
+    QVERIFY(generator.isValid());
+    QVERIFY(qFuzzyCompare(generator.entropy(), entropy));
+}
+
+void PasswordGeneratorTest::testCharacterDistribution()
+{
+    QRandomGenerator random(42);
+    PasswordGenerator generator(PasswordGenerator::Options::fromVariantMap({}), &random);
+    QVERIFY(generator.isValid());
+
+    int counts[256] = {};
+    qint64 total = 0;
+    for (const PasswordGenerator::Result &result : generator.generate(s_batchSize)) {
+        for (char c : result.password) {
+            ++counts[uchar(c)];
+            ++total;
+        }
+    }
+
+    // Pearson's chi-squared against a uniform draw over the 80 characters
+    const QByteArray charset = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789!@#$%^&*()-_=+[]{}";
+    const double expected = double(total) / charset.size();
+    double chiSquared = 0;
+    qint64 inCharset = 0;
+    for (char c : charset) {
+        const double delta = counts[uchar(c)] - expected;
+        chiSquared += delta * delta / expected;
+        inCharset += counts[uchar(c)];
+    }
+    QCOMPARE(inCharset, total);
+
+    // 79 degrees of freedom: 124.8 is the critical value at p = 0.001
+    QVERIFY2(chiSquared < 124.8, qPrintable(u"chi-squared %1"_s.arg(chiSquared)));
+}
+
+void PasswordGeneratorTest::testMinimumAndExcluded()
+{
+    QRandomGenerator random(42);
+    PasswordGenerator generator(PasswordGenerator::Options::fromVariantMap({{u"length"_s, 8},
+                                                                            {u"minDigits"_s, 3},
+                                                                            {u"minSymbols"_s, 2},
+                                                                            {u"exclude"_s, u"lI1O0"_s}}),
+                                &random);
+    QVERIFY(generator.isValid());
+
+    const QByteArray excluded = "lI1O0";
+    const QByteArray symbolChars = "!@#$%^&*()-_=+[]{}";
+
+    // The required characters must not always land at the start
+    int digitsFirst = 0;
+    for (const PasswordGenerator::Result &result : generator.generate(s_batchSize / 10)) {
+        QCOMPARE(result.password.size(), 8);
+        int digits = 0;
+        int symbols = 0;
+        for (char c : result.password) {
+            QVERIFY(!excluded.contains(c));
+            if (c >= '0' && c <= '9') {
+                ++digits;
+            } else if (symbolChars.contains(c)) {
+                ++symbols;
+            }
+        }
+        QVERIFY(digits >= 3);
+        QVERIFY(symbols >= 2);
+        if (result.password.at(0) >= '0' && result.password.at(0) <= '9') {
+            ++digitsFirst;
+        }
+    }
+    QVERIFY(digitsFirst > 0);
+    QVERIFY(digitsFirst < s_batchSize / 10);
+}
+
+void PasswordGeneratorTest::testWordDistribution()
+{
+    const QStringList words = {u"alpha"_s, u"bravo"_s, u"charlie"_s, u"delta"_s, u"echo"_s, u"foxtrot"_s, u"golf"_s};
+
+    QRandomGenerator random(42);
+    PasswordGenerator generator(PasswordGenerator::Options::fromVariantMap({{u"mode"_s, u"words"_s},
+                                                                            {u"length"_s, 5},
+                                                                            {u"separator"_s, u" "_s},
+                                                                            {u"wordList"_s, words}}),
+                                &random);
+    QVERIFY(generator.isValid());
+
+    QHash<QByteArray, int> counts;
+    qint64 total = 0;
+    for (const PasswordGenerator::Result &result : generator.generate(s_batchSize)) {
+        const QList<QByteArray> passphrase = result.password.split(' ');
+        QCOMPARE(passphrase.count(), 5);
+        for (const QByteArray &word : passphrase) {
+            ++counts[word];
+            ++total;
+        }
+    }
+    QCOMPARE(counts.count(), words.count());
+
+    const double expected = double(total) / words.count();
+    double chiSquared = 0;
+    for (int count : std::as_const(counts)) {
+        const double delta = count - expected;
+        chiSquared += delta * delta / expected;
+    }
+
+    // 6 degrees of freedom: 22.46 is the critical value at p = 0.001
+    QVERIFY2(chiSquared < 22.46, qPrintable(u"chi-squared %1"_s.arg(chiSquared)));
+}
+
+QTEST_GUILESS_MAIN(PasswordGeneratorTest)
+
+#include "passwordgeneratortest.moc"
@@ -0,0 +1,152 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+// SPDX-FileCopyrightText: 2026 agent <agent@local>
+
+#include "benchmark.h"
+#include "fakesecretservice.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QTest>
+#include <memory>
+
+using namespace Qt::Literals::StringLiterals;
+
+static constexpr int s_smallCollection = 100;
+static constexpr int s_largeCollection = 1000;
+
+/**
+ * Runs the steps of keepsecret-bench against a FakeSecretService, with a
+ * small and a large collection, and checks how their cost grows with the
+ * number of items. The provider registers on the session bus, so this must
+ * run on a private one, as ctest does with dbus-run-session.
+ */
+class ScalingTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testProviderCallsPerItem_data();
+    void testProviderCallsPerItem();
+    void testCollectionLoadIsBatched();
+    void testExternalDelete();
+    void testLimits();
+
+private:
+    // Of the step with the given collection size, -1 if it wasn't measured
+    qreal metric(const QString &step, int items, const QString &name) const;
+
+    FakeSecretService m_provider;
+    std::unique_ptr<Benchmark> m_benchmark;
+    QJsonArray m_steps;
+};
+
+void ScalingTest::initTestCase()
+{
+    // Don't touch the configuration and state of the user
+    QStandardPaths::setTestModeEnabled(true);
+
+    QVERIFY2(!qEnvironmentVariableIsEmpty("DBUS_SESSION_BUS_ADDRESS"), "Needs a private session bus, run it with dbus-run-session");
+    QVERIFY2(m_provider.start(), qPrintable(m_provider.errorString()));
+
+    Benchmark::Options options;
+    options.collectionSizes = {s_smallCollection, s_largeCollection};
+    options.repeat = 1;
+    options.timeout = std::chrono::minutes(2);
+    options.providerCalls = [this]() {
+        return m_provider.callCount();
+    };
+    m_benchmark = std::make_unique<Benchmark>(options);
+    QVERIFY2(m_benchmark->run(), qPrintable(m_benchmark->errorString()));
+
+    m_steps = m_benchmark->results().value(u"steps"_s).toArray();
+}
+
+void ScalingTest::cleanupTestCase()
+{
+    // Disconnects the client before the provider goes away
+    m_benchmark.reset();
+    m_provider.stop();
+}
+
+void ScalingTest::testProviderCallsPerItem_data()
+{
+    QTest::addColumn<QString>("step");
+
+    QTest::newRow("bulk create") << u"bulk_create"_s;
+    QTest::newRow("collection load") << u"collection_load"_s;
+    QTest::newRow("bulk delete") << u"bulk_delete"_s;
+    QTest::newRow("import") << u"import"_s;
+}
+
+void ScalingTest::testProviderCallsPerItem()
+{
+    QFETCH(QString, step);
+
+    const qreal small = metric(step, s_smallCollection, u"provider_calls_per_item"_s);
+    const qreal large = metric(step, s_largeCollection, u"provider_calls_per_item"_s);
+    QVERIFY(small >= 0);
+    QVERIFY(large >= 0);
+
+    // A fixed cost for each item at most, never one growing with the collection
+    QVERIFY2(large <= small + 0.01,
+             qPrintable(u"%1 calls per item with %2 items, %3 with %4"_s.arg(small).arg(s_smallCollection).arg(large).arg(s_largeCollection)));
+}
+
+void ScalingTest::testCollectionLoadIsBatched()
+{
+    const qreal small = metric(u"collection_load"_s, s_smallCollection, u"provider_calls_per_item"_s);
+    const qreal large = metric(u"collection_load"_s, s_largeCollection, u"provider_calls_per_item"_s);
+    QVERIFY(small >= 0);
+    QVERIFY(large >= 0);
+
+    // The secrets come with a single request, whatever the number of items
+    const qreal smallCalls = small * s_smallCollection;
+    const qreal largeCalls = large * s_largeCollection;
+    QVERIFY2(largeCalls <= smallCalls * 2, qPrintable(u"%1 calls with %2 items, %3 with %4"_s.arg(smallCalls).arg(s_smallCollection).arg(largeCalls).arg(s_largeCollection)));
+}
+
+void ScalingTest::testExternalDelete()
+{
+    const qreal resets = metric(u"external_delete"_s, s_largeCollection, u"resets"_s);
+    const qreal smallRowsChanged = metric(u"external_delete"_s, s_smallCollection, u"rows_changed"_s);
+    const qreal largeRowsChanged = metric(u"external_delete"_s, s_largeCollection, u"rows_changed"_s);
+    QVERIFY(resets >= 0);
+    QVERIFY(smallRowsChanged >= 0);
+    QVERIFY(largeRowsChanged >= 0);
+
+    // One item gone is one row removed, the model is never reset
+    QCOMPARE(resets, 0);
+    QCOMPARE_LE(largeRowsChanged, smallRowsChanged);
+}
+
+void ScalingTest::testLimits()
+{
+    QFile file(QStringLiteral(KEEPSECRET_BENCH_LIMITS));
+    QVERIFY2(file.open(QIODevice::ReadOnly), qPrintable(file.errorString()));
+    QJsonParseError parseError;
+    const QJsonObject limits = QJsonDocument::fromJson(file.readAll(), &parseError).object();
+    QCOMPARE(parseError.error, QJsonParseError::NoError);
+
+    // The same limits as keepsecret-bench --limits
+    const QStringList failures = m_benchmark->checkLimits(limits);
+    QVERIFY2(failures.isEmpty(), qPrintable(failures.join(u'\n')));
+}
+
+qreal ScalingTest::metric(const QString &step, int items, const QString &name) const
+{
+    for (const QJsonValue &value : m_steps) {
+        const QJsonObject result = value.toObject();
+        if (result.value(u"step"_s).toString() == step && result.value(u"items"_s).toInt() == items) {
+            return result.value(u"metrics"_s).toObject().value(name).toDouble(-1);
+        }
+    }
+    return -1;
+}
+
+QTEST_MAIN(ScalingTest)
+
+#include "scalingtest.moc"